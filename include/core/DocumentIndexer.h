@@ -7,27 +7,47 @@
 #include <unordered_map>
 #include <fstream>
 #include <memory>
+#include <cstdint>
 #include "Tokenizer.h"
 #include "StopWordRemover.h"
+#include "Stemmer.h"
+#include "InvertedIndex.h"
+#include "ScratchArena.h"
+#include "DocumentStore.h"
+#include "DocumentReorderer.h"
+#include "DuplicateDetector.h"
 
 /**
  * @brief Represents a document with its content and metadata.
  */
 struct Document {
+    uint32_t docId;       // position in the indexer's document list
     std::string filePath;
     std::string fileName;
-    std::vector<std::string> tokens;
     std::unordered_map<std::string, int> termFrequency; // term -> count
+    std::vector<TokenSpan> tokenSpans; // byte range of each token position (positional indexing of
+                                       // documents up to TokenSpan::MaxTextSize bytes only)
     int totalTerms;
+    uint64_t textSize;    // bytes of the original text
     
-    Document() : totalTerms(0) {}
+    Document() : docId(0), totalTerms(0), textSize(0) {}
 };
 
 /**
  * @brief Indexes documents by tokenizing and counting term frequencies.
  * 
  * This class is responsible for reading text files, tokenizing their content,
- * removing stop words, and building an index of term frequencies per document.
+ * removing stop words, optionally stemming, and building an index of term
+ * frequencies per document.
+ * The file content, tokens and grouping tables needed while a document is
+ * indexed live in a scratch arena that is released after each document, so
+ * only the data kept in the index touches the heap.
+ *
+ * Batches go through a pipeline: a FileLoader keeps many reads in flight,
+ * worker threads tokenize the files as their reads complete, and the
+ * calling thread adds the documents to the index in the order given, so
+ * docIds do not depend on timing. A fixed pool of buffers and arenas bounds
+ * the memory of files read but not yet indexed.
  */
 class DocumentIndexer {
 public:
@@ -47,6 +67,9 @@ public:
     /**
      * @brief Indexes multiple documents from file paths.
      * 
+     * Files are read and tokenized concurrently; documents get docIds in
+     * the order of filePaths.
+     * 
      * @param filePaths Vector of file paths to index
      * @return Number of successfully indexed documents
      */
@@ -79,26 +102,187 @@ public:
      */
     std::shared_ptr<Document> getDocument(const std::string& filePath) const;
 
+    /**
+     * @brief Gets the inverted index built from the indexed documents.
+     * 
+     * @return Reference to the inverted index
+     */
+    const InvertedIndex& getInvertedIndex() const;
+
+    /**
+     * @brief Reads part of an indexed document's original text.
+     * 
+     * Only the requested bytes are read, so callers holding stored token
+     * offsets never need to load or re-tokenize the whole file. Documents
+     * in the document store are read from there, others from their file.
+     * 
+     * @param document The document
+     * @param offset Byte offset into the document text
+     * @param length Number of bytes to read
+     * @return The text read, empty if the document cannot be read
+     */
+    std::string readDocumentText(const Document& document, size_t offset, size_t length) const;
+
+    /**
+     * @brief Renumbers all documents so similar documents get neighbouring docIds.
+     * 
+     * Posting lists, the document list and the document store are remapped;
+     * docIds handed out earlier become invalid.
+     * 
+     * @param order Ordering method
+     * @param staticRanks Rank per docId, used by DocumentOrder::StaticRank
+     */
+    void reorderDocuments(DocumentOrder order, const std::vector<double>& staticRanks = std::vector<double>());
+
+    /**
+     * @brief Enables or disables recording term positions in the postings.
+     * 
+     * Positions are required for exact phrase and proximity queries. The
+     * setting applies to documents indexed afterwards. Enabled by default.
+     * 
+     * @param enabled True to record positions
+     */
+    void setPositionalIndexing(bool enabled);
+
+    /**
+     * @brief Checks whether term positions are recorded.
+     * 
+     * @return True if positional indexing is enabled
+     */
+    bool isPositionalIndexing() const;
+
+    /**
+     * @brief Enables or disables stemming of document terms.
+     * 
+     * Queries must be stemmed the same way (see getStemmer()). The setting
+     * applies to documents indexed afterwards, so change it before indexing.
+     * Disabled by default.
+     * 
+     * @param enabled True to index word stems instead of words
+     */
+    void setStemming(bool enabled);
+
+    /**
+     * @brief Gets the stemmer applied to document terms.
+     * 
+     * @return The stemmer, nullptr if stemming is disabled
+     */
+    const Stemmer* getStemmer() const;
+
+    /**
+     * @brief Keeps a compressed copy of the text of documents indexed afterwards.
+     * 
+     * The copy lets readDocumentText() work without the original files.
+     * Opening a store discards the contents of any previous one.
+     * 
+     * @param path Store file to create, or empty to stop storing and close the store
+     * @return False if the store file cannot be created
+     */
+    bool setDocumentStore(const std::string& path);
+
+    /**
+     * @brief Checks whether a document's text is in the document store.
+     * 
+     * @param docId Document identifier
+     * @return True if the document was stored
+     */
+    bool isDocumentStored(uint32_t docId) const;
+
+    /**
+     * @brief Gets the near-duplicate clusters of the indexed documents.
+     * 
+     * @return Reference to the duplicate detector
+     */
+    const DuplicateDetector& getDuplicateDetector() const;
+
+    /**
+     * @brief Sets the similarity from which documents count as near-duplicates.
+     * 
+     * Applies to documents indexed afterwards.
+     * 
+     * @param similarity Minimum estimated Jaccard similarity of the documents' terms (0.75 by default)
+     */
+    void setDuplicateThreshold(double similarity);
+
+    /**
+     * @brief Enables or disables postings for near-duplicate documents.
+     * 
+     * When disabled, a document found to be a near-duplicate of one indexed
+     * earlier is kept in the document list and its cluster but adds nothing
+     * to the inverted index, so searches find it only through the first
+     * document of its cluster. Terms it does not share with that document
+     * are then not searchable. Applies to documents indexed afterwards.
+     * Enabled by default.
+     * 
+     * @param enabled True to index near-duplicates like any other document
+     */
+    void setIndexingDuplicates(bool enabled);
+
+    /**
+     * @brief Sets the number of threads tokenizing files in indexDocuments().
+     * 
+     * @param threads Number of threads, 0 for one per processor
+     */
+    void setIngestionThreads(size_t threads);
+
+    /**
+     * @brief Sets how many file reads indexDocuments() keeps in flight.
+     * 
+     * @param depth Queue depth (minimum 1)
+     */
+    void setReadQueueDepth(size_t depth);
+
 private:
+    struct ParsedDocument;
+    struct IngestionSlot;
+
     std::vector<std::shared_ptr<Document>> documents;
     std::unique_ptr<Tokenizer> tokenizer;
     std::unique_ptr<StopWordRemover> stopWordRemover;
+    std::unique_ptr<Stemmer> stemmer;
+    InvertedIndex invertedIndex;
+    bool positionalIndexing;
+    bool stemming;
+    ScratchArena scratch; // per-document indexing data of indexDocument()
+    DocumentStore documentStore;
+    bool storingText; // documentStore is open
+    DuplicateDetector duplicateDetector;
+    bool indexingDuplicates;
+    size_t ingestionThreads;
+    size_t readQueueDepth;
+    
+    /**
+     * @brief Tokenizes a document's content. Safe to call from several threads.
+     * 
+     * @param filePath Path the content was read from
+     * @param content The file content
+     * @param parsed Receives the document and its terms, allocated from parsed's arena
+     */
+    void parseDocument(const std::string& filePath, std::string_view content, ParsedDocument& parsed) const;
+    
+    /**
+     * @brief Assigns the next docId to a parsed document and adds it to the index.
+     * 
+     * @param parsed The parsed document
+     */
+    void commitDocument(ParsedDocument& parsed);
     
     /**
      * @brief Reads the content of a file.
      * 
      * @param filePath Path to the file
-     * @return File content as string, empty if read fails
+     * @param content Receives the file content
+     * @return False if the file cannot be read
      */
-    std::string readFile(const std::string& filePath) const;
+    bool readFile(const std::string& filePath, std::pmr::string& content) const;
     
     /**
      * @brief Processes tokens and builds term frequency map for a document.
      * 
-     * @param tokens Vector of tokens
+     * @param terms Document terms
      * @return Term frequency map
      */
-    std::unordered_map<std::string, int> buildTermFrequency(const std::vector<std::string>& tokens) const;
+    std::unordered_map<std::string, int> buildTermFrequency(const std::pmr::vector<std::string_view>& terms) const;
 };
 
 #endif // DOCUMENTINDEXER_H
@@ -0,0 +1,96 @@
+#ifndef DOCUMENTREORDERER_H
+#define DOCUMENTREORDERER_H
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+class InvertedIndex;
+struct Document;
+
+/**
+ * @brief How documents are renumbered by DocumentReorderer.
+ */
+enum class DocumentOrder {
+    FilePath,       // sorted by file path, so files of the same directory are adjacent
+    GraphBisection, // recursive graph bisection over shared terms, starting from FilePath
+    StaticRank      // by descending static rank, graph bisection within each rank tier
+};
+
+/**
+ * @brief Computes docId assignments that place similar documents next to each other.
+ *
+ * Graph bisection (Dhulipala et al., "Compressing Graphs and Indexes with
+ * Recursive Graph Bisection") splits the documents in two halves and swaps
+ * documents between them while that lowers the estimated cost of the
+ * posting gaps, i.e. while it concentrates each term's documents on one
+ * side; then it recurses into both halves. Postings of related documents
+ * end up clustered, so gaps get smaller and scoring touches fewer cache
+ * lines of the per-document arrays.
+ *
+ * Static-rank ordering gives the lowest docIds to the documents with the
+ * highest query-independent rank, so a search stopped early by its budget
+ * has already scored the documents likeliest to rank well. Bisection then
+ * only moves documents within tiers of similar rank.
+ */
+class DocumentReorderer {
+public:
+    /**
+     * @brief Constructor.
+     *
+     * @param iterations Maximum swap rounds per bisection
+     * @param leafSize Partitions of at most this many documents are not split further
+     */
+    explicit DocumentReorderer(size_t iterations = 20, size_t leafSize = 16);
+
+    /**
+     * @brief Computes the new docId of every document.
+     *
+     * @param index Inverted index over the documents
+     * @param documents Documents in current docId order
+     * @param order Ordering method
+     * @param staticRanks Rank per current docId for DocumentOrder::StaticRank (missing ranks count as 0)
+     * @return New docId per current docId (a permutation)
+     */
+    std::vector<uint32_t> computeOrder(const InvertedIndex& index,
+                                       const std::vector<std::shared_ptr<Document>>& documents,
+                                       DocumentOrder order,
+                                       const std::vector<double>& staticRanks = std::vector<double>()) const;
+
+private:
+    /**
+     * @brief Terms of each document as compact term numbers (CSR layout).
+     */
+    struct ForwardIndex {
+        std::vector<uint32_t> starts; // documents + 1 entries
+        std::vector<uint32_t> terms;
+        size_t termCount = 0;
+    };
+
+    size_t iterations;
+    size_t leafSize;
+
+    /**
+     * @brief Builds the forward index of the terms worth bisecting on.
+     *
+     * @param index Inverted index over the documents
+     * @param count Number of documents
+     * @return Terms per document
+     */
+    static ForwardIndex buildForwardIndex(const InvertedIndex& index, size_t count);
+
+    /**
+     * @brief Bisects documents[begin, end) and recurses into both halves.
+     *
+     * @param forward Terms per document
+     * @param documents Current docIds in their new order, permuted in place
+     * @param begin First position of the partition
+     * @param end One past the last position
+     * @param depth Recursion depth, used to fork the top levels onto threads
+     */
+    void bisect(const ForwardIndex& forward, std::vector<uint32_t>& documents,
+                size_t begin, size_t end, size_t depth) const;
+};
+
+#endif // DOCUMENTREORDERER_H
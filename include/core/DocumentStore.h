@@ -0,0 +1,156 @@
+#ifndef DOCUMENTSTORE_H
+#define DOCUMENTSTORE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include <mutex>
+#include <memory_resource>
+#include <cstdint>
+
+/**
+ * @brief Compressed copy of the indexed documents' text, readable by docId.
+ *
+ * Each document is cut into blocks of BlockSize bytes that are compressed
+ * independently with a small built-in LZ77 codec and appended to one store
+ * file. An in-memory block index maps a docId to its blocks, so reading a
+ * byte range decompresses only the blocks that overlap it. Previews and
+ * snippets read from here instead of the original files, which may have
+ * moved or live on slow storage.
+ *
+ * Compression (encode()) is independent of the store and may run on any
+ * thread; add() and the read functions lock internally.
+ */
+class DocumentStore {
+public:
+    /**
+     * @brief Uncompressed size of a block; the last block of a document may be shorter.
+     */
+    static constexpr size_t BlockSize = 16 * 1024;
+
+    /**
+     * @brief Constructor. The store is closed until open() succeeds.
+     */
+    DocumentStore();
+
+    DocumentStore(const DocumentStore&) = delete;
+    DocumentStore& operator=(const DocumentStore&) = delete;
+
+    /**
+     * @brief Creates an empty store file, replacing any existing one.
+     *
+     * @param path Path of the store file
+     * @return False if the file cannot be created
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief Closes the store file and forgets its documents.
+     */
+    void close();
+
+    /**
+     * @brief Checks whether a store file is open.
+     *
+     * @return True if documents can be added
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Compresses a document's text into the store's block format.
+     *
+     * @param text The document text
+     * @param encoded Receives the compressed blocks (replaced)
+     */
+    static void encode(std::string_view text, std::pmr::string& encoded);
+
+    /**
+     * @brief Appends an encoded document to the store.
+     *
+     * @param docId Document identifier
+     * @param encoded Output of encode()
+     * @return False if the store is closed, the data is malformed or the write fails
+     */
+    bool add(uint32_t docId, std::string_view encoded);
+
+    /**
+     * @brief Renumbers the stored documents.
+     *
+     * @param newIds New docId per current docId
+     */
+    void remapDocuments(const std::vector<uint32_t>& newIds);
+
+    /**
+     * @brief Checks whether a document's text is in the store.
+     *
+     * @param docId Document identifier
+     * @return True if the document was added
+     */
+    bool contains(uint32_t docId) const;
+
+    /**
+     * @brief Reads part of a stored document's text.
+     *
+     * @param docId Document identifier
+     * @param offset Byte offset into the document text
+     * @param length Number of bytes to read
+     * @param text Receives the bytes read (shorter at the end of the document)
+     * @return False if the document is not stored or cannot be decompressed
+     */
+    bool read(uint32_t docId, size_t offset, size_t length, std::string& text) const;
+
+    /**
+     * @brief Gets the number of bytes the store file takes.
+     *
+     * @return Compressed size of all stored documents, including block headers
+     */
+    uint64_t getStoredBytes() const;
+
+    /**
+     * @brief Removes all documents, keeping the store file open.
+     */
+    void clear();
+
+private:
+    /**
+     * @brief Location of one compressed block in the store file.
+     */
+    struct BlockEntry {
+        uint64_t fileOffset;
+        uint32_t storedSize;
+        uint32_t rawSize;
+        bool compressed;
+    };
+
+    /**
+     * @brief The blocks of one document.
+     */
+    struct DocumentEntry {
+        uint32_t firstBlock;
+        uint32_t blockCount;
+        uint64_t size;
+        bool stored;
+    };
+
+    mutable std::mutex mutex;
+    mutable std::fstream file;
+    std::string path;
+    uint64_t fileEnd;
+    std::vector<DocumentEntry> documents;
+    std::vector<BlockEntry> blocks;
+
+    // The last block decompressed, since previews read neighbouring ranges
+    mutable size_t cachedBlock;
+    mutable std::string cachedText;
+
+    /**
+     * @brief Reads and decompresses a block into the cache. Caller holds the mutex.
+     *
+     * @param block Index into blocks
+     * @return False if the block cannot be read or is corrupt
+     */
+    bool loadBlock(size_t block) const;
+};
+
+#endif // DOCUMENTSTORE_H
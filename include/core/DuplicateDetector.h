@@ -0,0 +1,168 @@
+#ifndef DUPLICATEDETECTOR_H
+#define DUPLICATEDETECTOR_H
+
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Groups near-duplicate documents into clusters as they are indexed.
+ *
+ * Each document gets a MinHash signature of its terms: SignatureSize
+ * independent hash functions, each keeping its minimum over the document's
+ * terms, so two signatures agree in a position with probability equal to
+ * the Jaccard similarity of the documents. Terms are weighted by their log
+ * frequency (a term seen tf times contributes 1 + log2(tf) elements).
+ *
+ * Locality-sensitive hashing finds the candidates: the signature is cut
+ * into BandCount bands, and documents sharing any whole band land in the
+ * same bucket. Only those candidates are compared, so adding a document
+ * costs about the same however many documents are indexed. A document
+ * whose estimated similarity to a candidate reaches the threshold joins
+ * that candidate's cluster; otherwise it starts its own.
+ */
+class DuplicateDetector {
+public:
+    static constexpr size_t SignatureSize = 64;
+    static constexpr size_t BandCount = 16;
+
+    using Signature = std::array<uint32_t, SignatureSize>;
+
+    /**
+     * @brief Constructor.
+     *
+     * @param threshold Minimum estimated Jaccard similarity of near-duplicates
+     */
+    explicit DuplicateDetector(double threshold = 0.75);
+
+    /**
+     * @brief Computes the MinHash signature of a document.
+     *
+     * Safe to call from several threads.
+     *
+     * @param termFrequency The document's term counts
+     * @param signature Receives the signature
+     */
+    static void computeSignature(const std::unordered_map<std::string, int>& termFrequency, Signature& signature);
+
+    /**
+     * @brief Adds a document and assigns it to a cluster.
+     *
+     * Documents without terms are never duplicates of anything.
+     *
+     * @param docId Document identifier
+     * @param signature The document's signature
+     * @return The cluster: docId if the document is not a near-duplicate of an earlier one
+     */
+    uint32_t add(uint32_t docId, const Signature& signature);
+
+    /**
+     * @brief Gets the cluster of a document.
+     *
+     * @param docId Document identifier
+     * @return Identifier of the cluster (one of its documents), docId for unknown documents
+     */
+    uint32_t getCluster(uint32_t docId) const;
+
+    /**
+     * @brief Gets the number of documents in a document's cluster.
+     *
+     * @param docId Document identifier
+     * @return Cluster size, 1 for documents without near-duplicates
+     */
+    size_t getClusterSize(uint32_t docId) const;
+
+    /**
+     * @brief Gets the number of documents that joined an existing cluster.
+     *
+     * @return Number of near-duplicates found
+     */
+    size_t getDuplicateCount() const;
+
+    /**
+     * @brief Sets the similarity from which documents count as near-duplicates.
+     *
+     * Applies to documents added afterwards.
+     *
+     * @param similarity Minimum estimated Jaccard similarity (0 - 1)
+     */
+    void setThreshold(double similarity);
+
+    /**
+     * @brief Gets the similarity from which documents count as near-duplicates.
+     *
+     * @return Minimum estimated Jaccard similarity
+     */
+    double getThreshold() const;
+
+    /**
+     * @brief Renumbers the documents.
+     *
+     * @param newIds New docId per current docId
+     */
+    void remapDocuments(const std::vector<uint32_t>& newIds);
+
+    /**
+     * @brief Forgets all documents.
+     */
+    void clear();
+
+private:
+    static constexpr size_t RowsPerBand = SignatureSize / BandCount;
+
+    /**
+     * @brief Slot of the open-addressing bucket table.
+     */
+    struct Bucket {
+        uint32_t key;
+        uint32_t head; // 1 + index of the bucket's latest entry, 0 for an empty slot
+    };
+
+    double threshold;
+    size_t duplicates;
+
+    std::vector<uint32_t> signatures;   // SignatureSize per docId, to verify candidates
+    std::vector<Bucket> table;          // band keys of all bands, power-of-two size
+    size_t usedBuckets;
+    std::vector<uint32_t> chains;       // per (docId, band) entry: 1 + previous entry in its bucket, or 0
+    std::vector<uint32_t> clusters;     // cluster per docId
+    std::vector<uint32_t> clusterSizes; // per cluster identifier
+
+    /**
+     * @brief Hashes one band of a signature.
+     *
+     * @param signature Signature values
+     * @param band Band index
+     * @return Bucket key of the band
+     */
+    static uint32_t bandKey(const uint32_t* signature, size_t band);
+
+    /**
+     * @brief Finds the slot of a key, or the empty slot where it belongs.
+     *
+     * @param key Bucket key
+     * @return Index into table
+     */
+    size_t findBucket(uint32_t key) const;
+
+    /**
+     * @brief Adds a document's bands to their buckets.
+     *
+     * @param docId Document identifier with its signature stored
+     */
+    void insertBands(uint32_t docId);
+
+    /**
+     * @brief Estimates the similarity of a signature to an added document's.
+     *
+     * @param signature Signature of the new document
+     * @param docId An added document
+     * @return Fraction of matching signature positions
+     */
+    double estimateSimilarity(const Signature& signature, uint32_t docId) const;
+};
+
+#endif // DUPLICATEDETECTOR_H
@@ -0,0 +1,90 @@
+#ifndef FILELOADER_H
+#define FILELOADER_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstddef>
+
+/**
+ * @brief Reads many files concurrently, keeping a fixed number of reads in flight.
+ *
+ * On Linux the reads are submitted through io_uring, driven directly with
+ * the io_uring_setup/io_uring_enter system calls, so one thread keeps the
+ * whole queue depth busy. Where io_uring is unavailable (other systems,
+ * old kernels, or blocked by a sandbox) a pool of threads performing
+ * blocking reads takes its place.
+ *
+ * Memory is bounded by the caller: every read needs a buffer from the
+ * BufferProvider, and files are started in index order only as buffers
+ * become available.
+ */
+class FileLoader {
+public:
+    enum class Backend {
+        IoUring,
+        Threads
+    };
+
+    /**
+     * @brief Gets the buffer a file is read into.
+     *
+     * Called in index order. With wait false it may return nullptr when no
+     * buffer is free; with wait true it must block until one is.
+     */
+    using BufferProvider = std::function<std::string*(size_t index, bool wait)>;
+
+    /**
+     * @brief Reports a finished read, in completion order, from the loader's threads.
+     *
+     * @param index Index of the file
+     * @param ok False if the file could not be read
+     */
+    using CompletionHandler = std::function<void(size_t index, bool ok)>;
+
+    /**
+     * @brief Constructor.
+     *
+     * @param queueDepth Maximum number of reads in flight (at least 1)
+     * @param backend Preferred backend; io_uring falls back to threads when unavailable
+     */
+    explicit FileLoader(size_t queueDepth = 32, Backend backend = Backend::IoUring);
+
+    /**
+     * @brief Reads files, returning once every read has completed.
+     *
+     * @param filePaths Files to read
+     * @param acquire Provides the buffer of each file
+     * @param complete Called once per file
+     * @return The backend that performed the reads
+     */
+    Backend load(const std::vector<std::string>& filePaths, const BufferProvider& acquire,
+                 const CompletionHandler& complete) const;
+
+    /**
+     * @brief Gets the maximum number of reads in flight.
+     *
+     * @return Queue depth
+     */
+    size_t getQueueDepth() const;
+
+private:
+    size_t queueDepth;
+    Backend backend;
+
+    /**
+     * @brief Reads through io_uring.
+     *
+     * @return False, before reading anything, if io_uring cannot be used
+     */
+    bool loadWithIoUring(const std::vector<std::string>& filePaths, const BufferProvider& acquire,
+                         const CompletionHandler& complete) const;
+
+    /**
+     * @brief Reads with blocking reads on a pool of threads.
+     */
+    void loadWithThreads(const std::vector<std::string>& filePaths, const BufferProvider& acquire,
+                         const CompletionHandler& complete) const;
+};
+
+#endif // FILELOADER_H
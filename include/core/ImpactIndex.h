@@ -0,0 +1,91 @@
+#ifndef IMPACTINDEX_H
+#define IMPACTINDEX_H
+
+#include "InvertedIndex.h"
+#include "Scorer.h"
+#include "SearchBudget.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+/**
+ * @brief Impact-ordered copy of the inverted index for score-at-a-time ranking.
+ *
+ * Every posting's score contribution is computed once at build time and
+ * quantized to an 8-bit impact (1-255, relative to the largest contribution
+ * in the index). Each term's postings are grouped into segments of equal
+ * impact, highest impact first, with docIds ascending inside a segment.
+ *
+ * A query then processes the segments of all its terms in decreasing impact
+ * order, adding small integers into per-document accumulators, and stops as
+ * soon as the remaining segments can no longer change which documents are in
+ * the top K. The few top documents are then completed from the skipped
+ * segments so their order is exact too.
+ */
+class ImpactIndex {
+public:
+    ImpactIndex();
+
+    /**
+     * @brief Rebuilds the impact index from the postings.
+     *
+     * @param index The inverted index
+     * @param scorer Scorer providing each posting's contribution
+     */
+    void build(const InvertedIndex& index, const Scorer& scorer);
+
+    /**
+     * @brief Finds the K best documents for a bag of terms.
+     *
+     * A document's score is the sum of its impacts for the terms (a term
+     * listed twice counts twice), scaled back to the scoring model's range.
+     * With a budget, segments are processed until the budget is spent;
+     * since the highest impacts come first, the documents found by then
+     * are the likeliest top K, and they are still completed as usual.
+     *
+     * @param terms Query terms
+     * @param k Number of documents wanted
+     * @param budget Work budget of the query, nullptr for none
+     * @return Up to k documents by descending score, then ascending docId
+     */
+    std::vector<ScoredDocument> topK(const std::vector<std::string>& terms, size_t k,
+                                     QueryBudget* budget = nullptr) const;
+
+    /**
+     * @brief Gets the model score one impact unit stands for.
+     *
+     * @return Score per impact unit
+     */
+    double getScale() const;
+
+    /**
+     * @brief Gets the memory used by the impact-ordered postings.
+     *
+     * @return Bytes used
+     */
+    size_t getMemoryUsage() const;
+
+    /**
+     * @brief Removes all postings.
+     */
+    void clear();
+
+private:
+    struct Segment {
+        uint8_t impact;
+        uint32_t begin; // range in ImpactList::docIds
+        uint32_t end;
+    };
+
+    struct ImpactList {
+        std::vector<Segment> segments; // by descending impact
+        std::vector<uint32_t> docIds;
+    };
+
+    std::unordered_map<std::string, ImpactList> lists;
+    double scale;
+    uint32_t documentCount;
+};
+
+#endif // IMPACTINDEX_H
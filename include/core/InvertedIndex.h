@@ -0,0 +1,116 @@
+#ifndef INVERTEDINDEX_H
+#define INVERTEDINDEX_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory_resource>
+#include <unordered_map>
+#include <cstdint>
+#include <mutex>
+#include "TermDictionary.h"
+
+/**
+ * @brief Postings of a single term, stored as parallel arrays sorted by docId.
+ *
+ * Positions are optional: for the i-th posting they occupy
+ * positions[positionStarts[i] .. positionStarts[i + 1]), and the range is
+ * empty when the document was indexed without positions.
+ */
+struct PostingList {
+    std::vector<uint32_t> docIds;         // ascending
+    std::vector<uint32_t> frequencies;    // term count per document
+    std::vector<uint32_t> positionStarts; // size() + 1 entries
+    std::vector<uint32_t> positions;      // token positions, ascending per document
+
+    PostingList() : positionStarts(1, 0) {}
+
+    size_t size() const { return docIds.size(); }
+
+    /**
+     * @brief Checks whether positions were recorded for a posting.
+     *
+     * @param index Posting index
+     * @return True if the posting has positions
+     */
+    bool hasPositions(size_t index) const {
+        return positionStarts[index + 1] > positionStarts[index];
+    }
+
+    const uint32_t* positionsBegin(size_t index) const {
+        return positions.data() + positionStarts[index];
+    }
+
+    const uint32_t* positionsEnd(size_t index) const {
+        return positions.data() + positionStarts[index + 1];
+    }
+};
+
+/**
+ * @brief Term -> posting list index built incrementally as documents are added.
+ *
+ * Documents must be added in increasing docId order so every posting list
+ * stays sorted without re-sorting. Exact lookups go through a hash map; a
+ * sorted TermDictionary for prefix, wildcard and range enumeration is
+ * rebuilt on first use after the index changed.
+ */
+class InvertedIndex {
+public:
+    InvertedIndex();
+
+    /**
+     * @brief Adds the postings of one document.
+     *
+     * Temporary grouping data is allocated from the terms' memory resource,
+     * so an arena backed caller keeps it off the heap.
+     *
+     * @param docId Document identifier, greater than any previously added
+     * @param terms Document terms in token order
+     * @param positions Token position of each term, or empty to skip positions
+     */
+    void addDocument(uint32_t docId, const std::pmr::vector<std::string_view>& terms,
+                     const std::pmr::vector<uint32_t>& positions);
+
+    /**
+     * @brief Renumbers the documents, re-sorting every posting list.
+     *
+     * @param newIds New docId per current docId
+     */
+    void remapDocuments(const std::vector<uint32_t>& newIds);
+
+    /**
+     * @brief Gets the posting list of a term.
+     *
+     * @param term The term
+     * @return Pointer to the posting list, nullptr if the term is not indexed
+     */
+    const PostingList* getPostings(const std::string& term) const;
+
+    /**
+     * @brief Gets the number of distinct terms.
+     *
+     * @return Number of terms
+     */
+    size_t getTermCount() const;
+
+    /**
+     * @brief Gets the sorted dictionary of all indexed terms.
+     *
+     * @return Reference to the term dictionary, valid until the index changes
+     */
+    const TermDictionary& getTermDictionary() const;
+
+    /**
+     * @brief Removes all postings.
+     */
+    void clear();
+
+private:
+    std::unordered_map<std::string, PostingList> postings;
+
+    mutable TermDictionary termDictionary;
+    mutable bool dictionaryStale;
+    mutable std::mutex dictionaryMutex;
+};
+
+#endif // INVERTEDINDEX_H
@@ -0,0 +1,91 @@
+#ifndef LEVENSHTEINAUTOMATON_H
+#define LEVENSHTEINAUTOMATON_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief Automaton accepting every string within a bounded edit distance of a term.
+ *
+ * A state is one row of the Levenshtein dynamic-programming table with
+ * values capped at maxEdits + 1, so the number of distinct states is finite
+ * and a state can tell early that no continuation will ever be accepted.
+ * Feeding it a sorted term dictionary character by character therefore
+ * prunes whole prefix ranges instead of computing the distance to every term.
+ *
+ * Characters are Unicode code points decoded from UTF-8, so replacing "é"
+ * with "e" is one edit even though their encodings differ in length.
+ */
+class LevenshteinAutomaton {
+public:
+    using State = std::vector<uint8_t>;
+
+    /**
+     * @brief Constructor.
+     *
+     * @param term The UTF-8 term to match against
+     * @param maxEdits Maximum number of insertions, deletions and substitutions
+     */
+    LevenshteinAutomaton(const std::string& term, uint32_t maxEdits);
+
+    /**
+     * @brief Gets the state before any character was consumed.
+     *
+     * @return The start state
+     */
+    State start() const;
+
+    /**
+     * @brief Consumes one character.
+     *
+     * @param state Current state
+     * @param codePoint The character, as decoded by Tokenizer::decodeCharacter()
+     * @return The next state
+     */
+    State step(const State& state, uint32_t codePoint) const;
+
+    /**
+     * @brief Checks whether some continuation of the consumed input can still be accepted.
+     *
+     * @param state Current state
+     * @return False if the state is dead
+     */
+    bool canMatch(const State& state) const;
+
+    /**
+     * @brief Checks whether the consumed input is accepted.
+     *
+     * @param state Current state
+     * @return True if the input is within maxEdits of the term
+     */
+    bool isMatch(const State& state) const;
+
+    /**
+     * @brief Gets the edit distance between the consumed input and the term.
+     *
+     * @param state Current state
+     * @return The distance, or maxEdits + 1 if it is larger than maxEdits
+     */
+    uint32_t distance(const State& state) const;
+
+    /**
+     * @brief Gets the maximum number of edits.
+     *
+     * @return Maximum number of edits
+     */
+    uint32_t getMaxEdits() const;
+
+    /**
+     * @brief Gets the length of the term.
+     *
+     * @return Number of characters in the term
+     */
+    size_t getTermLength() const;
+
+private:
+    std::vector<uint32_t> term; // code points
+    uint32_t maxEdits;
+};
+
+#endif // LEVENSHTEINAUTOMATON_H
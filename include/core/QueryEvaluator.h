@@ -0,0 +1,153 @@
+#ifndef QUERYEVALUATOR_H
+#define QUERYEVALUATOR_H
+
+#include "InvertedIndex.h"
+#include "QueryParser.h"
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief Finds the documents matching a query tree using the inverted index.
+ *
+ * All intermediate results are sorted docId lists. Conjunctions start from
+ * the shortest list and gallop through the longer ones, exclusions gallop
+ * through the excluded lists, and disjunctions are merged with a heap, so
+ * restrictive queries only touch a small part of the long posting lists.
+ */
+class QueryEvaluator {
+public:
+    /**
+     * @brief Constructor.
+     *
+     * @param index Reference to the inverted index
+     */
+    explicit QueryEvaluator(const InvertedIndex& index);
+
+    /**
+     * @brief Finds the documents matching a query node.
+     *
+     * @param node The query node
+     * @return Matching docIds in ascending order
+     */
+    std::vector<uint32_t> match(const QueryNode& node) const;
+
+    /**
+     * @brief Replaces multi-term leaves with the dictionary terms they match.
+     *
+     * Each Wildcard or Fuzzy leaf becomes an OR of at most
+     * getMaxExpansions() Term leaves, found by enumerating the sorted term
+     * dictionary. Fuzzy expansions are boosted by 1 - edits / (length + 1),
+     * with the term's length in characters, so exact matches outrank
+     * corrections.
+     *
+     * @param node Root of the query tree, modified in place
+     */
+    void rewrite(QueryNode& node) const;
+
+    /**
+     * @brief Sets the maximum number of terms a single pattern may expand to.
+     *
+     * @param limit Maximum number of terms
+     */
+    void setMaxExpansions(size_t limit);
+
+    /**
+     * @brief Gets the maximum number of terms a single pattern may expand to.
+     *
+     * @return Maximum number of terms
+     */
+    size_t getMaxExpansions() const;
+
+    /**
+     * @brief Finds the documents matching a leaf node, optionally among candidates only.
+     *
+     * Documents indexed without positions cannot be checked for order or
+     * distance, so phrase and proximity leaves fall back to requiring all
+     * terms for them.
+     *
+     * @param leaf A Term, Phrase or Near node
+     * @param candidates Sorted docIds to restrict the result to, or nullptr
+     * @return Matching docIds in ascending order
+     */
+    std::vector<uint32_t> matchLeaf(const QueryNode& leaf, const std::vector<uint32_t>* candidates) const;
+
+    /**
+     * @brief Finds the first element not less than a target, searching forward from a position.
+     *
+     * Probes at exponentially growing distances before binary searching, so
+     * skipping far ahead in a long sorted list costs O(log distance).
+     *
+     * @param values Sorted values
+     * @param from Index to start from
+     * @param target Value to search for
+     * @return Index of the first element >= target, values.size() if none
+     */
+    static size_t gallop(const std::vector<uint32_t>& values, size_t from, uint32_t target);
+
+    /**
+     * @brief Intersects two sorted lists, galloping through the longer one.
+     *
+     * @param a Sorted docIds
+     * @param b Sorted docIds
+     * @return Sorted docIds present in both
+     */
+    static std::vector<uint32_t> intersect(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b);
+
+    /**
+     * @brief Removes the elements of one sorted list from another.
+     *
+     * @param a Sorted docIds to keep from
+     * @param b Sorted docIds to remove
+     * @return Sorted docIds of a that are not in b
+     */
+    static std::vector<uint32_t> difference(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b);
+
+    /**
+     * @brief Merges sorted lists into their sorted union.
+     *
+     * @param lists Sorted docId lists
+     * @return Sorted docIds present in any list, without duplicates
+     */
+    static std::vector<uint32_t> unite(const std::vector<const std::vector<uint32_t>*>& lists);
+
+private:
+    const InvertedIndex& index;
+    size_t maxExpansions;
+
+    /**
+     * @brief Evaluates a Boolean node.
+     *
+     * @param node The Boolean node
+     * @return Matching docIds in ascending order
+     */
+    std::vector<uint32_t> matchBoolean(const QueryNode& node) const;
+
+    /**
+     * @brief Checks whether the terms occur at their relative phrase offsets.
+     *
+     * @param lists Posting list of each phrase term
+     * @param postings Index of the document's posting in each list
+     * @param offsets Relative position of each term
+     * @return True if the phrase occurs in the document
+     */
+    static bool matchesPhrase(const std::vector<const PostingList*>& lists,
+                              const std::vector<size_t>& postings,
+                              const std::vector<uint32_t>& offsets);
+
+    /**
+     * @brief Checks whether one occurrence of every term fits in a window.
+     *
+     * A term given more than once needs that many distinct occurrences,
+     * so `error NEAR/1 error` only matches two adjacent occurrences.
+     *
+     * @param lists Posting list of each term
+     * @param postings Index of the document's posting in each list
+     * @param distance Maximum distance between the first and last term
+     * @return True if such a window exists
+     */
+    static bool matchesWithin(const std::vector<const PostingList*>& lists,
+                              const std::vector<size_t>& postings,
+                              uint32_t distance);
+};
+
+#endif // QUERYEVALUATOR_H
@@ -0,0 +1,136 @@
+#ifndef QUERYPARSER_H
+#define QUERYPARSER_H
+
+#include "Tokenizer.h"
+#include "StopWordRemover.h"
+#include "Stemmer.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief A node of a parsed query.
+ *
+ * Leaf nodes match documents directly: Term matches any document containing
+ * the term, Phrase matches the terms at the given relative positions, and Near
+ * matches all terms within a window of at most `distance` positions. Wildcard
+ * leaves hold a pattern in terms[0] and Fuzzy leaves a term in terms[0] with
+ * up to `distance` edits; both are rewritten into the matching dictionary
+ * terms (see QueryEvaluator::rewrite) before evaluation. A leaf's score is
+ * multiplied by its `boost`.
+ *
+ * Boolean nodes combine children by occurrence: every `must` child has to
+ * match, no `mustNot` child may match, and `should` children are optional
+ * when there is a `must` child, otherwise at least one of them has to match.
+ * Matching `should` children still add to the score.
+ */
+struct QueryNode {
+    enum class Type { Term, Phrase, Near, Wildcard, Fuzzy, Boolean };
+
+    Type type;
+    std::vector<std::string> terms;
+    std::vector<uint32_t> offsets; // Phrase: position of each term relative to the first
+    uint32_t distance;             // Near: maximum distance between terms, Fuzzy: maximum edits
+    double boost;                  // score multiplier
+
+    std::vector<QueryNode> must;
+    std::vector<QueryNode> should;
+    std::vector<QueryNode> mustNot;
+
+    QueryNode() : type(Type::Boolean), distance(0), boost(1.0) {}
+
+    bool isLeaf() const { return type != Type::Boolean; }
+
+    /**
+     * @brief Checks whether the node can match anything at all.
+     *
+     * @return True for a leaf without terms or a Boolean node with no
+     *         positive children
+     */
+    bool isEmpty() const {
+        return isLeaf() ? terms.empty() : (must.empty() && should.empty());
+    }
+};
+
+/**
+ * @brief A parsed query.
+ */
+struct Query {
+    QueryNode root;
+    std::vector<std::string> words; // unstemmed word of each term outside exclusions, in query order
+
+    bool isEmpty() const { return root.isEmpty(); }
+
+    /**
+     * @brief Gets the terms that contribute to matching, in query order.
+     *
+     * Terms that only appear under an exclusion are left out, so the result
+     * is suitable for highlighting and snippets.
+     *
+     * @return Vector of terms
+     */
+    std::vector<std::string> getTerms() const;
+
+    /**
+     * @brief Gets the leaves that contribute to a document's score.
+     *
+     * @return Pointers to the Term, Phrase and Near nodes outside exclusions
+     */
+    std::vector<const QueryNode*> getScoringLeaves() const;
+};
+
+/**
+ * @brief Parses query strings into query trees.
+ *
+ * Supported syntax:
+ * - plain words: `connection reset` matches either term
+ * - quoted phrases: `"connection reset"` matches the exact sequence
+ * - proximity: `connection NEAR/3 reset` matches both terms within 3 positions
+ * - operators: `AND`, `OR` and `NOT` (upper case), with `AND` binding tighter
+ * - grouping: `(timeout OR reset) AND connection`
+ * - required and excluded terms: `+connection -reset`
+ * - wildcards: `conn*`, `*timeout`, `c?nnect`
+ * - fuzzy terms: `conection~` (edits chosen by length) or `conection~1`
+ *
+ * Words are tokenized, stop-word filtered and stemmed exactly like document
+ * text, and phrases keep the gaps left by removed stop words so
+ * `"reset the connection"` only matches with one token in between. Wildcard
+ * patterns are not stemmed; they match the indexed terms as they are.
+ * Ideographs are tokens of their own, so an unquoted word of several
+ * (`東京`) matches its tokens as a phrase, while a word split by
+ * punctuation (`foo-bar`) matches any of its parts.
+ */
+class QueryParser {
+public:
+    /**
+     * @brief Constructor.
+     */
+    QueryParser();
+
+    /**
+     * @brief Parses a query string.
+     *
+     * Malformed input (unbalanced parentheses, dangling operators) is
+     * parsed leniently rather than rejected.
+     *
+     * @param query The raw query string
+     * @return Parsed query (empty if nothing searchable remains)
+     */
+    Query parse(const std::string& query) const;
+
+    /**
+     * @brief Sets the stemmer applied to query words.
+     * 
+     * Must match the one the documents were indexed with.
+     * 
+     * @param wordStemmer The stemmer, nullptr to leave words unstemmed
+     */
+    void setStemmer(const Stemmer* wordStemmer);
+
+private:
+    Tokenizer tokenizer;
+    StopWordRemover stopWordRemover;
+    const Stemmer* stemmer;
+};
+
+#endif // QUERYPARSER_H
@@ -0,0 +1,92 @@
+#ifndef SCOREACCUMULATOR_H
+#define SCOREACCUMULATOR_H
+
+#include "ScoringModel.h"
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief Dense per-document score array for term-at-a-time evaluation.
+ *
+ * Scores live in a float array indexed by docId, split into 64-byte aligned
+ * blocks so each block fills exactly one cache line and can be scanned with
+ * aligned SIMD loads. Adding a score is a single indexed add; the docIds
+ * touched since the last reset are remembered so a sparse query can be reset
+ * (and its candidates enumerated) without walking the whole array.
+ */
+class ScoreAccumulator {
+public:
+    ScoreAccumulator();
+
+    /**
+     * @brief Clears all scores and sizes the array for a collection.
+     *
+     * @param documentCount Number of documents (docIds are 0 .. documentCount - 1)
+     */
+    void reset(size_t documentCount);
+
+    /**
+     * @brief Adds to a document's score.
+     *
+     * @param docId Document identifier
+     * @param score Score to add
+     */
+    void add(uint32_t docId, float score) {
+        float& slot = blocks[docId / BlockSize].values[docId % BlockSize];
+        if (slot == 0.0f) {
+            if (score == 0.0f) {
+                return;
+            }
+            if (!overflowed) {
+                touched.push_back(docId);
+                overflowed = touched.size() > touchedLimit;
+            }
+        }
+        slot += score;
+    }
+
+    /**
+     * @brief Gets a document's accumulated score.
+     *
+     * @param docId Document identifier
+     * @return The score
+     */
+    float get(uint32_t docId) const {
+        return blocks[docId / BlockSize].values[docId % BlockSize];
+    }
+
+    /**
+     * @brief Selects the best scoring documents.
+     *
+     * Documents with a score of zero or less are never returned.
+     *
+     * @param k Number of documents wanted, 0 for all
+     * @param results Receives the documents by descending score, then
+     *        ascending docId; its capacity is reused across queries
+     */
+    void topK(size_t k, std::vector<ScoredDocument>& results) const;
+
+private:
+    static constexpr size_t BlockSize = 16; // floats per 64-byte cache line
+
+    struct alignas(64) Block {
+        float values[BlockSize];
+    };
+
+    std::vector<Block> blocks;
+    size_t documentCount;
+    std::vector<uint32_t> touched;
+    size_t touchedLimit;
+    bool overflowed; // too many documents touched to track; scan the array instead
+
+    /**
+     * @brief Collects the documents scoring above a threshold by scanning the whole array.
+     *
+     * @param threshold Scores must be strictly greater
+     * @param k Candidates to keep, 0 for all
+     * @param candidates Receives the candidates
+     */
+    void scan(float threshold, size_t k, std::vector<ScoredDocument>& candidates) const;
+};
+
+#endif // SCOREACCUMULATOR_H
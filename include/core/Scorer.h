@@ -0,0 +1,196 @@
+#ifndef SCORER_H
+#define SCORER_H
+
+#include "DocumentIndexer.h"
+#include "QueryEvaluator.h"
+#include "ScoringModel.h"
+#include "ScoreAccumulator.h"
+#include "SearchBudget.h"
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+/**
+ * @brief Scores matching documents with a selectable ranking function.
+ *
+ * The model is chosen at runtime but dispatched once per query into a loop
+ * specialized for its policy (see ScoringModel.h). Per-document length norms
+ * are computed for all documents on first use and reused until the index or
+ * the model changes; per-term weights are computed once per query term. The
+ * per-posting work is then a lookup of tf in the posting list plus a few
+ * arithmetic operations.
+ */
+class Scorer {
+public:
+    /**
+     * @brief Constructor.
+     *
+     * @param indexer Reference to the document indexer
+     */
+    explicit Scorer(const DocumentIndexer& indexer);
+
+    /**
+     * @brief Selects the ranking function.
+     *
+     * @param model The scoring model
+     */
+    void setModel(ScoringModel model);
+
+    /**
+     * @brief Gets the selected ranking function.
+     *
+     * @return The scoring model
+     */
+    ScoringModel getModel() const;
+
+    /**
+     * @brief Sets the BM25 parameters, also used by BM25+.
+     *
+     * @param k1 Term frequency saturation (typically 1.2 - 2.0)
+     * @param b Length normalization strength (0 - 1)
+     * @param delta BM25+ lower bound per matching term
+     */
+    void setBM25Parameters(double k1, double b, double delta);
+
+    /**
+     * @brief Gets the statistics of the indexed collection.
+     *
+     * @return Document count and total length
+     */
+    CollectionStatistics getCollectionStatistics() const;
+
+    /**
+     * @brief Gets the local statistics a shard contributes for a set of terms.
+     *
+     * @param terms Query terms
+     * @return Collection statistics and the document frequency of each indexed term
+     */
+    GlobalStatistics getStatistics(const std::vector<std::string>& terms) const;
+
+    /**
+     * @brief Adds the score of every leaf to the documents it matches.
+     *
+     * With a budget, matches are scored in chunks of ascending docId and
+     * scoring stops between chunks once the budget is spent; the matches
+     * not reached keep their score.
+     *
+     * @param leaves Scoring leaves of the query
+     * @param evaluator Evaluator used to find the documents each leaf matches
+     * @param matches Sorted docIds of the documents to score
+     * @param scores Score per entry of matches, added to
+     * @param global Collection-wide statistics to score with, nullptr for local ones
+     * @param budget Work budget of the query, nullptr for none
+     */
+    void score(const std::vector<const QueryNode*>& leaves, const QueryEvaluator& evaluator,
+               const std::vector<uint32_t>& matches, std::vector<double>& scores,
+               const GlobalStatistics* global = nullptr, QueryBudget* budget = nullptr) const;
+
+    /**
+     * @brief Adds the scores of Term leaves into a dense accumulator, term at a time.
+     *
+     * Every posting of every term is scored, so this suits disjunctions of
+     * plain terms, where each posting contributes to the result anyway.
+     * With a budget, all terms advance together one docId window at a
+     * time and scoring stops between windows once the budget is spent, so
+     * the documents scored are exactly those of the first windows, with
+     * complete scores.
+     *
+     * @param leaves Term leaves of the query
+     * @param accumulator Accumulator sized for the collection
+     * @param global Collection-wide statistics to score with, nullptr for local ones
+     * @param budget Work budget of the query, nullptr for none
+     */
+    void scoreTerms(const std::vector<const QueryNode*>& leaves, ScoreAccumulator& accumulator,
+                    const GlobalStatistics* global = nullptr, QueryBudget* budget = nullptr) const;
+
+    /**
+     * @brief Computes the score contribution of every posting of a term.
+     *
+     * @param list Posting list of the term
+     * @param contributions Receives one score per posting
+     */
+    void scorePostings(const PostingList& list, std::vector<double>& contributions) const;
+
+    /**
+     * @brief Computes a query-independent rank for every document.
+     *
+     * The vocabulary stands in for a query log: a document's rank is the
+     * number of terms for which its posting is among the ten highest
+     * scoring, i.e. how many one-term queries it would answer near the
+     * top. Such documents are the likeliest top results of longer queries
+     * too.
+     *
+     * @return Rank per docId, higher is better
+     */
+    std::vector<double> getStaticRanks() const;
+
+    /**
+     * @brief Discards cached norms; call after documents were added or removed.
+     */
+    void invalidate();
+
+private:
+    const DocumentIndexer& indexer;
+    ScoringModel model;
+    BM25PlusScoring bm25;
+
+    /**
+     * @brief Length norms of all documents, computed with one set of statistics.
+     */
+    struct LengthNorms {
+        CollectionStatistics statistics;
+        std::vector<double> norms; // per docId, for the current model
+    };
+
+    // Replaced, never modified, so queries keep scoring from the snapshot they took
+    mutable std::shared_ptr<const LengthNorms> lengthNorms;
+    mutable CollectionStatistics localStatistics;
+    mutable bool normsStale;      // index or model changed
+    mutable bool statisticsStale; // index changed
+    mutable std::mutex normsMutex;
+
+    /**
+     * @brief Gets the length norms for a query, recomputing them if the index, model or statistics changed.
+     *
+     * Norms are cached for one set of statistics at a time. A query with
+     * other statistics replaces the cached snapshot, while queries that
+     * still hold the previous one go on scoring from it.
+     *
+     * @param policy Policy providing lengthNorm()
+     * @param global Collection-wide statistics, nullptr for local ones
+     * @return The norms and the statistics they were computed with
+     */
+    template <typename Policy>
+    std::shared_ptr<const LengthNorms> prepare(const Policy& policy, const GlobalStatistics* global) const;
+
+    /**
+     * @brief Recomputes the local statistics if stale; normsMutex must be held.
+     */
+    void refreshLocalStatistics() const;
+
+    /**
+     * @brief Per-posting scores of one term, specialized for one policy.
+     */
+    template <typename Policy>
+    void scoreList(const Policy& policy, const PostingList& list, std::vector<double>& contributions) const;
+
+    /**
+     * @brief Term-at-a-time loop specialized for one policy.
+     */
+    template <typename Policy>
+    void accumulateTerms(const Policy& policy, const std::vector<const QueryNode*>& leaves,
+                         ScoreAccumulator& accumulator, const GlobalStatistics* global,
+                         QueryBudget* budget) const;
+
+    /**
+     * @brief Scoring loop specialized for one policy.
+     */
+    template <typename Policy>
+    void accumulate(const Policy& policy, const std::vector<const QueryNode*>& leaves,
+                    const QueryEvaluator& evaluator, const std::vector<uint32_t>& matches,
+                    std::vector<double>& scores, const GlobalStatistics* global,
+                    QueryBudget* budget) const;
+};
+
+#endif // SCORER_H
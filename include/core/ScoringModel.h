@@ -0,0 +1,148 @@
+#ifndef SCORINGMODEL_H
+#define SCORINGMODEL_H
+
+#include <cstdint>
+#include <cmath>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @brief Ranking functions selectable at runtime.
+ */
+enum class ScoringModel {
+    TFIDF,   // tf / length * log(N / df)
+    BM25,    // Okapi BM25
+    BM25Plus // BM25 with a lower bound for long documents
+};
+
+/**
+ * @brief Collection-wide statistics the ranking functions depend on.
+ */
+struct CollectionStatistics {
+    uint64_t documentCount;
+    uint64_t totalTerms; // sum of all document lengths
+
+    CollectionStatistics() : documentCount(0), totalTerms(0) {}
+
+    double getAverageLength() const {
+        return documentCount > 0 ? static_cast<double>(totalTerms) / documentCount : 0.0;
+    }
+};
+
+/**
+ * @brief Statistics of a collection split across shards, gathered for one query.
+ *
+ * Scoring every shard with the same counts and document frequencies makes
+ * scores comparable across shards, as if the collection were one index.
+ */
+struct GlobalStatistics {
+    CollectionStatistics collection;
+    std::unordered_map<std::string, uint64_t> documentFrequencies; // per query term
+
+    /**
+     * @brief Gets the document frequency of a term.
+     *
+     * @param term The term
+     * @param fallback Value to use if the term was not gathered
+     * @return Number of documents containing the term
+     */
+    uint64_t getDocumentFrequency(const std::string& term, uint64_t fallback) const {
+        auto it = documentFrequencies.find(term);
+        return it != documentFrequencies.end() ? it->second : fallback;
+    }
+
+    /**
+     * @brief Adds the statistics of another part of the collection.
+     *
+     * @param other Statistics of a disjoint set of documents
+     */
+    void merge(const GlobalStatistics& other) {
+        collection.documentCount += other.collection.documentCount;
+        collection.totalTerms += other.collection.totalTerms;
+        for (const auto& entry : other.documentFrequencies) {
+            documentFrequencies[entry.first] += entry.second;
+        }
+    }
+};
+
+/**
+ * @brief A document with its score.
+ */
+struct ScoredDocument {
+    uint32_t docId;
+    double score;
+};
+
+/*
+ * Scoring policies.
+ *
+ * Each policy splits its formula into three parts so the expensive pieces
+ * are computed outside the per-posting loop:
+ *   termWeight(df, stats)     once per query term
+ *   lengthNorm(length, stats) once per document, cached until the index changes
+ *   score(tf, weight, norm)   once per posting
+ * Scorer instantiates its loop for each policy, so score() is inlined and
+ * no virtual call happens per posting.
+ */
+
+/**
+ * @brief Classic length-normalized TF-IDF, identical to TFIDFCalculator.
+ */
+struct TFIDFScoring {
+    double termWeight(uint64_t documentFrequency, const CollectionStatistics& stats) const {
+        if (documentFrequency == 0) {
+            return 0.0;
+        }
+        return std::log(static_cast<double>(stats.documentCount) / documentFrequency);
+    }
+
+    double lengthNorm(uint32_t length, const CollectionStatistics&) const {
+        return length > 0 ? 1.0 / length : 0.0;
+    }
+
+    double score(uint32_t tf, double weight, double norm) const {
+        return tf * norm * weight;
+    }
+};
+
+/**
+ * @brief Okapi BM25 with saturating term frequency.
+ */
+struct BM25Scoring {
+    double k1;
+    double b;
+
+    BM25Scoring() : k1(1.2), b(0.75) {}
+
+    double termWeight(uint64_t documentFrequency, const CollectionStatistics& stats) const {
+        // The +1 keeps the weight positive for terms in more than half the documents
+        double n = static_cast<double>(documentFrequency);
+        return std::log(1.0 + (stats.documentCount - n + 0.5) / (n + 0.5));
+    }
+
+    double lengthNorm(uint32_t length, const CollectionStatistics& stats) const {
+        double average = stats.getAverageLength();
+        double relative = average > 0.0 ? length / average : 1.0;
+        return k1 * (1.0 - b + b * relative);
+    }
+
+    double score(uint32_t tf, double weight, double norm) const {
+        return weight * (tf * (k1 + 1.0)) / (tf + norm);
+    }
+};
+
+/**
+ * @brief BM25+: adds delta to every matching term so long documents are not
+ *        scored below documents that lack the term.
+ */
+struct BM25PlusScoring : BM25Scoring {
+    double delta;
+
+    BM25PlusScoring() : delta(1.0) {}
+
+    double score(uint32_t tf, double weight, double norm) const {
+        return weight * ((tf * (k1 + 1.0)) / (tf + norm) + delta);
+    }
+};
+
+#endif // SCORINGMODEL_H
@@ -0,0 +1,81 @@
+#ifndef SCRATCHARENA_H
+#define SCRATCHARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+/**
+ * @brief Bump allocator for short-lived data that is freed all at once.
+ *
+ * Allocations are carved out of one reusable buffer by a
+ * std::pmr::monotonic_buffer_resource; individual deallocations are no-ops
+ * and release() frees everything. When a cycle outgrows the buffer the
+ * excess is taken from the heap and, on release(), the buffer is enlarged to
+ * fit, so a steady workload settles into a single allocation that is reused
+ * from then on.
+ *
+ * Not thread-safe; give every thread its own arena.
+ */
+class ScratchArena {
+public:
+    /**
+     * @brief Constructor.
+     *
+     * @param initialCapacity Initial buffer size in bytes
+     */
+    explicit ScratchArena(size_t initialCapacity = 64 * 1024);
+
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    /**
+     * @brief Gets the memory resource for std::pmr containers.
+     *
+     * @return The arena's resource
+     */
+    std::pmr::memory_resource* getResource();
+
+    /**
+     * @brief Frees everything allocated since the last release.
+     *
+     * Containers using the arena must have been destroyed.
+     */
+    void release();
+
+    /**
+     * @brief Gets the size of the reusable buffer.
+     *
+     * @return Capacity in bytes
+     */
+    size_t getCapacity() const;
+
+private:
+    // The buffer never grows past this; larger cycles keep borrowing from the heap
+    static constexpr size_t MaxRetainedCapacity = 16 * 1024 * 1024;
+
+    /**
+     * @brief Heap resource that counts what the arena borrows beyond its buffer.
+     */
+    class OverflowResource : public std::pmr::memory_resource {
+    public:
+        OverflowResource() : borrowed(0) {}
+        size_t getBorrowed() const { return borrowed; }
+        void resetBorrowed() { borrowed = 0; }
+
+    private:
+        size_t borrowed;
+
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+    };
+
+    std::unique_ptr<std::byte[]> buffer;
+    size_t capacity;
+    OverflowResource overflow;
+    std::optional<std::pmr::monotonic_buffer_resource> resource;
+};
+
+#endif // SCRATCHARENA_H
@@ -0,0 +1,98 @@
+#ifndef SEARCHBUDGET_H
+#define SEARCHBUDGET_H
+
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @brief Limits on the work a single search may do.
+ *
+ * A zero limit means no limit, so a default-constructed budget is unlimited.
+ */
+struct SearchBudget {
+    std::chrono::microseconds timeLimit; // wall-clock time from the start of the search
+    uint64_t maxPostings;                // postings scored or matched
+
+    SearchBudget() : timeLimit(0), maxPostings(0) {}
+
+    SearchBudget(std::chrono::microseconds time, uint64_t postings)
+        : timeLimit(time), maxPostings(postings) {}
+
+    bool isUnlimited() const {
+        return timeLimit.count() <= 0 && maxPostings == 0;
+    }
+};
+
+/**
+ * @brief Tracks one query's spending against a SearchBudget.
+ *
+ * Evaluation proceeds in chunks (docId windows, impact segments), charges
+ * the postings of each chunk and asks shouldStop() before starting the
+ * next one, so the clock is read once per chunk rather than per posting.
+ * The first chunk always runs, so a stopped query still has results.
+ */
+class QueryBudget {
+public:
+    /**
+     * @brief Starts the clock.
+     *
+     * @param budget Limits of the query
+     */
+    explicit QueryBudget(const SearchBudget& budget)
+        : deadline(std::chrono::steady_clock::now() + budget.timeLimit),
+          hasDeadline(budget.timeLimit.count() > 0),
+          maxPostings(budget.maxPostings),
+          postings(0),
+          stopped(false) {}
+
+    /**
+     * @brief Records work done.
+     *
+     * @param count Number of postings processed
+     */
+    void charge(uint64_t count) {
+        postings += count;
+    }
+
+    /**
+     * @brief Checks whether evaluation must stop before its next chunk.
+     *
+     * Call only when work remains: a true result marks the query as stopped early.
+     *
+     * @return True if the budget is spent
+     */
+    bool shouldStop() {
+        if (!stopped) {
+            stopped = (maxPostings > 0 && postings >= maxPostings) ||
+                      (hasDeadline && std::chrono::steady_clock::now() >= deadline);
+        }
+        return stopped;
+    }
+
+    /**
+     * @brief Checks whether some work was skipped, i.e. the results are partial.
+     *
+     * @return True if shouldStop() returned true
+     */
+    bool stoppedEarly() const {
+        return stopped;
+    }
+
+    /**
+     * @brief Gets the number of postings charged so far.
+     *
+     * @return Postings processed
+     */
+    uint64_t getPostings() const {
+        return postings;
+    }
+
+private:
+    std::chrono::steady_clock::time_point deadline;
+    bool hasDeadline;
+    uint64_t maxPostings;
+    uint64_t postings;
+    bool stopped;
+};
+
+#endif // SEARCHBUDGET_H
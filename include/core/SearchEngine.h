@@ -3,22 +3,37 @@
 
 #include "DocumentIndexer.h"
 #include "TFIDFCalculator.h"
+#include "QueryParser.h"
+#include "QueryEvaluator.h"
+#include "SnippetGenerator.h"
+#include "Scorer.h"
+#include "ImpactIndex.h"
+#include "SimilarityIndex.h"
+#include "ScoreAccumulator.h"
+#include "SearchBudget.h"
 #include <string>
+#include <chrono>
 #include <vector>
 #include <map>
+#include <mutex>
 
 /**
- * @brief Represents a search result with document and relevance score.
+ * @brief Represents a search result: a document handle and its relevance score.
+ *
+ * Results are plain values, cheap to copy and sort. The document's metadata
+ * is looked up with SearchEngine::getDocument() only for the results that
+ * are actually shown.
  */
 struct SearchResult {
-    std::shared_ptr<Document> document;
-    double score;
+    uint32_t docId;
+    float score;
     
-    SearchResult(std::shared_ptr<Document> doc, double sc) 
-        : document(doc), score(sc) {}
+    SearchResult(uint32_t id, float sc) 
+        : docId(id), score(sc) {}
     
     bool operator<(const SearchResult& other) const {
-        return score > other.score; // Sort by score descending
+        // Sort by score descending, ties by docId
+        return score != other.score ? score > other.score : docId < other.docId;
     }
 };
 
@@ -26,7 +41,13 @@ struct SearchResult {
  * @brief Main search engine class that orchestrates indexing and searching.
  * 
  * This class provides a high-level interface for indexing documents and
- * performing searches using TF-IDF ranking.
+ * performing searches ranked with BM25, BM25+ or TF-IDF.
+ * 
+ * Searches, findSimilar() and getStatistics() may run on several threads
+ * at once: each thread scores into its own scratch buffers, and the shared
+ * caches (length norms, impact and similarity indexes) are built under a
+ * lock and never modified while a query reads them. Indexing and the
+ * setters must not overlap searches.
  */
 class SearchEngine {
 public:
@@ -51,15 +72,130 @@ public:
      */
     int indexDocuments(const std::vector<std::string>& filePaths);
 
+    /**
+     * @brief Renumbers the indexed documents so similar documents are adjacent.
+     * 
+     * Meant to run once a batch has been indexed: clustered docIds make
+     * posting lists denser and scoring more cache friendly. With
+     * DocumentOrder::StaticRank, documents that are among the best matches
+     * of many terms (see Scorer::getStaticRanks()) come first, so budgeted
+     * searches reach them first. Results and
+     * docIds obtained before the call are invalidated.
+     * 
+     * @param order Ordering method
+     */
+    void reorderDocuments(DocumentOrder order = DocumentOrder::GraphBisection);
+
     /**
      * @brief Performs a search query and returns ranked results.
      * 
+     * Plain words match documents containing any of them. Quoted text
+     * matches the exact phrase, `a NEAR/k b` matches documents where the
+     * terms occur within k positions of each other, and AND / OR / NOT,
+     * parentheses and `+required -excluded` prefixes restrict the matches.
+     * See QueryParser for the full syntax.
+     * 
      * @param query The search query string
      * @param maxResults Maximum number of results to return (0 for all)
      * @return Vector of search results sorted by relevance score
      */
     std::vector<SearchResult> search(const std::string& query, size_t maxResults = 0) const;
 
+    /**
+     * @brief Performs a search scored with collection-wide statistics.
+     * 
+     * Used when this engine holds one shard of a larger collection, so its
+     * scores are comparable with those of the other shards.
+     * 
+     * @param query The search query string
+     * @param maxResults Maximum number of results to return (0 for all)
+     * @param global Statistics of the whole collection for the query's terms
+     * @return Vector of search results sorted by relevance score
+     */
+    std::vector<SearchResult> search(const std::string& query, size_t maxResults,
+                                     const GlobalStatistics& global) const;
+
+    /**
+     * @brief Performs a search that stops once a time or work budget is spent.
+     * 
+     * Evaluation proceeds in ascending docId windows (or, with impact
+     * ordering, by descending impact) and returns the best results among
+     * the documents scored before the budget ran out. Ordering documents
+     * with DocumentOrder::StaticRank puts the likeliest hits in the first
+     * windows. Matching Boolean queries is not interrupted; scoring is.
+     * 
+     * @param query The search query string
+     * @param maxResults Maximum number of results to return (0 for all)
+     * @param budget Limits for this query
+     * @param partial Set to true if evaluation stopped before scoring every match
+     * @return Vector of search results sorted by relevance score
+     */
+    std::vector<SearchResult> search(const std::string& query, size_t maxResults,
+                                     const SearchBudget& budget, bool& partial) const;
+
+    /**
+     * @brief Finds the documents most similar to an indexed document ("more like this").
+     * 
+     * Documents are compared by the cosine similarity of their TF-IDF
+     * vectors, pruned to each document's heaviest terms (see
+     * SimilarityIndex). The vectors are built on the first call after the
+     * index changed. With duplicate collapsing, the document's own
+     * near-duplicates are left out and each other cluster is shown once.
+     * 
+     * @param docId The document to compare with
+     * @param maxResults Maximum number of results to return (0 for all)
+     * @return Vector of search results sorted by similarity, the score being the cosine similarity
+     */
+    std::vector<SearchResult> findSimilar(uint32_t docId, size_t maxResults = 10) const;
+
+    /**
+     * @brief Sets the budget of searches that are not given one, e.g. shard requests.
+     * 
+     * @param budget Limits per query (unlimited by default)
+     */
+    void setSearchBudget(const SearchBudget& budget);
+
+    /**
+     * @brief Gets the budget of searches that are not given one.
+     * 
+     * @return Limits per query
+     */
+    SearchBudget getSearchBudget() const;
+
+    /**
+     * @brief Gets this engine's share of the statistics a query is scored with.
+     * 
+     * @param query The search query string (empty for collection counts only)
+     * @return Document count, total length and the document frequency of each query term
+     */
+    GlobalStatistics getStatistics(const std::string& query) const;
+
+    /**
+     * @brief Gets an indexed document, e.g. to display a search result.
+     * 
+     * @param docId Document identifier
+     * @return The document, nullptr if there is no such document
+     */
+    std::shared_ptr<Document> getDocument(uint32_t docId) const;
+
+    /**
+     * @brief Reads part of a document's text, from the document store when it holds a copy.
+     * 
+     * @param docId Document identifier
+     * @param offset Byte offset into the document text
+     * @param length Number of bytes to read
+     * @return The text read, empty if the document cannot be read
+     */
+    std::string readDocumentText(uint32_t docId, size_t offset, size_t length) const;
+
+    /**
+     * @brief Checks whether a document's text is in the document store.
+     * 
+     * @param docId Document identifier
+     * @return True if the text can be read without the original file
+     */
+    bool isDocumentStored(uint32_t docId) const;
+
     /**
      * @brief Gets the total number of indexed documents.
      * 
@@ -79,27 +215,232 @@ public:
      */
     std::vector<std::string> getIndexedFiles() const;
 
+    /**
+     * @brief Gets the normalized terms a query is matched with.
+     * 
+     * The terms are tokenized, stop-word filtered and stemmed exactly as
+     * during search, and wildcards are expanded to the terms they match.
+     * 
+     * @param query The search query string
+     * @return Vector of query terms
+     */
+    std::vector<std::string> getQueryTerms(const std::string& query) const;
+
+    /**
+     * @brief Gets the query words the terms were made from, before stemming.
+     * 
+     * With stemming, a term need not be a prefix of the words it matches
+     * ("happy" is indexed as "happi"), so highlighting looks for these
+     * words as well as for the terms.
+     * 
+     * @param query The search query string
+     * @return Vector of tokenized, stop-word filtered query words
+     */
+    std::vector<std::string> getQueryWords(const std::string& query) const;
+
+    /**
+     * @brief Generates query-biased snippets for a range of search results.
+     * 
+     * Snippets are built from stored token offsets (positional indexing
+     * must be enabled), which are not kept for documents over 4 GiB.
+     * Generation stops once the time budget is spent; the remaining
+     * results get empty snippets.
+     * 
+     * @param query The search query string the results came from
+     * @param results Search results
+     * @param offset Index of the first result to generate a snippet for
+     * @param count Number of results to generate snippets for
+     * @param budget Maximum time to spend on the whole range
+     * @return One snippet per result in the range (possibly empty)
+     */
+    std::vector<std::string> getSnippets(const std::string& query,
+                                         const std::vector<SearchResult>& results,
+                                         size_t offset, size_t count,
+                                         std::chrono::milliseconds budget = std::chrono::milliseconds(50)) const;
+
+    /**
+     * @brief Enables or disables positional postings for documents indexed afterwards.
+     * 
+     * @param enabled True to record term positions
+     */
+    void setPositionalIndexing(bool enabled);
+
+    /**
+     * @brief Enables or disables Porter stemming of document and query terms.
+     * 
+     * With stemming, "connected" and "connections" both match "connect".
+     * Documents keep the terms they were indexed with, so set this before
+     * indexing (or clear() and reindex after changing it).
+     * 
+     * @param enabled True to stem terms
+     */
+    void setStemming(bool enabled);
+
+    /**
+     * @brief Keeps a compressed copy of documents indexed afterwards for previews and snippets.
+     * 
+     * @param path Store file to create, or empty to stop storing
+     * @return False if the store file cannot be created
+     */
+    bool setDocumentStore(const std::string& path);
+
+    /**
+     * @brief Shows only the best scoring document of each near-duplicate cluster.
+     * 
+     * Near-duplicates (see DuplicateDetector) are found while indexing;
+     * with collapsing, they no longer crowd other documents out of the top
+     * results. Disabled by default.
+     * 
+     * @param enabled True to collapse clusters in search results
+     */
+    void setCollapseDuplicates(bool enabled);
+
+    /**
+     * @brief Sets the similarity from which documents count as near-duplicates.
+     * 
+     * @param similarity Minimum estimated Jaccard similarity (0.75 by default)
+     */
+    void setDuplicateThreshold(double similarity);
+
+    /**
+     * @brief Enables or disables postings for near-duplicates indexed afterwards.
+     * 
+     * Leaving near-duplicates out of the inverted index keeps it smaller;
+     * see DocumentIndexer::setIndexingDuplicates() for the trade-off.
+     * 
+     * @param enabled True to index near-duplicates like any other document
+     */
+    void setIndexingDuplicates(bool enabled);
+
+    /**
+     * @brief Gets the number of other documents in a document's near-duplicate cluster.
+     * 
+     * @param docId Document identifier
+     * @return Number of near-duplicates
+     */
+    size_t getDuplicateCount(uint32_t docId) const;
+
+    /**
+     * @brief Sets the number of threads tokenizing files in indexDocuments().
+     * 
+     * @param threads Number of threads, 0 for one per processor
+     */
+    void setIngestionThreads(size_t threads);
+
+    /**
+     * @brief Sets how many dictionary terms a wildcard may expand to.
+     * 
+     * Bounds the cost of broad patterns such as `a*`.
+     * 
+     * @param limit Maximum number of terms per pattern
+     */
+    void setMaxTermExpansions(size_t limit);
+
+    /**
+     * @brief Selects the ranking function used by search().
+     * 
+     * @param model The scoring model (BM25 by default)
+     */
+    void setScoringModel(ScoringModel model);
+
+    /**
+     * @brief Gets the ranking function used by search().
+     * 
+     * @return The scoring model
+     */
+    ScoringModel getScoringModel() const;
+
+    /**
+     * @brief Enables score-at-a-time evaluation over quantized impacts.
+     * 
+     * When enabled, searches with a result limit whose query is a plain
+     * bag of terms (no phrases, operators or fuzzy terms) are answered from
+     * an impact-ordered index and stop as soon as the top results are
+     * settled. Scores are then approximated to 8 bits of precision. The
+     * impact index is built on the first such search after the index or
+     * the scoring model changed.
+     * 
+     * @param enabled True to use impact-ordered evaluation
+     */
+    void setImpactOrdering(bool enabled);
+
 private:
     DocumentIndexer indexer;
     mutable std::unique_ptr<TFIDFCalculator> tfidfCalculator;
+    QueryParser queryParser;
+    QueryEvaluator queryEvaluator;
+    SnippetGenerator snippetGenerator;
+    Scorer scorer;
+    
+    SearchBudget searchBudget;
+    bool collapsingDuplicates;
+    bool impactOrdering;
+    mutable ImpactIndex impactIndex;
+    mutable bool impactIndexStale;
+    mutable std::mutex impactIndexMutex;
+    mutable SimilarityIndex similarityIndex;
+    mutable bool similarityIndexStale;
+    mutable std::mutex similarityIndexMutex;
+    
     
     /**
-     * @brief Tokenizes and processes a query string.
+     * @brief Parses a query string and expands its wildcard terms.
      * 
      * @param query The query string
-     * @return Vector of processed tokens
+     * @return Parsed query
      */
-    std::vector<std::string> processQuery(const std::string& query) const;
+    Query processQuery(const std::string& query) const;
     
     /**
-     * @brief Calculates relevance score for a document given query terms.
+     * @brief Runs a search, scoring with the given or the local statistics.
      * 
-     * @param queryTerms Vector of query terms
-     * @param document The document to score
-     * @return Relevance score
+     * @param query The search query string
+     * @param maxResults Maximum number of results to return (0 for all)
+     * @param global Collection-wide statistics, nullptr for local ones
+     * @param budget Work budget of the query, nullptr for none
+     * @return Vector of search results sorted by relevance score
      */
-    double calculateRelevanceScore(const std::vector<std::string>& queryTerms, 
-                                   const std::shared_ptr<Document>& document) const;
+    std::vector<SearchResult> searchWith(const std::string& query, size_t maxResults,
+                                         const GlobalStatistics* global, QueryBudget* budget) const;
+    
+    /**
+     * @brief Finds and ranks the documents matching a query, duplicates included.
+     * 
+     * @param query The search query string
+     * @param maxResults Maximum number of results to return (0 for all)
+     * @param global Collection-wide statistics, nullptr for local ones
+     * @param budget Work budget of the query, nullptr for none
+     * @return Vector of search results sorted by relevance score
+     */
+    std::vector<SearchResult> rankDocuments(const std::string& query, size_t maxResults,
+                                            const GlobalStatistics* global, QueryBudget* budget) const;
+    
+    /**
+     * @brief Removes every result whose near-duplicate cluster already has a better result.
+     * 
+     * @param results Search results sorted by relevance score
+     */
+    void collapseDuplicates(std::vector<SearchResult>& results) const;
+    
+    /**
+     * @brief Gets the impact index, rebuilding it first if it is stale.
+     * 
+     * @return Reference to the impact index
+     */
+    const ImpactIndex& getImpactIndex() const;
+    
+    /**
+     * @brief Gets the similarity index, rebuilding it first if it is stale.
+     * 
+     * @return Reference to the similarity index
+     */
+    const SimilarityIndex& getSimilarityIndex() const;
+    
+    /**
+     * @brief Marks everything derived from scores and term weights for rebuilding.
+     */
+    void invalidateScores();
+
 };
 
 #endif // SEARCHENGINE_H
@@ -0,0 +1,157 @@
+#ifndef SHARD_H
+#define SHARD_H
+
+#include "SearchEngine.h"
+#include "ShardProtocol.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief One partition of a sharded collection, as seen by the coordinator.
+ *
+ * Implementations may search in-process or forward the requests to another
+ * process; the coordinator only relies on this interface.
+ */
+class Shard {
+public:
+    virtual ~Shard() = default;
+
+    /**
+     * @brief Gets the shard's share of the statistics of a query.
+     *
+     * @param query The search query string
+     * @param stats Receives the shard's collection counts and query term frequencies
+     * @return False if the shard could not be reached
+     */
+    virtual bool getStatistics(const std::string& query, GlobalStatistics& stats) = 0;
+
+    /**
+     * @brief Searches the shard with collection-wide statistics.
+     *
+     * @param query The search query string
+     * @param maxResults Maximum number of hits (0 for all)
+     * @param global Summed statistics of all shards
+     * @param hits Receives the hits by descending score
+     * @return False if the shard could not be reached
+     */
+    virtual bool search(const std::string& query, size_t maxResults, const GlobalStatistics& global,
+                        std::vector<ShardHit>& hits) = 0;
+
+    /**
+     * @brief Gets the documents behind some of this shard's hits.
+     *
+     * @param docIds docIds of hits returned by this shard
+     * @param documents Receives one document per docId, nullptr where it cannot be resolved
+     * @return False if the shard could not be reached
+     */
+    virtual bool getDocuments(const std::vector<uint32_t>& docIds,
+                              std::vector<std::shared_ptr<Document>>& documents) = 0;
+};
+
+/**
+ * @brief Shard searched in the coordinator's process.
+ */
+class LocalShard : public Shard {
+public:
+    /**
+     * @brief Constructor.
+     *
+     * @param engine Engine holding the shard's documents
+     */
+    explicit LocalShard(const SearchEngine& engine);
+
+    bool getStatistics(const std::string& query, GlobalStatistics& stats) override;
+    bool search(const std::string& query, size_t maxResults, const GlobalStatistics& global,
+                std::vector<ShardHit>& hits) override;
+    bool getDocuments(const std::vector<uint32_t>& docIds,
+                      std::vector<std::shared_ptr<Document>>& documents) override;
+
+private:
+    const SearchEngine& engine;
+};
+
+/**
+ * @brief Shard served by another process (see ShardServer) over a pipe or socket.
+ *
+ * Requests are serialized with a mutex, so one RemoteShard can be shared by
+ * concurrent queries. Resolved documents only carry the file path and name.
+ */
+class RemoteShard : public Shard {
+public:
+    /**
+     * @brief Constructor. The descriptors are not closed by this object.
+     *
+     * @param inputFd Descriptor the shard's responses are read from
+     * @param outputFd Descriptor requests are written to
+     */
+    RemoteShard(int inputFd, int outputFd);
+
+    bool getStatistics(const std::string& query, GlobalStatistics& stats) override;
+    bool search(const std::string& query, size_t maxResults, const GlobalStatistics& global,
+                std::vector<ShardHit>& hits) override;
+    bool getDocuments(const std::vector<uint32_t>& docIds,
+                      std::vector<std::shared_ptr<Document>>& documents) override;
+
+    /**
+     * @brief Asks the server to stop.
+     *
+     * @return True if the request was sent
+     */
+    bool shutdown();
+
+private:
+    int inputFd;
+    int outputFd;
+    std::mutex channelMutex;
+
+    /**
+     * @brief Sends a request and waits for its response.
+     */
+    bool exchange(const std::string& request, std::string& response);
+};
+
+/**
+ * @brief Answers shard protocol requests with a local SearchEngine.
+ */
+class ShardServer {
+public:
+    /**
+     * @brief Constructor.
+     *
+     * @param engine Engine holding the shard's documents
+     */
+    explicit ShardServer(const SearchEngine& engine);
+
+    /**
+     * @brief Answers one request.
+     *
+     * @param request Encoded request
+     * @param response Receives the encoded response
+     * @return False for malformed or unexpected requests
+     */
+    bool handle(const std::string& request, std::string& response) const;
+
+    /**
+     * @brief Answers framed requests until a shutdown request or end of input.
+     *
+     * @param inputFd Descriptor requests are read from
+     * @param outputFd Descriptor responses are written to
+     * @return True on shutdown or end of input, false on a protocol or I/O error
+     */
+    bool serve(int inputFd, int outputFd) const;
+
+    /**
+     * @brief Converts search results into protocol hits.
+     *
+     * @param results Results of a local search
+     * @return One hit per result
+     */
+    static std::vector<ShardHit> toHits(const std::vector<SearchResult>& results);
+
+private:
+    const SearchEngine& engine;
+};
+
+#endif // SHARD_H
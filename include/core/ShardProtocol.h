@@ -0,0 +1,149 @@
+#ifndef SHARDPROTOCOL_H
+#define SHARDPROTOCOL_H
+
+#include "ScoringModel.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief A document found by one shard.
+ */
+struct ShardHit {
+    uint32_t docId; // docId within the shard
+    float score;
+};
+
+/**
+ * @brief Binary messages exchanged between a sharded search coordinator and its shards.
+ *
+ * A query takes two round trips: a statistics request, whose responses are
+ * summed into GlobalStatistics, then a search request carrying those
+ * statistics so every shard scores on the same scale. Hits only carry
+ * docIds; the paths of the hits that are shown are fetched afterwards with a
+ * documents request. Messages start with a MessageType byte followed by
+ * little-endian fixed-width integers, IEEE floats and length-prefixed
+ * strings. Across processes each message is sent as one frame: a 4-byte
+ * little-endian length followed by the message.
+ *
+ * Decoding never trusts its input: truncated or oversized messages make the
+ * decode functions return false.
+ */
+class ShardProtocol {
+public:
+    enum class MessageType : uint8_t {
+        StatisticsRequest = 1,
+        StatisticsResponse = 2,
+        SearchRequest = 3,
+        SearchResponse = 4,
+        Shutdown = 5,
+        DocumentsRequest = 6,
+        DocumentsResponse = 7
+    };
+
+    /**
+     * @brief Asks a shard for its share of the statistics of a query.
+     *
+     * @param query The search query string
+     * @return Encoded message
+     */
+    static std::string encodeStatisticsRequest(const std::string& query);
+
+    /**
+     * @brief Answers a statistics request.
+     *
+     * @param stats The shard's collection counts and query term frequencies
+     * @return Encoded message
+     */
+    static std::string encodeStatisticsResponse(const GlobalStatistics& stats);
+
+    /**
+     * @brief Asks a shard for its best documents.
+     *
+     * @param query The search query string
+     * @param maxResults Maximum number of hits (0 for all)
+     * @param global Summed statistics of all shards
+     * @return Encoded message
+     */
+    static std::string encodeSearchRequest(const std::string& query, size_t maxResults,
+                                           const GlobalStatistics& global);
+
+    /**
+     * @brief Answers a search request.
+     *
+     * @param hits The shard's hits by descending score
+     * @return Encoded message
+     */
+    static std::string encodeSearchResponse(const std::vector<ShardHit>& hits);
+
+    /**
+     * @brief Asks a shard for the paths of some of its documents.
+     *
+     * @param docIds docIds within the shard
+     * @return Encoded message
+     */
+    static std::string encodeDocumentsRequest(const std::vector<uint32_t>& docIds);
+
+    /**
+     * @brief Answers a documents request.
+     *
+     * @param filePaths One path per requested docId, empty for unknown ones
+     * @return Encoded message
+     */
+    static std::string encodeDocumentsResponse(const std::vector<std::string>& filePaths);
+
+    /**
+     * @brief Tells a shard server to stop serving.
+     *
+     * @return Encoded message
+     */
+    static std::string encodeShutdown();
+
+    /**
+     * @brief Reads the type of a message.
+     *
+     * @param message Encoded message
+     * @param type Receives the type
+     * @return False if the message is empty or of an unknown type
+     */
+    static bool getMessageType(const std::string& message, MessageType& type);
+
+    /*
+     * Decoders for the messages above. Each returns false if the message is
+     * of another type, truncated or has trailing bytes.
+     */
+    static bool decodeStatisticsRequest(const std::string& message, std::string& query);
+    static bool decodeStatisticsResponse(const std::string& message, GlobalStatistics& stats);
+    static bool decodeSearchRequest(const std::string& message, std::string& query, size_t& maxResults,
+                                    GlobalStatistics& global);
+    static bool decodeSearchResponse(const std::string& message, std::vector<ShardHit>& hits);
+    static bool decodeDocumentsRequest(const std::string& message, std::vector<uint32_t>& docIds);
+    static bool decodeDocumentsResponse(const std::string& message, std::vector<std::string>& filePaths);
+
+    /**
+     * @brief Writes one message as a frame to a file descriptor.
+     *
+     * Only available on POSIX systems; always fails elsewhere.
+     *
+     * @param fd Pipe or socket
+     * @param message Encoded message
+     * @return True if the whole frame was written
+     */
+    static bool writeFrame(int fd, const std::string& message);
+
+    /**
+     * @brief Reads one frame from a file descriptor.
+     *
+     * Only available on POSIX systems; always fails elsewhere.
+     *
+     * @param fd Pipe or socket
+     * @param message Receives the message
+     * @return False at end of input, on error or for an oversized frame
+     */
+    static bool readFrame(int fd, std::string& message);
+
+private:
+    static constexpr uint32_t MaxFrameSize = 256u * 1024u * 1024u;
+};
+
+#endif // SHARDPROTOCOL_H
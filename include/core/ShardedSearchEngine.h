@@ -0,0 +1,195 @@
+#ifndef SHARDEDSEARCHENGINE_H
+#define SHARDEDSEARCHENGINE_H
+
+#include "SearchEngine.h"
+#include "Shard.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A result of a sharded search: a shard-local docId, its shard and its score.
+ */
+struct ShardedSearchResult {
+    uint32_t shard;
+    uint32_t docId; // docId within the shard
+    float score;
+};
+
+/**
+ * @brief Search engine whose documents are partitioned across several shards.
+ *
+ * Documents are routed to local shards by a hash of their path; each local
+ * shard is a full SearchEngine, so shards are indexed and searched
+ * independently and in parallel. A query is scattered twice: first every
+ * shard reports its document count, total length and query term document
+ * frequencies, which are summed into global statistics; then every shard
+ * searches with those statistics, so scores are comparable and equal to
+ * what a single index would produce. The per-shard top-K lists are merged
+ * with a k-way heap merge. Results are handles; getDocuments() resolves the
+ * ones that are shown, with one request per shard.
+ *
+ * Shards served by other processes can be added with addShard() and a
+ * RemoteShard; they take part in queries but not in indexing.
+ *
+ * Every shard has a worker thread for its whole lifetime that runs all of
+ * its indexing and search requests, so the per-thread query scratch
+ * buffers of a local shard are allocated once rather than per query.
+ * Concurrent searches queue up on each shard's worker.
+ */
+class ShardedSearchEngine {
+public:
+    /**
+     * @brief Constructor.
+     *
+     * @param shardCount Number of local shards (at least 1)
+     */
+    explicit ShardedSearchEngine(size_t shardCount);
+
+    /**
+     * @brief Destructor. Stops the shard workers.
+     */
+    ~ShardedSearchEngine();
+
+    /**
+     * @brief Indexes a single document into the shard its path routes to.
+     *
+     * @param filePath Path to the document file
+     * @return True if successful, false otherwise
+     */
+    bool indexDocument(const std::string& filePath);
+
+    /**
+     * @brief Indexes multiple documents, all shards in parallel.
+     *
+     * @param filePaths Vector of file paths
+     * @return Number of successfully indexed documents
+     */
+    int indexDocuments(const std::vector<std::string>& filePaths);
+
+    /**
+     * @brief Renumbers the documents of every local shard, in parallel.
+     *
+     * @param order Ordering method
+     */
+    void reorderDocuments(DocumentOrder order = DocumentOrder::GraphBisection);
+
+    /**
+     * @brief Adds a shard that is indexed elsewhere, e.g. a RemoteShard.
+     *
+     * @param shard The shard
+     */
+    void addShard(std::unique_ptr<Shard> shard);
+
+    /**
+     * @brief Searches all shards in parallel and merges their results.
+     *
+     * Shards that cannot be reached are skipped.
+     *
+     * @param query The search query string
+     * @param maxResults Maximum number of results to return (0 for all)
+     * @return Vector of search results sorted by relevance score
+     */
+    std::vector<ShardedSearchResult> search(const std::string& query, size_t maxResults = 0) const;
+
+    /**
+     * @brief Gets the documents behind a range of search results.
+     *
+     * @param results Results of search()
+     * @param offset Index of the first result to resolve
+     * @param count Number of results to resolve
+     * @return One document per result in the range, nullptr where its shard could not resolve it
+     */
+    std::vector<std::shared_ptr<Document>> getDocuments(const std::vector<ShardedSearchResult>& results,
+                                                        size_t offset, size_t count) const;
+
+    /**
+     * @brief Gets the total number of documents in all shards.
+     *
+     * @return Number of documents
+     */
+    size_t getDocumentCount() const;
+
+    /**
+     * @brief Gets the number of shards, local and added.
+     *
+     * @return Number of shards
+     */
+    size_t getShardCount() const;
+
+    /**
+     * @brief Gets a local shard's engine, e.g. to configure it.
+     *
+     * @param index Local shard index
+     * @return The shard's engine
+     */
+    SearchEngine& getLocalShard(size_t index);
+
+    /**
+     * @brief Gets the number of local shards.
+     *
+     * @return Number of local shards
+     */
+    size_t getLocalShardCount() const;
+
+    /**
+     * @brief Selects the ranking function of all local shards.
+     *
+     * @param model The scoring model
+     */
+    void setScoringModel(ScoringModel model);
+
+    /**
+     * @brief Enables or disables stemming on all local shards.
+     *
+     * Remote shards must be configured the same way by their servers.
+     *
+     * @param enabled True to stem document and query terms
+     */
+    void setStemming(bool enabled);
+
+    /**
+     * @brief Collapses near-duplicate clusters in the results of every local shard.
+     *
+     * Documents are routed by path, so near-duplicates in different shards
+     * are not detected and stay separate results.
+     *
+     * @param enabled True to collapse clusters
+     */
+    void setCollapseDuplicates(bool enabled);
+
+    /**
+     * @brief Sets the budget each local shard spends per query.
+     *
+     * Shards that stop early return their best results so far; remote
+     * shards must be configured the same way by their servers.
+     *
+     * @param budget Limits per query and shard
+     */
+    void setSearchBudget(const SearchBudget& budget);
+
+    /**
+     * @brief Clears all documents of the local shards.
+     */
+    void clear();
+
+    /**
+     * @brief Picks the shard a document belongs to.
+     *
+     * Uses FNV-1a, which unlike std::hash is the same in every process.
+     *
+     * @param filePath Path to the document file
+     * @param shardCount Number of shards
+     * @return Shard index
+     */
+    static size_t routeDocument(const std::string& filePath, size_t shardCount);
+
+private:
+    class Worker;
+
+    std::vector<std::unique_ptr<SearchEngine>> engines; // local shards
+    std::vector<std::unique_ptr<Shard>> shards;         // local shards first
+    std::vector<std::unique_ptr<Worker>> workers;       // one per shard, same order
+};
+
+#endif // SHARDEDSEARCHENGINE_H
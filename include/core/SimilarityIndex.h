@@ -0,0 +1,95 @@
+#ifndef SIMILARITYINDEX_H
+#define SIMILARITYINDEX_H
+
+#include "DocumentIndexer.h"
+#include "ScoringModel.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Pruned, normalized TF-IDF vectors of all documents for "more like this" searches.
+ *
+ * Each document's vector holds the TF-IDF weight (see TFIDFCalculator) of
+ * its terms, divided by the norm of the complete vector, which is computed
+ * once at build time. Only the MaxVectorTerms heaviest terms are kept:
+ * they carry most of a document's topic, and short vectors keep the index
+ * small and the dot products cheap. Vectors are stored sorted by term id,
+ * so two of them are compared with a merge-style sparse dot product that
+ * checks blocks of four term ids at once.
+ *
+ * Candidates come from per-term lists of the documents whose vector holds
+ * the term. A query only probes the lists of its ProbeTerms heaviest
+ * terms, so a document has to share an important term with the query to
+ * be considered at all, and only those few candidates are scored.
+ */
+class SimilarityIndex {
+public:
+    static constexpr size_t MaxVectorTerms = 128;
+    static constexpr size_t ProbeTerms = 16;
+
+    SimilarityIndex();
+
+    /**
+     * @brief Rebuilds the vectors from the documents' term frequencies.
+     *
+     * @param documents The indexed documents, by docId
+     */
+    void build(const std::vector<std::shared_ptr<Document>>& documents);
+
+    /**
+     * @brief Finds the documents most similar to an indexed document.
+     *
+     * @param docId The document to compare with
+     * @param k Number of documents wanted (0 for every candidate)
+     * @param results Receives the documents by descending cosine similarity, then ascending docId
+     */
+    void findSimilar(uint32_t docId, size_t k, std::vector<ScoredDocument>& results) const;
+
+    /**
+     * @brief Computes the cosine similarity of two indexed documents' pruned vectors.
+     *
+     * @param first Document identifier
+     * @param second Document identifier
+     * @return Similarity between 0 and 1, 0 for unknown documents
+     */
+    double getSimilarity(uint32_t first, uint32_t second) const;
+
+    /**
+     * @brief Gets the memory used by the vectors and candidate lists.
+     *
+     * @return Bytes used
+     */
+    size_t getMemoryUsage() const;
+
+    /**
+     * @brief Removes all vectors.
+     */
+    void clear();
+
+private:
+    std::vector<uint32_t> vectorStarts; // per docId, range in termIds and weights; documentCount + 1 entries
+    std::vector<uint32_t> termIds;      // ascending within each vector
+    std::vector<float> weights;         // normalized TF-IDF weight of each entry
+
+    std::vector<uint32_t> listStarts;   // per term id, range in listDocIds; termCount + 1 entries
+    std::vector<uint32_t> listDocIds;   // documents whose vector holds the term, ascending
+
+    /**
+     * @brief Computes the dot product of two sparse vectors.
+     *
+     * @param firstIds Term ids of the first vector, ascending
+     * @param firstWeights Weights of the first vector
+     * @param firstSize Number of entries of the first vector
+     * @param secondIds Term ids of the second vector, ascending
+     * @param secondWeights Weights of the second vector
+     * @param secondSize Number of entries of the second vector
+     * @return Sum of the weight products of the shared terms
+     */
+    static float dotProduct(const uint32_t* firstIds, const float* firstWeights, size_t firstSize,
+                            const uint32_t* secondIds, const float* secondWeights, size_t secondSize);
+};
+
+#endif // SIMILARITYINDEX_H
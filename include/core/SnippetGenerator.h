@@ -0,0 +1,51 @@
+#ifndef SNIPPETGENERATOR_H
+#define SNIPPETGENERATOR_H
+
+#include "DocumentIndexer.h"
+#include <string>
+#include <vector>
+
+/**
+ * @brief Builds query-biased text snippets for search hits.
+ *
+ * The best window is chosen from the positional postings of the query terms,
+ * and its text is located through the token offsets stored at indexing time,
+ * so only the bytes of the chosen window are read back.
+ */
+class SnippetGenerator {
+public:
+    /**
+     * @brief Constructor.
+     *
+     * @param indexer Reference to the document indexer
+     */
+    explicit SnippetGenerator(const DocumentIndexer& indexer);
+
+    /**
+     * @brief Generates the snippet that best covers the query terms.
+     *
+     * Windows are scored by the summed weight of the distinct terms they
+     * contain, with a small bonus for repeated hits.
+     *
+     * @param document The document
+     * @param terms Distinct query terms
+     * @param weights Weight of each term (e.g. its IDF)
+     * @return Snippet text, empty if the document has no stored offsets or no hits
+     */
+    std::string generate(const Document& document,
+                         const std::vector<std::string>& terms,
+                         const std::vector<double>& weights) const;
+
+    /**
+     * @brief Sets the snippet length in tokens.
+     *
+     * @param tokens Window size (minimum 1)
+     */
+    void setWindowSize(size_t tokens);
+
+private:
+    const DocumentIndexer& indexer;
+    size_t windowSize;
+};
+
+#endif // SNIPPETGENERATOR_H
@@ -0,0 +1,65 @@
+#ifndef STEMMER_H
+#define STEMMER_H
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <shared_mutex>
+#include <array>
+#include <cstddef>
+
+/**
+ * @brief Reduces English words to their stems with the Porter algorithm.
+ *
+ * "connect", "connected", "connecting" and "connections" all become
+ * "connect", so they share one posting list. Words containing anything but
+ * ASCII letters (after dropping a possessive "'s") are returned unchanged.
+ *
+ * Stems are memoized, so the cost of stemming is paid once per distinct
+ * word. The cache is split into independently locked parts and may be used
+ * from several threads at once.
+ */
+class Stemmer {
+public:
+    /**
+     * @brief Gets the stem of a lowercase word.
+     *
+     * @param word The word to stem
+     * @return The stem
+     */
+    std::string stem(std::string_view word) const;
+
+    /**
+     * @brief Gets the number of memoized stems.
+     *
+     * @return Number of cached words
+     */
+    size_t getCacheSize() const;
+
+    /**
+     * @brief Empties the memo cache.
+     */
+    void clearCache();
+
+private:
+    // Words beyond this per cache part are stemmed without being remembered
+    static constexpr size_t CachePartCount = 16;
+    static constexpr size_t MaxWordsPerPart = 64 * 1024;
+
+    struct CachePart {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, std::string> stems;
+    };
+
+    mutable std::array<CachePart, CachePartCount> cache;
+
+    /**
+     * @brief Runs the Porter algorithm without consulting the cache.
+     *
+     * @param word The word to stem
+     * @return The stem
+     */
+    static std::string computeStem(std::string_view word);
+};
+
+#endif // STEMMER_H
@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <unordered_set>
+#include <string_view>
 
 /**
  * @brief Removes common stop words from tokenized text.
@@ -32,10 +33,11 @@ public:
      * @param word The word to check
      * @return True if the word is a stop word, false otherwise
      */
-    bool isStopWord(const std::string& word) const;
+    bool isStopWord(std::string_view word) const;
 
 private:
     std::unordered_set<std::string> stopWords;
+    size_t longestStopWord;
     
     /**
      * @brief Initializes the stop word set with common English stop words.
@@ -48,6 +48,24 @@ public:
      */
     double calculateIDF(const std::string& term) const;
 
+    /**
+     * @brief Calculates term frequency (TF) from a document's counts.
+     * 
+     * @param count Occurrences of the term in the document
+     * @param totalTerms Number of terms in the document
+     * @return Term frequency (normalized)
+     */
+    static double calculateTF(int count, int totalTerms);
+
+    /**
+     * @brief Calculates inverse document frequency (IDF) from collection counts.
+     * 
+     * @param documentFrequency Number of documents containing the term
+     * @param totalDocuments Number of documents in the collection
+     * @return Inverse document frequency
+     */
+    static double calculateIDF(size_t documentFrequency, size_t totalDocuments);
+
     /**
      * @brief Gets the number of documents containing a term.
      * 
@@ -0,0 +1,191 @@
+#ifndef TERMDICTIONARY_H
+#define TERMDICTIONARY_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+class LevenshteinAutomaton;
+
+/**
+ * @brief A dictionary term found by fuzzy expansion.
+ */
+struct FuzzyTerm {
+    std::string term;
+    uint32_t distance; // edit distance to the query term
+};
+
+/**
+ * @brief Sorted, front-coded dictionary of index terms.
+ *
+ * Terms are stored in blocks of BlockSize. The first term of a block is kept
+ * whole; every following term only stores the length of the prefix it shares
+ * with its predecessor plus the remaining suffix. Lookups binary search the
+ * block heads and then decode at most one block, and in-order enumeration
+ * decodes each term with a single append, which makes prefix, wildcard and
+ * range expansion cheap.
+ */
+class TermDictionary {
+public:
+    static constexpr size_t BlockSize = 16;
+
+    /**
+     * @brief Forward cursor over the terms in sorted order.
+     */
+    class Iterator {
+    public:
+        /**
+         * @brief Checks whether the cursor points at a term.
+         *
+         * @return False once past the last term
+         */
+        bool valid() const { return dictionary != nullptr && ordinal < dictionary->termCount; }
+
+        /**
+         * @brief Gets the current term.
+         *
+         * @return The term (only meaningful while valid())
+         */
+        const std::string& term() const { return current; }
+
+        /**
+         * @brief Gets the rank of the current term in sorted order.
+         *
+         * @return The term ordinal
+         */
+        uint32_t getOrdinal() const { return ordinal; }
+
+        /**
+         * @brief Advances to the next term.
+         */
+        void next();
+
+    private:
+        friend class TermDictionary;
+
+        const TermDictionary* dictionary = nullptr;
+        uint32_t ordinal = 0;
+        size_t offset = 0; // byte offset of the next entry
+        std::string current;
+
+        void loadBlock(size_t block);
+    };
+
+    TermDictionary();
+
+    /**
+     * @brief Rebuilds the dictionary from a set of terms.
+     *
+     * @param terms Distinct terms in any order
+     */
+    void build(std::vector<std::string> terms);
+
+    /**
+     * @brief Gets the number of terms.
+     *
+     * @return Number of terms
+     */
+    size_t size() const;
+
+    /**
+     * @brief Gets the encoded size of the dictionary.
+     *
+     * @return Bytes used by term data and the block index
+     */
+    size_t getMemoryUsage() const;
+
+    /**
+     * @brief Looks up a term.
+     *
+     * @param term The term
+     * @param ordinal Receives the term's rank if found
+     * @return True if the term is in the dictionary
+     */
+    bool find(const std::string& term, uint32_t& ordinal) const;
+
+    /**
+     * @brief Gets a cursor on the first term.
+     *
+     * @return Iterator
+     */
+    Iterator begin() const;
+
+    /**
+     * @brief Gets a cursor on the first term not less than a target.
+     *
+     * @param target The target term
+     * @return Iterator, invalid if every term is smaller
+     */
+    Iterator seek(const std::string& target) const;
+
+    /**
+     * @brief Lists the terms starting with a prefix.
+     *
+     * @param prefix The prefix
+     * @param limit Maximum number of terms returned
+     * @return Matching terms in sorted order
+     */
+    std::vector<std::string> expandPrefix(const std::string& prefix, size_t limit) const;
+
+    /**
+     * @brief Lists the terms matching a wildcard pattern.
+     *
+     * `*` matches any sequence and `?` a single (UTF-8) character. Only the range of
+     * terms sharing the pattern's literal prefix is scanned, so a leading
+     * wildcard (`*timeout`) has to scan the whole dictionary.
+     *
+     * @param pattern The wildcard pattern
+     * @param limit Maximum number of terms returned
+     * @return Matching terms in sorted order
+     */
+    std::vector<std::string> expandWildcard(const std::string& pattern, size_t limit) const;
+
+    /**
+     * @brief Lists the terms in [lower, upper).
+     *
+     * @param lower Inclusive lower bound
+     * @param upper Exclusive upper bound, empty for no bound
+     * @param limit Maximum number of terms returned
+     * @return Terms in sorted order
+     */
+    std::vector<std::string> expandRange(const std::string& lower, const std::string& upper, size_t limit) const;
+
+    /**
+     * @brief Lists the terms accepted by a Levenshtein automaton.
+     *
+     * Walks the dictionary in sorted order, keeping the automaton state for
+     * each prefix of the current term so consecutive terms only step through
+     * the characters they do not share. When a prefix leads to a dead state,
+     * every term with that prefix is skipped with a single seek.
+     *
+     * @param automaton Automaton built for the query term
+     * @param limit Maximum number of terms returned
+     * @return The `limit` closest terms, ordered by distance, then by term
+     */
+    std::vector<FuzzyTerm> expandFuzzy(const LevenshteinAutomaton& automaton, size_t limit) const;
+
+    /**
+     * @brief Matches a term against a wildcard pattern.
+     *
+     * @param pattern Pattern with `*` and `?` wildcards
+     * @param term The term
+     * @return True if the whole term matches
+     */
+    static bool matchesWildcard(const std::string& pattern, const std::string& term);
+
+private:
+    std::string data;                  // front-coded blocks
+    std::vector<uint32_t> blockOffsets; // byte offset of each block in data
+    size_t termCount;
+
+    /**
+     * @brief Compares the first term of a block with a target, without decoding it.
+     *
+     * @param block Block index
+     * @param target The target term
+     * @return Negative, zero or positive like std::string::compare
+     */
+    int compareBlockHead(size_t block, const std::string& target) const;
+};
+
+#endif // TERMDICTIONARY_H
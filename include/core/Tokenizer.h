@@ -2,15 +2,38 @@
 #define TOKENIZER_H
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <memory_resource>
 #include <algorithm>
 #include <cctype>
+#include <cstdint>
+
+/**
+ * @brief Byte range [begin, end) of a token in the source text.
+ *
+ * Offsets are 32-bit, so spans can only describe texts of up to
+ * MaxTextSize bytes (4 GiB).
+ */
+struct TokenSpan {
+    static constexpr size_t MaxTextSize = UINT32_MAX;
+
+    uint32_t begin;
+    uint32_t end;
+};
 
 /**
  * @brief Tokenizes text into words by splitting on whitespace and punctuation.
  * 
  * This class provides functionality to break down text into individual tokens
  * (words) by removing punctuation and converting to lowercase.
+ *
+ * Text is read as UTF-8. Letters, digits and combining marks of any script
+ * form words, and words are case folded with a Unicode table ("Straße" and
+ * "STRASSE" both become "strasse"). CJK ideographs and hiragana are not
+ * separated by spaces, so each becomes a token of its own. Bytes that are
+ * not valid UTF-8 separate words. Blocks of pure ASCII text are classified
+ * and lowercased 16 bytes at a time.
  */
 class Tokenizer {
 public:
@@ -22,7 +45,30 @@ public:
      * @param text The input text to tokenize
      * @return Vector of tokenized words
      */
-    std::vector<std::string> tokenize(const std::string& text);
+    std::vector<std::string> tokenize(const std::string& text) const;
+
+    /**
+     * @brief Tokenizes a text string and records where each token came from.
+     * 
+     * @param text The input text to tokenize, at most TokenSpan::MaxTextSize bytes
+     * @param spans Receives the byte range of each returned token
+     * @return Vector of tokenized words
+     */
+    std::vector<std::string> tokenize(const std::string& text, std::vector<TokenSpan>& spans) const;
+
+    /**
+     * @brief Tokenizes a text string into caller-provided storage.
+     * 
+     * The tokens are allocated with the vector's allocator, so an arena
+     * backed vector keeps indexing scratch data off the heap.
+     * 
+     * @param text The input text to tokenize
+     * @param tokens Receives the tokenized words (appended)
+     * @param spans Receives the byte range of each token, or nullptr to skip them;
+     *              requires a text of at most TokenSpan::MaxTextSize bytes
+     */
+    void tokenize(std::string_view text, std::pmr::vector<std::pmr::string>& tokens,
+                  std::vector<TokenSpan>* spans) const;
 
     /**
      * @brief Checks if a character is alphanumeric.
@@ -32,7 +78,48 @@ public:
      */
     static bool isAlphanumeric(char c);
 
+    /**
+     * @brief Appends the case-folded word characters of a text, dropping everything else.
+     * 
+     * Normalizes text the same way tokenize() normalizes the words it
+     * finds, e.g. for the literal parts of a wildcard pattern.
+     * 
+     * @param text UTF-8 text
+     * @param folded Receives the folded word characters (appended)
+     */
+    static void foldWord(std::string_view text, std::string& folded);
+
+    /**
+     * @brief Decodes the UTF-8 character at the start of a text.
+     * 
+     * A byte that does not start a valid sequence decodes on its own to
+     * 0xDC00 + byte, a lone surrogate that no valid character decodes to.
+     * 
+     * @param text UTF-8 text, not empty
+     * @param codePoint Receives the character
+     * @return Number of bytes consumed
+     */
+    static size_t decodeCharacter(std::string_view text, uint32_t& codePoint);
+
+    /**
+     * @brief Counts the characters of a UTF-8 text, as decodeCharacter() splits them.
+     * 
+     * @param text UTF-8 text
+     * @return Number of characters
+     */
+    static size_t countCharacters(std::string_view text);
+
 private:
+    /**
+     * @brief Shared tokenization loop.
+     * 
+     * @param text The input text to tokenize
+     * @param tokens Receives the tokenized words
+     * @param spans Receives token byte ranges, or nullptr to skip them
+     */
+    template <typename Tokens>
+    void tokenizeText(std::string_view text, Tokens& tokens, std::vector<TokenSpan>* spans) const;
+
     /**
      * @brief Converts a string to lowercase.
      * 
@@ -0,0 +1,151 @@
+#ifndef DOCUMENTPREVIEW_H
+#define DOCUMENTPREVIEW_H
+
+#include <QPlainTextEdit>
+#include <QFile>
+#include <QStringList>
+#include <deque>
+#include <functional>
+
+class TermHighlighter;
+
+/**
+ * @brief Read-only document viewer that loads large files a chunk at a time.
+ *
+ * The file is memory-mapped (or, for documents held elsewhere, read through a
+ * TextReader) and only a window around the first query hit is decoded into
+ * the editor. Neighbouring chunks are loaded as the user scrolls
+ * towards either end, and chunks far from the viewport are dropped again so
+ * the editor never holds more than a bounded amount of text. Query terms are
+ * highlighted in whatever text is currently loaded.
+ */
+class DocumentPreview : public QPlainTextEdit {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Reads length bytes of the document's text starting at offset.
+     */
+    using TextReader = std::function<QByteArray(qint64 offset, qint64 length)>;
+
+    /**
+     * @brief Constructor.
+     *
+     * @param parent Parent widget
+     */
+    explicit DocumentPreview(QWidget* parent = nullptr);
+
+    /**
+     * @brief Destructor.
+     */
+    ~DocumentPreview();
+
+    /**
+     * @brief Shows a document, positioned at the first occurrence of a query term.
+     *
+     * @param filePath Path to the document file
+     * @param terms Query terms to locate and highlight
+     * @return True if the file could be opened, false otherwise
+     */
+    bool showDocument(const QString& filePath, const QStringList& terms);
+
+    /**
+     * @brief Shows a document read through a reader instead of a file.
+     *
+     * @param size Size of the document text in bytes
+     * @param textReader Reads ranges of the text
+     * @param terms Query terms to locate and highlight
+     * @return True if the document could be shown
+     */
+    bool showDocument(qint64 size, TextReader textReader, const QStringList& terms);
+
+    /**
+     * @brief Unloads the current document and clears the view.
+     */
+    void clearDocument();
+
+private slots:
+    /**
+     * @brief Loads or drops chunks when the view scrolls near a loaded edge.
+     *
+     * @param value Current vertical scroll bar value
+     */
+    void onScrolled(int value);
+
+private:
+    /**
+     * @brief A contiguous, line-aligned byte range of the file shown in the editor.
+     */
+    struct Chunk {
+        qint64 begin;
+        qint64 end;
+        int lineCount;
+    };
+
+    QFile file;
+    uchar* mapped;
+    TextReader reader;
+    qint64 fileSize;
+    std::deque<Chunk> chunks;
+    QStringList highlightTerms;
+    TermHighlighter* highlighter;
+    bool loading;
+
+    /**
+     * @brief Loads the first chunk of the opened document and scrolls to the first hit.
+     *
+     * @param terms Query terms to locate and highlight
+     * @return True (the document is shown)
+     */
+    bool showFirstChunk(const QStringList& terms);
+
+    /**
+     * @brief Reads a byte range, from the mapping or reader when available.
+     *
+     * @param offset Start offset in the file
+     * @param length Number of bytes
+     * @return The bytes read
+     */
+    QByteArray readBytes(qint64 offset, qint64 length);
+
+    /**
+     * @brief Finds the earliest occurrence of any query term in the file.
+     *
+     * @return Byte offset of the first hit, -1 if none found
+     */
+    qint64 findFirstHit();
+
+    /**
+     * @brief Computes the end of a chunk starting at an offset.
+     *
+     * The end is moved forward to the next line break so chunks always
+     * contain whole lines.
+     *
+     * @param begin Chunk start offset
+     * @return Chunk end offset (exclusive)
+     */
+    qint64 chunkEndFrom(qint64 begin);
+
+    /**
+     * @brief Computes the start of a chunk ending at an offset.
+     *
+     * @param end Chunk end offset (exclusive)
+     * @return Chunk start offset, aligned to a line start
+     */
+    qint64 chunkBeginBefore(qint64 end);
+
+    /**
+     * @brief Decodes a chunk into display text ending with a line break.
+     *
+     * @param chunk The chunk to decode
+     * @return Chunk text
+     */
+    QString chunkText(Chunk& chunk);
+
+    void appendChunk();
+    void prependChunk();
+    void dropFrontChunk();
+    void dropBackChunk();
+};
+
+#endif // DOCUMENTPREVIEW_H
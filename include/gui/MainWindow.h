@@ -3,7 +3,7 @@
 
 #include <QMainWindow>
 #include <QLineEdit>
-#include <QListWidget>
+#include <QListView>
 #include <QPushButton>
 #include <QLabel>
 #include <QTextEdit>
@@ -16,6 +16,8 @@
 #include <QThread>
 #include <QStringList>
 #include "core/SearchEngine.h"
+#include "gui/ResultListModel.h"
+#include "gui/DocumentPreview.h"
 
 /**
  * @brief Main window class for the search engine GUI application.
@@ -56,11 +58,19 @@ private slots:
     void onClearIndexClicked();
 
     /**
-     * @brief Slot called when a result item is selected.
+     * @brief Slot called when the more like this button is clicked.
      * 
-     * @param item The selected list item
+     * Replaces the results with the documents most similar to the
+     * selected one.
      */
-    void onResultSelected(QListWidgetItem* item);
+    void onMoreLikeThisClicked();
+
+    /**
+     * @brief Slot called when a result row is selected.
+     * 
+     * @param index The selected model index
+     */
+    void onResultSelected(const QModelIndex& index);
 
 private:
     // UI Components
@@ -73,10 +83,12 @@ private:
     QPushButton* searchButton;
     QPushButton* loadFilesButton;
     QPushButton* clearIndexButton;
+    QPushButton* moreLikeThisButton;
     
     QLabel* resultsLabel;
-    QListWidget* resultsList;
-    QTextEdit* documentPreview;
+    QListView* resultsList;
+    ResultListModel* resultsModel;
+    DocumentPreview* documentPreview;
     
     QLabel* statusLabel;
     QProgressBar* progressBar;
@@ -84,6 +96,12 @@ private:
     // Search Engine
     SearchEngine searchEngine;
     
+    // Terms of the last query, highlighted in the preview
+    QStringList currentQueryTerms;
+    
+    // Compressed copy of the indexed text, removed when the window closes
+    QString documentStorePath;
+    
     /**
      * @brief Sets up the user interface.
      */
@@ -99,24 +117,24 @@ private:
     /**
      * @brief Updates the results display.
      * 
+     * Ownership of the results moves into the list model, which formats
+     * rows lazily as they become visible.
+     * 
      * @param results Vector of search results
      */
-    void displayResults(const std::vector<SearchResult>& results);
+    void displayResults(std::vector<SearchResult> results);
     
     /**
      * @brief Displays document content in the preview area.
      * 
-     * @param filePath Path to the document file
-     */
-    void displayDocumentPreview(const QString& filePath);
-    
-    /**
-     * @brief Formats a search result for display in the list.
+     * Only the part of the file around the first query hit is loaded;
+     * the rest is loaded as the user scrolls.
+     * The text comes from the engine's document store when it holds a
+     * copy, otherwise from the original file.
      * 
-     * @param result The search result
-     * @return Formatted string
+     * @param docId Document of the selected result
      */
-    QString formatResult(const SearchResult& result);
+    void displayDocumentPreview(uint32_t docId);
 };
 
 #endif // MAINWINDOW_H
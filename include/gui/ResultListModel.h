@@ -0,0 +1,130 @@
+#ifndef RESULTLISTMODEL_H
+#define RESULTLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QString>
+#include <vector>
+#include <functional>
+#include "core/SearchEngine.h"
+
+/**
+ * @brief List model exposing search results to a view without materializing widgets.
+ *
+ * Results are kept as plain SearchResult values; display strings are only
+ * formatted when the view asks for a visible row. Rows are exposed in pages
+ * through canFetchMore()/fetchMore(), so the view grows as the user scrolls
+ * instead of laying out the full result set up front. Document names and
+ * snippets are requested one page at a time, as rows are fetched.
+ */
+class ResultListModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Produces snippets for results [offset, offset + count).
+     */
+    using SnippetProvider = std::function<std::vector<std::string>(
+        const std::vector<SearchResult>& results, size_t offset, size_t count)>;
+
+    /**
+     * @brief Looks up the document behind a result.
+     */
+    using DocumentResolver = std::function<std::shared_ptr<Document>(uint32_t docId)>;
+
+    /**
+     * @brief Constructor.
+     *
+     * @param parent Parent object
+     */
+    explicit ResultListModel(QObject* parent = nullptr);
+
+    /**
+     * @brief Replaces the current result set.
+     *
+     * Only the first page of rows is exposed until the view requests more.
+     *
+     * @param newResults Search results sorted by relevance
+     */
+    void setResults(std::vector<SearchResult> newResults);
+
+    /**
+     * @brief Sets the function used to generate snippets for fetched rows.
+     *
+     * @param provider Snippet provider, or an empty function to show none
+     */
+    void setSnippetProvider(SnippetProvider provider);
+
+    /**
+     * @brief Sets the function used to look up the documents of fetched rows.
+     *
+     * @param resolver Document resolver
+     */
+    void setDocumentResolver(DocumentResolver resolver);
+
+    /**
+     * @brief Removes all results from the model.
+     */
+    void clear();
+
+    /**
+     * @brief Gets the total number of results, including rows not yet fetched.
+     *
+     * @return Number of results
+     */
+    size_t getTotalCount() const;
+
+    /**
+     * @brief Gets the result backing a row.
+     *
+     * @param row Row index
+     * @return Pointer to the result, nullptr if row is out of range
+     */
+    const SearchResult* resultAt(int row) const;
+
+    /**
+     * @brief Sets the number of rows exposed per fetchMore() call.
+     *
+     * @param size Page size (minimum 1)
+     */
+    void setPageSize(int size);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+
+private:
+    /**
+     * @brief Display data of a fetched row.
+     */
+    struct Row {
+        QString fileName;
+        QString filePath;
+        QString snippet;
+    };
+
+    std::vector<SearchResult> results;
+    std::vector<Row> rows; // one per fetched result
+    SnippetProvider snippetProvider;
+    DocumentResolver documentResolver;
+    int loadedRows;
+    int pageSize;
+
+    /**
+     * @brief Resolves documents and loads snippets for newly exposed rows.
+     *
+     * @param first First row not loaded yet
+     * @param count Number of rows
+     */
+    void loadRows(int first, int count);
+
+    /**
+     * @brief Formats a search result for display in the list.
+     *
+     * @param row Row of the result
+     * @return Formatted string
+     */
+    QString formatResult(int row) const;
+};
+
+#endif // RESULTLISTMODEL_H
@@ -1,18 +1,53 @@
 #include "core/DocumentIndexer.h"
-#include <sstream>
+#include "core/FileLoader.h"
 #include <filesystem>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_set>
+
+/**
+ * @brief A document tokenized but not yet added to the index.
+ */
+struct DocumentIndexer::ParsedDocument {
+    std::shared_ptr<Document> document;
+    std::pmr::vector<std::pmr::string> tokens;
+    std::pmr::vector<std::string_view> terms; // views into tokens, stop words removed
+    std::pmr::vector<uint32_t> positions;
+    std::pmr::string storedText; // compressed for the document store
+    DuplicateDetector::Signature signature;
+
+    explicit ParsedDocument(std::pmr::memory_resource* arena)
+        : document(std::make_shared<Document>()), tokens(arena), terms(arena), positions(arena),
+          storedText(arena) {}
+};
+
+/**
+ * @brief Buffer and arena a file holds from its read until it is indexed.
+ */
+struct DocumentIndexer::IngestionSlot {
+    std::string content;
+    ScratchArena arena;
+    std::optional<ParsedDocument> parsed;
+    bool loaded = false; // the read succeeded
+};
 
 DocumentIndexer::DocumentIndexer() 
     : tokenizer(std::make_unique<Tokenizer>()),
-      stopWordRemover(std::make_unique<StopWordRemover>()) {
+      stopWordRemover(std::make_unique<StopWordRemover>()),
+      stemmer(std::make_unique<Stemmer>()),
+      positionalIndexing(true),
+      stemming(false),
+      storingText(false),
+      indexingDuplicates(true),
+      ingestionThreads(0),
+      readQueueDepth(32) {
 }
 
 bool DocumentIndexer::indexDocument(const std::string& filePath) {
-    std::string content = readFile(filePath);
-    if (content.empty()) {
-        return false;
-    }
-    
     // Check if document already indexed
     for (const auto& doc : documents) {
         if (doc->filePath == filePath) {
@@ -20,33 +55,156 @@ bool DocumentIndexer::indexDocument(const std::string& filePath) {
         }
     }
     
-    auto document = std::make_shared<Document>();
-    document->filePath = filePath;
-    
-    // Extract filename from path
-    std::filesystem::path path(filePath);
-    document->fileName = path.filename().string();
-    
-    // Tokenize
-    document->tokens = tokenizer->tokenize(content);
-    
-    // Remove stop words
-    document->tokens = stopWordRemover->removeStopWords(document->tokens);
-    
-    // Build term frequency map
-    document->termFrequency = buildTermFrequency(document->tokens);
-    document->totalTerms = document->tokens.size();
-    
-    documents.push_back(document);
-    return true;
+    bool indexed = false;
+    {
+        std::pmr::string content(scratch.getResource());
+        if (readFile(filePath, content) && !content.empty()) {
+            ParsedDocument parsed(scratch.getResource());
+            parseDocument(filePath, content, parsed);
+            commitDocument(parsed);
+            indexed = true;
+        }
+    }
+    scratch.release();
+    return indexed;
 }
 
 int DocumentIndexer::indexDocuments(const std::vector<std::string>& filePaths) {
+    // Files already indexed count as indexed, like in indexDocument(); so do
+    // repeats within the batch, once their first occurrence has been indexed
     int count = 0;
+    std::unordered_set<std::string> indexed;
+    for (const auto& doc : documents) {
+        indexed.insert(doc->filePath);
+    }
+    std::vector<std::string> pending;
+    std::unordered_map<std::string, size_t> firstOccurrence;
+    std::vector<size_t> repeats; // pending index of the first occurrence of each repeat
     for (const auto& path : filePaths) {
-        if (indexDocument(path)) {
+        if (indexed.count(path)) {
+            count++;
+            continue;
+        }
+        auto inserted = firstOccurrence.emplace(path, pending.size());
+        if (inserted.second) {
+            pending.push_back(path);
+        } else {
+            repeats.push_back(inserted.first->second);
+        }
+    }
+    if (pending.empty()) {
+        return count;
+    }
+    
+    size_t workerCount = ingestionThreads > 0
+        ? ingestionThreads
+        : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    workerCount = std::min(workerCount, pending.size());
+    
+    // Enough slots to keep every read and every worker busy; they bound the memory in flight
+    size_t slotCount = std::min(pending.size(), readQueueDepth + 2 * workerCount);
+    std::vector<std::unique_ptr<IngestionSlot>> slots;
+    std::vector<IngestionSlot*> freeSlots;
+    for (size_t i = 0; i < slotCount; ++i) {
+        slots.push_back(std::make_unique<IngestionSlot>());
+        freeSlots.push_back(slots.back().get());
+    }
+    
+    std::mutex mutex;
+    std::condition_variable slotFreed;
+    std::condition_variable fileLoaded;
+    std::condition_variable documentParsed;
+    std::vector<IngestionSlot*> assigned(pending.size(), nullptr);
+    std::vector<char> parsed(pending.size(), 0);
+    std::vector<char> committed(pending.size(), 0);
+    std::deque<size_t> loaded; // read, waiting for a worker
+    bool loadingDone = false;
+    
+    // Reader: slots are handed out in file order, so the next file to commit always holds one
+    auto acquire = [&](size_t index, bool wait) -> std::string* {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (freeSlots.empty()) {
+            if (!wait) {
+                return nullptr;
+            }
+            slotFreed.wait(lock, [&]() { return !freeSlots.empty(); });
+        }
+        IngestionSlot* slot = freeSlots.back();
+        freeSlots.pop_back();
+        assigned[index] = slot;
+        return &slot->content;
+    };
+    auto complete = [&](size_t index, bool ok) {
+        std::lock_guard<std::mutex> lock(mutex);
+        assigned[index]->loaded = ok;
+        loaded.push_back(index);
+        fileLoaded.notify_one();
+    };
+    FileLoader loader(readQueueDepth);
+    std::thread reader([&]() {
+        loader.load(pending, acquire, complete);
+        std::lock_guard<std::mutex> lock(mutex);
+        loadingDone = true;
+        fileLoaded.notify_all();
+    });
+    
+    // Workers: tokenize files in whatever order their reads finish
+    auto parse = [&]() {
+        for (;;) {
+            size_t index = 0;
+            IngestionSlot* slot = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                fileLoaded.wait(lock, [&]() { return !loaded.empty() || loadingDone; });
+                if (loaded.empty()) {
+                    return;
+                }
+                index = loaded.front();
+                loaded.pop_front();
+                slot = assigned[index];
+            }
+            if (slot->loaded && !slot->content.empty()) {
+                slot->parsed.emplace(slot->arena.getResource());
+                parseDocument(pending[index], slot->content, *slot->parsed);
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            parsed[index] = 1;
+            documentParsed.notify_all();
+        }
+    };
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers.emplace_back(parse);
+    }
+    
+    // Commit in file order so docIds do not depend on which read finished first
+    for (size_t index = 0; index < pending.size(); ++index) {
+        IngestionSlot* slot = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            documentParsed.wait(lock, [&]() { return parsed[index] != 0; });
+            slot = assigned[index];
+        }
+        if (slot->parsed) {
+            commitDocument(*slot->parsed);
+            slot->parsed.reset();
+            committed[index] = 1;
             count++;
         }
+        slot->arena.release();
+        slot->loaded = false;
+        
+        std::lock_guard<std::mutex> lock(mutex);
+        freeSlots.push_back(slot);
+        slotFreed.notify_one();
+    }
+    
+    reader.join();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (size_t first : repeats) {
+        count += committed[first];
     }
     return count;
 }
@@ -61,6 +219,9 @@ size_t DocumentIndexer::getDocumentCount() const {
 
 void DocumentIndexer::clear() {
     documents.clear();
+    invertedIndex.clear();
+    documentStore.clear();
+    duplicateDetector.clear();
 }
 
 std::shared_ptr<Document> DocumentIndexer::getDocument(const std::string& filePath) const {
@@ -72,22 +233,183 @@ std::shared_ptr<Document> DocumentIndexer::getDocument(const std::string& filePa
     return nullptr;
 }
 
-std::string DocumentIndexer::readFile(const std::string& filePath) const {
-    std::ifstream file(filePath);
+const InvertedIndex& DocumentIndexer::getInvertedIndex() const {
+    return invertedIndex;
+}
+
+std::string DocumentIndexer::readDocumentText(const Document& document, size_t offset, size_t length) const {
+    std::string text;
+    if (documentStore.read(document.docId, offset, length, text)) {
+        return text;
+    }
+    
+    std::ifstream file(document.filePath, std::ios::binary);
     if (!file.is_open()) {
         return "";
     }
     
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    return buffer.str();
+    text.assign(length, '\0');
+    file.seekg(static_cast<std::streamoff>(offset));
+    file.read(&text[0], static_cast<std::streamsize>(length));
+    text.resize(static_cast<size_t>(std::max<std::streamsize>(file.gcount(), 0)));
+    return text;
+}
+
+void DocumentIndexer::reorderDocuments(DocumentOrder order, const std::vector<double>& staticRanks) {
+    if (documents.size() < 2) {
+        return;
+    }
+    
+    std::vector<uint32_t> newIds = DocumentReorderer().computeOrder(invertedIndex, documents, order, staticRanks);
+    invertedIndex.remapDocuments(newIds);
+    documentStore.remapDocuments(newIds);
+    duplicateDetector.remapDocuments(newIds);
+    
+    std::vector<std::shared_ptr<Document>> reordered(documents.size());
+    for (size_t docId = 0; docId < documents.size(); ++docId) {
+        documents[docId]->docId = newIds[docId];
+        reordered[newIds[docId]] = std::move(documents[docId]);
+    }
+    documents = std::move(reordered);
+}
+
+void DocumentIndexer::setPositionalIndexing(bool enabled) {
+    positionalIndexing = enabled;
+}
+
+bool DocumentIndexer::isPositionalIndexing() const {
+    return positionalIndexing;
+}
+
+void DocumentIndexer::setStemming(bool enabled) {
+    stemming = enabled;
+}
+
+const Stemmer* DocumentIndexer::getStemmer() const {
+    return stemming ? stemmer.get() : nullptr;
+}
+
+bool DocumentIndexer::setDocumentStore(const std::string& path) {
+    if (path.empty()) {
+        documentStore.close();
+        storingText = false;
+        return true;
+    }
+    storingText = documentStore.open(path);
+    return storingText;
+}
+
+bool DocumentIndexer::isDocumentStored(uint32_t docId) const {
+    return documentStore.contains(docId);
+}
+
+const DuplicateDetector& DocumentIndexer::getDuplicateDetector() const {
+    return duplicateDetector;
+}
+
+void DocumentIndexer::setDuplicateThreshold(double similarity) {
+    duplicateDetector.setThreshold(similarity);
+}
+
+void DocumentIndexer::setIndexingDuplicates(bool enabled) {
+    indexingDuplicates = enabled;
+}
+
+void DocumentIndexer::setIngestionThreads(size_t threads) {
+    ingestionThreads = threads;
+}
+
+void DocumentIndexer::setReadQueueDepth(size_t depth) {
+    readQueueDepth = std::max<size_t>(depth, 1);
+}
+
+void DocumentIndexer::parseDocument(const std::string& filePath, std::string_view content,
+                                    ParsedDocument& parsed) const {
+    Document& document = *parsed.document;
+    document.filePath = filePath;
+    
+    // Extract filename from path
+    std::filesystem::path path(filePath);
+    document.fileName = path.filename().string();
+    document.textSize = content.size();
+    
+    // Compress here, on the parsing thread, so committing only appends
+    if (storingText) {
+        DocumentStore::encode(content, parsed.storedText);
+    }
+    
+    // Tokenize, keeping token offsets for snippets when positions are recorded.
+    // Offsets are 32-bit, so larger documents are indexed without snippets
+    bool keepSpans = positionalIndexing && content.size() <= TokenSpan::MaxTextSize;
+    tokenizer->tokenize(content, parsed.tokens, keepSpans ? &document.tokenSpans : nullptr);
+    
+    // Remove stop words, remembering where each kept token stood so phrase
+    // queries see the same gaps as the original text
+    parsed.terms.reserve(parsed.tokens.size());
+    for (size_t i = 0; i < parsed.tokens.size(); ++i) {
+        if (stopWordRemover->isStopWord(parsed.tokens[i])) {
+            continue;
+        }
+        if (stemming) {
+            parsed.tokens[i].assign(stemmer->stem(parsed.tokens[i]));
+        }
+        if (positionalIndexing) {
+            parsed.positions.push_back(static_cast<uint32_t>(i));
+        }
+        parsed.terms.push_back(parsed.tokens[i]);
+    }
+    
+    // Build term frequency map
+    document.termFrequency = buildTermFrequency(parsed.terms);
+    document.totalTerms = static_cast<int>(parsed.terms.size());
+    DuplicateDetector::computeSignature(document.termFrequency, parsed.signature);
+}
+
+void DocumentIndexer::commitDocument(ParsedDocument& parsed) {
+    parsed.document->docId = static_cast<uint32_t>(documents.size());
+    uint32_t cluster = duplicateDetector.add(parsed.document->docId, parsed.signature);
+    if (indexingDuplicates || cluster == parsed.document->docId) {
+        invertedIndex.addDocument(parsed.document->docId, parsed.terms, parsed.positions);
+    }
+    if (storingText) {
+        documentStore.add(parsed.document->docId, parsed.storedText);
+    }
+    documents.push_back(std::move(parsed.document));
+}
+
+bool DocumentIndexer::readFile(const std::string& filePath, std::pmr::string& content) const {
+    // Binary mode keeps token offsets valid for later partial reads
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(filePath, error)) {
+        return false;
+    }
+    std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return false;
+    }
+    
+    std::streamoff size = file.tellg();
+    if (size < 0) {
+        return false;
+    }
+    content.resize(static_cast<size_t>(size));
+    file.seekg(0);
+    file.read(&content[0], static_cast<std::streamsize>(size));
+    content.resize(static_cast<size_t>(std::max<std::streamsize>(file.gcount(), 0)));
+    return true;
 }
 
-std::unordered_map<std::string, int> DocumentIndexer::buildTermFrequency(const std::vector<std::string>& tokens) const {
+std::unordered_map<std::string, int> DocumentIndexer::buildTermFrequency(const std::pmr::vector<std::string_view>& terms) const {
+    // Count in the arena first so each distinct term is copied to the heap once
+    std::pmr::unordered_map<std::string_view, int> counts(terms.get_allocator().resource());
+    for (const auto& term : terms) {
+        counts[term]++;
+    }
+    
     std::unordered_map<std::string, int> tf;
-    for (const auto& token : tokens) {
-        tf[token]++;
+    tf.reserve(counts.size());
+    for (const auto& entry : counts) {
+        tf.emplace(std::string(entry.first), entry.second);
     }
     return tf;
 }
-
@@ -0,0 +1,221 @@
+#include "core/DocumentReorderer.h"
+#include "core/DocumentIndexer.h"
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <numeric>
+
+namespace {
+
+// Bisections down to this depth run their halves on separate threads
+constexpr size_t ParallelDepth = 3;
+
+// Static-rank ordering bisects within this many consecutive tiers of documents
+constexpr size_t StaticRankTiers = 8;
+
+/**
+ * @brief Per-thread buffers of one bisection, sized by the number of terms.
+ *
+ * Only the terms of the partition being split are touched, and they are
+ * reset afterwards, so deep levels with small partitions stay cheap.
+ */
+struct BisectionScratch {
+    std::vector<int32_t> leftDegrees;
+    std::vector<int32_t> rightDegrees;
+    std::vector<float> leftGains;  // per term: cost saved by moving one of its documents right
+    std::vector<float> rightGains; // per term: cost saved by moving one of its documents left
+    std::vector<uint32_t> touched;
+    std::vector<std::pair<float, size_t>> left;  // gain, position
+    std::vector<std::pair<float, size_t>> right;
+
+    void prepare(size_t termCount) {
+        if (leftDegrees.size() < termCount) {
+            leftDegrees.resize(termCount, 0);
+            rightDegrees.resize(termCount, 0);
+            leftGains.resize(termCount, 0.0f);
+            rightGains.resize(termCount, 0.0f);
+        }
+    }
+};
+
+BisectionScratch& getBisectionScratch() {
+    thread_local BisectionScratch scratch;
+    return scratch;
+}
+
+/**
+ * @brief Estimated bits to encode the gaps of a term with degree documents in a partition.
+ */
+double gapCost(double degree, double size) {
+    return degree * std::log2(size / (degree + 1.0));
+}
+
+} // namespace
+
+DocumentReorderer::DocumentReorderer(size_t iterations, size_t leafSize)
+    : iterations(iterations), leafSize(std::max<size_t>(leafSize, 2)) {
+}
+
+std::vector<uint32_t> DocumentReorderer::computeOrder(const InvertedIndex& index,
+                                                      const std::vector<std::shared_ptr<Document>>& documents,
+                                                      DocumentOrder order,
+                                                      const std::vector<double>& staticRanks) const {
+    size_t count = documents.size();
+    std::vector<uint32_t> ordered(count);
+    std::iota(ordered.begin(), ordered.end(), 0);
+    std::stable_sort(ordered.begin(), ordered.end(), [&documents](uint32_t a, uint32_t b) {
+        return documents[a]->filePath < documents[b]->filePath;
+    });
+
+    if (order == DocumentOrder::GraphBisection && count > leafSize) {
+        bisect(buildForwardIndex(index, count), ordered, 0, count, 0);
+    } else if (order == DocumentOrder::StaticRank) {
+        auto rankOf = [&staticRanks](uint32_t docId) {
+            return docId < staticRanks.size() ? staticRanks[docId] : 0.0;
+        };
+        std::stable_sort(ordered.begin(), ordered.end(), [&rankOf](uint32_t a, uint32_t b) {
+            return rankOf(a) > rankOf(b);
+        });
+
+        // Tiers are bisected one after the other; each still forks its top levels
+        size_t tierSize = (count + StaticRankTiers - 1) / StaticRankTiers;
+        if (tierSize > leafSize) {
+            ForwardIndex forward = buildForwardIndex(index, count);
+            for (size_t begin = 0; begin < count; begin += tierSize) {
+                bisect(forward, ordered, begin, std::min(count, begin + tierSize), 0);
+            }
+        }
+    }
+
+    std::vector<uint32_t> newIds(count);
+    for (size_t position = 0; position < count; ++position) {
+        newIds[ordered[position]] = static_cast<uint32_t>(position);
+    }
+    return newIds;
+}
+
+DocumentReorderer::ForwardIndex DocumentReorderer::buildForwardIndex(const InvertedIndex& index, size_t count) {
+    // Terms found in a single document cannot bring documents together
+    std::vector<const PostingList*> lists;
+    ForwardIndex forward;
+    forward.starts.assign(count + 1, 0);
+    const TermDictionary& dictionary = index.getTermDictionary();
+    for (TermDictionary::Iterator it = dictionary.begin(); it.valid(); it.next()) {
+        const PostingList* list = index.getPostings(it.term());
+        if (!list || list->size() < 2) {
+            continue;
+        }
+        lists.push_back(list);
+        for (uint32_t docId : list->docIds) {
+            if (docId < count) {
+                forward.starts[docId + 1]++;
+            }
+        }
+    }
+    std::partial_sum(forward.starts.begin(), forward.starts.end(), forward.starts.begin());
+
+    forward.termCount = lists.size();
+    forward.terms.resize(forward.starts[count]);
+    std::vector<uint32_t> fill(forward.starts.begin(), forward.starts.end() - 1);
+    for (size_t term = 0; term < lists.size(); ++term) {
+        for (uint32_t docId : lists[term]->docIds) {
+            if (docId < count) {
+                forward.terms[fill[docId]++] = static_cast<uint32_t>(term);
+            }
+        }
+    }
+    return forward;
+}
+
+void DocumentReorderer::bisect(const ForwardIndex& forward, std::vector<uint32_t>& documents,
+                               size_t begin, size_t end, size_t depth) const {
+    if (end - begin <= leafSize) {
+        return;
+    }
+    size_t middle = begin + (end - begin) / 2;
+
+    BisectionScratch& scratch = getBisectionScratch();
+    scratch.prepare(forward.termCount);
+    auto termsBegin = [&forward](uint32_t docId) { return forward.terms.data() + forward.starts[docId]; };
+    auto termsEnd = [&forward](uint32_t docId) { return forward.terms.data() + forward.starts[docId + 1]; };
+
+    for (size_t position = begin; position < end; ++position) {
+        std::vector<int32_t>& degrees = position < middle ? scratch.leftDegrees : scratch.rightDegrees;
+        for (const uint32_t* t = termsBegin(documents[position]); t != termsEnd(documents[position]); ++t) {
+            if (scratch.leftDegrees[*t] == 0 && scratch.rightDegrees[*t] == 0) {
+                scratch.touched.push_back(*t);
+            }
+            degrees[*t]++;
+        }
+    }
+
+    double leftSize = static_cast<double>(middle - begin);
+    double rightSize = static_cast<double>(end - middle);
+    for (size_t iteration = 0; iteration < iterations; ++iteration) {
+        for (uint32_t term : scratch.touched) {
+            double l = scratch.leftDegrees[term];
+            double r = scratch.rightDegrees[term];
+            double current = gapCost(l, leftSize) + gapCost(r, rightSize);
+            scratch.leftGains[term] = l > 0 ?
+                static_cast<float>(current - gapCost(l - 1, leftSize) - gapCost(r + 1, rightSize)) : 0.0f;
+            scratch.rightGains[term] = r > 0 ?
+                static_cast<float>(current - gapCost(l + 1, leftSize) - gapCost(r - 1, rightSize)) : 0.0f;
+        }
+
+        scratch.left.clear();
+        scratch.right.clear();
+        for (size_t position = begin; position < end; ++position) {
+            bool isLeft = position < middle;
+            const std::vector<float>& gains = isLeft ? scratch.leftGains : scratch.rightGains;
+            float gain = 0.0f;
+            for (const uint32_t* t = termsBegin(documents[position]); t != termsEnd(documents[position]); ++t) {
+                gain += gains[*t];
+            }
+            (isLeft ? scratch.left : scratch.right).push_back({gain, position});
+        }
+        auto byGain = [](const std::pair<float, size_t>& a, const std::pair<float, size_t>& b) {
+            return a.first > b.first;
+        };
+        std::sort(scratch.left.begin(), scratch.left.end(), byGain);
+        std::sort(scratch.right.begin(), scratch.right.end(), byGain);
+
+        // Swap the most eager pairs while the exchange still lowers the cost
+        size_t swaps = 0;
+        size_t pairs = std::min(scratch.left.size(), scratch.right.size());
+        while (swaps < pairs && scratch.left[swaps].first + scratch.right[swaps].first > 0.0f) {
+            uint32_t& movingRight = documents[scratch.left[swaps].second];
+            uint32_t& movingLeft = documents[scratch.right[swaps].second];
+            for (const uint32_t* t = termsBegin(movingRight); t != termsEnd(movingRight); ++t) {
+                scratch.leftDegrees[*t]--;
+                scratch.rightDegrees[*t]++;
+            }
+            for (const uint32_t* t = termsBegin(movingLeft); t != termsEnd(movingLeft); ++t) {
+                scratch.rightDegrees[*t]--;
+                scratch.leftDegrees[*t]++;
+            }
+            std::swap(movingRight, movingLeft);
+            swaps++;
+        }
+        if (swaps == 0) {
+            break;
+        }
+    }
+
+    for (uint32_t term : scratch.touched) {
+        scratch.leftDegrees[term] = 0;
+        scratch.rightDegrees[term] = 0;
+    }
+    scratch.touched.clear();
+
+    // The halves are disjoint ranges of documents, so they can be split concurrently
+    if (depth < ParallelDepth) {
+        std::future<void> leftHalf = std::async(std::launch::async, [&, begin, middle, depth]() {
+            bisect(forward, documents, begin, middle, depth + 1);
+        });
+        bisect(forward, documents, middle, end, depth + 1);
+        leftHalf.get();
+    } else {
+        bisect(forward, documents, begin, middle, depth + 1);
+        bisect(forward, documents, middle, end, depth + 1);
+    }
+}
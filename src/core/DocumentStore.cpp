@@ -0,0 +1,361 @@
+#include "core/DocumentStore.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+// Block header in the encoded form and in the store file:
+// u8 compressed flag, u32 raw size, u32 stored size, little-endian
+constexpr size_t BlockHeaderSize = 9;
+
+constexpr size_t MinMatch = 4;
+constexpr size_t MaxOffset = 65535;
+constexpr int HashBits = 12;
+constexpr size_t NoBlock = std::numeric_limits<size_t>::max();
+
+uint32_t load32(const char* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+void writeUint32(char* p, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        p[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+uint32_t readUint32(const char* p) {
+    const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+    return static_cast<uint32_t>(u[0]) | (static_cast<uint32_t>(u[1]) << 8) |
+           (static_cast<uint32_t>(u[2]) << 16) | (static_cast<uint32_t>(u[3]) << 24);
+}
+
+void writeLength(std::pmr::string& out, size_t length) {
+    while (length >= 255) {
+        out += static_cast<char>(255);
+        length -= 255;
+    }
+    out += static_cast<char>(length);
+}
+
+bool readLength(const unsigned char*& p, const unsigned char* end, size_t& length) {
+    unsigned char byte;
+    do {
+        if (p == end) {
+            return false;
+        }
+        byte = *p++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+/**
+ * @brief Appends one LZ77 sequence: literals, then a back-reference unless it is the last one.
+ *
+ * Sequences start with a token byte holding the literal count in the high
+ * nibble and the match length minus MinMatch in the low nibble; 15 means
+ * the value continues in extra bytes. The literals follow, then a 16-bit
+ * match offset and any extra match length bytes.
+ */
+void writeSequence(std::pmr::string& out, const char* literals, size_t literalCount,
+                   size_t offset, size_t matchLength) {
+    size_t matchCode = matchLength >= MinMatch ? matchLength - MinMatch : 0;
+    unsigned char token = static_cast<unsigned char>((std::min<size_t>(literalCount, 15) << 4) |
+                                                     std::min<size_t>(matchCode, 15));
+    out += static_cast<char>(token);
+    if (literalCount >= 15) {
+        writeLength(out, literalCount - 15);
+    }
+    out.append(literals, literalCount);
+    if (matchLength == 0) {
+        return;
+    }
+    out += static_cast<char>(offset & 0xFF);
+    out += static_cast<char>(offset >> 8);
+    if (matchCode >= 15) {
+        writeLength(out, matchCode - 15);
+    }
+}
+
+/**
+ * @brief Compresses a block with greedy LZ77 matching through a hash of 4-byte prefixes.
+ */
+void compressBlock(const char* src, size_t size, std::pmr::string& out) {
+    std::array<int32_t, 1 << HashBits> table;
+    table.fill(-1);
+
+    size_t anchor = 0;
+    size_t i = 0;
+    while (i + MinMatch <= size) {
+        uint32_t sequence = load32(src + i);
+        uint32_t hash = (sequence * 2654435761u) >> (32 - HashBits);
+        int32_t candidate = table[hash];
+        table[hash] = static_cast<int32_t>(i);
+
+        if (candidate < 0 || i - static_cast<size_t>(candidate) > MaxOffset ||
+            load32(src + candidate) != sequence) {
+            i++;
+            continue;
+        }
+
+        size_t length = MinMatch;
+        while (i + length < size && src[candidate + length] == src[i + length]) {
+            length++;
+        }
+        writeSequence(out, src + anchor, i - anchor, i - candidate, length);
+        i += length;
+        anchor = i;
+    }
+    writeSequence(out, src + anchor, size - anchor, 0, 0);
+}
+
+/**
+ * @brief Decompresses a block, rejecting anything that would read or write out of bounds.
+ */
+bool decompressBlock(const char* src, size_t size, size_t rawSize, std::string& out) {
+    out.resize(rawSize);
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(src);
+    const unsigned char* end = p + size;
+    size_t written = 0;
+
+    while (p < end) {
+        unsigned char token = *p++;
+        size_t literalCount = token >> 4;
+        if (literalCount == 15 && !readLength(p, end, literalCount)) {
+            return false;
+        }
+        if (literalCount > static_cast<size_t>(end - p) || literalCount > rawSize - written) {
+            return false;
+        }
+        std::memcpy(&out[written], p, literalCount);
+        p += literalCount;
+        written += literalCount;
+        if (p == end) {
+            break; // last sequence carries no match
+        }
+
+        if (end - p < 2) {
+            return false;
+        }
+        size_t offset = static_cast<size_t>(p[0]) | (static_cast<size_t>(p[1]) << 8);
+        p += 2;
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !readLength(p, end, matchLength)) {
+            return false;
+        }
+        matchLength += MinMatch;
+        if (offset == 0 || offset > written || matchLength > rawSize - written) {
+            return false;
+        }
+        // Byte by byte: the source may overlap the bytes being written
+        for (size_t j = 0; j < matchLength; ++j, ++written) {
+            out[written] = out[written - offset];
+        }
+    }
+    return written == rawSize;
+}
+
+} // namespace
+
+DocumentStore::DocumentStore()
+    : fileEnd(0), cachedBlock(NoBlock) {
+}
+
+bool DocumentStore::open(const std::string& storePath) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file.is_open()) {
+        file.close();
+    }
+    file.clear();
+    file.open(storePath, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    path = file.is_open() ? storePath : std::string();
+    fileEnd = 0;
+    documents.clear();
+    blocks.clear();
+    cachedBlock = NoBlock;
+    return file.is_open();
+}
+
+void DocumentStore::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file.is_open()) {
+        file.close();
+    }
+    path.clear();
+    fileEnd = 0;
+    documents.clear();
+    blocks.clear();
+    cachedBlock = NoBlock;
+}
+
+bool DocumentStore::isOpen() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return file.is_open();
+}
+
+void DocumentStore::encode(std::string_view text, std::pmr::string& encoded) {
+    encoded.clear();
+    encoded.reserve(text.size() / 2 + BlockHeaderSize);
+
+    for (size_t begin = 0; begin < text.size(); begin += BlockSize) {
+        size_t rawSize = std::min(BlockSize, text.size() - begin);
+        size_t header = encoded.size();
+        encoded.append(BlockHeaderSize, '\0');
+        compressBlock(text.data() + begin, rawSize, encoded);
+
+        // Incompressible blocks are kept as they are
+        size_t storedSize = encoded.size() - header - BlockHeaderSize;
+        bool compressed = storedSize < rawSize;
+        if (!compressed) {
+            encoded.resize(header + BlockHeaderSize);
+            encoded.append(text.data() + begin, rawSize);
+            storedSize = rawSize;
+        }
+
+        encoded[header] = static_cast<char>(compressed ? 1 : 0);
+        writeUint32(&encoded[header + 1], static_cast<uint32_t>(rawSize));
+        writeUint32(&encoded[header + 5], static_cast<uint32_t>(storedSize));
+    }
+}
+
+bool DocumentStore::add(uint32_t docId, std::string_view encoded) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    // Index the blocks first so malformed input leaves the store untouched
+    std::vector<BlockEntry> added;
+    uint64_t size = 0;
+    size_t position = 0;
+    while (position < encoded.size()) {
+        if (encoded.size() - position < BlockHeaderSize) {
+            return false;
+        }
+        const char* header = encoded.data() + position;
+        BlockEntry block;
+        block.compressed = header[0] != 0;
+        block.rawSize = readUint32(header + 1);
+        block.storedSize = readUint32(header + 5);
+        position += BlockHeaderSize;
+        if (block.rawSize > BlockSize || block.storedSize > encoded.size() - position ||
+            (!block.compressed && block.storedSize != block.rawSize)) {
+            return false;
+        }
+        // read() locates a byte by offset / BlockSize, so only the last block may be short
+        if (!added.empty() && added.back().rawSize != BlockSize) {
+            return false;
+        }
+        block.fileOffset = fileEnd + position;
+        position += block.storedSize;
+        size += block.rawSize;
+        added.push_back(block);
+    }
+
+    file.seekp(static_cast<std::streamoff>(fileEnd));
+    file.write(encoded.data(), static_cast<std::streamsize>(encoded.size()));
+    if (!file) {
+        file.clear();
+        return false;
+    }
+    fileEnd += encoded.size();
+
+    if (docId >= documents.size()) {
+        documents.resize(static_cast<size_t>(docId) + 1, DocumentEntry{0, 0, 0, false});
+    }
+    documents[docId] = {static_cast<uint32_t>(blocks.size()), static_cast<uint32_t>(added.size()), size, true};
+    blocks.insert(blocks.end(), added.begin(), added.end());
+    return true;
+}
+
+void DocumentStore::remapDocuments(const std::vector<uint32_t>& newIds) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<DocumentEntry> remapped(std::max(documents.size(), newIds.size()), DocumentEntry{0, 0, 0, false});
+    for (size_t docId = 0; docId < documents.size(); ++docId) {
+        remapped[docId < newIds.size() ? newIds[docId] : docId] = documents[docId];
+    }
+    documents = std::move(remapped);
+}
+
+bool DocumentStore::contains(uint32_t docId) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return docId < documents.size() && documents[docId].stored;
+}
+
+bool DocumentStore::read(uint32_t docId, size_t offset, size_t length, std::string& text) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    text.clear();
+    if (docId >= documents.size() || !documents[docId].stored) {
+        return false;
+    }
+
+    const DocumentEntry& document = documents[docId];
+    if (offset >= document.size) {
+        return true;
+    }
+    length = static_cast<size_t>(std::min<uint64_t>(length, document.size - offset));
+    text.reserve(length);
+
+    // Every block but the last holds exactly BlockSize bytes
+    size_t end = offset + length;
+    for (size_t index = offset / BlockSize; index * BlockSize < end; ++index) {
+        if (!loadBlock(document.firstBlock + index)) {
+            text.clear();
+            return false;
+        }
+        size_t blockBegin = index * BlockSize;
+        size_t from = std::max(offset, blockBegin) - blockBegin;
+        size_t to = std::min(end - blockBegin, cachedText.size());
+        text.append(cachedText, from, to - from);
+    }
+    return true;
+}
+
+uint64_t DocumentStore::getStoredBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return fileEnd;
+}
+
+void DocumentStore::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    documents.clear();
+    blocks.clear();
+    cachedBlock = NoBlock;
+    fileEnd = 0;
+    if (file.is_open()) {
+        // Reopening truncates the file
+        file.close();
+        file.clear();
+        file.open(path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    }
+}
+
+bool DocumentStore::loadBlock(size_t block) const {
+    if (block == cachedBlock) {
+        return true;
+    }
+    cachedBlock = NoBlock;
+
+    const BlockEntry& entry = blocks[block];
+    std::string stored(entry.storedSize, '\0');
+    file.seekg(static_cast<std::streamoff>(entry.fileOffset));
+    file.read(&stored[0], static_cast<std::streamsize>(stored.size()));
+    if (!file) {
+        file.clear();
+        return false;
+    }
+
+    if (entry.compressed) {
+        if (!decompressBlock(stored.data(), stored.size(), entry.rawSize, cachedText)) {
+            return false;
+        }
+    } else {
+        cachedText = std::move(stored);
+    }
+    cachedBlock = block;
+    return true;
+}
@@ -0,0 +1,249 @@
+#include "core/DuplicateDetector.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+namespace {
+
+// Only the most recent entries of a bucket are compared: a crowded bucket is
+// one big cluster, and any of its recent members identifies it
+constexpr size_t MaxBucketCandidates = 32;
+
+constexpr uint32_t EmptyValue = std::numeric_limits<uint32_t>::max();
+
+// Bucket entries are numbered docId * BandCount + band in 32 bits
+constexpr uint64_t MaxBucketedDocuments = (uint64_t(1) << 32) / DuplicateDetector::BandCount - 1;
+
+uint64_t mix(uint64_t x) {
+    // splitmix64 finalizer
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBull;
+    x ^= x >> 31;
+    return x;
+}
+
+/**
+ * @brief Multiply-shift hash functions, one per signature position.
+ */
+struct HashFamily {
+    std::array<uint64_t, DuplicateDetector::SignatureSize> multipliers;
+    std::array<uint64_t, DuplicateDetector::SignatureSize> increments;
+
+    HashFamily() {
+        // Fixed seed: signatures must not change between runs
+        uint64_t state = 0x5EED5EED5EED5EEDull;
+        for (size_t i = 0; i < DuplicateDetector::SignatureSize; ++i) {
+            state += 0x9E3779B97F4A7C15ull;
+            multipliers[i] = mix(state) | 1;
+            state += 0x9E3779B97F4A7C15ull;
+            increments[i] = mix(state);
+        }
+    }
+};
+
+const HashFamily& getHashFamily() {
+    static const HashFamily family;
+    return family;
+}
+
+bool isEmpty(const uint32_t* signature) {
+    return std::all_of(signature, signature + DuplicateDetector::SignatureSize, [](uint32_t value) {
+        return value == EmptyValue;
+    });
+}
+
+} // namespace
+
+DuplicateDetector::DuplicateDetector(double threshold)
+    : threshold(threshold), duplicates(0), usedBuckets(0) {
+}
+
+void DuplicateDetector::computeSignature(const std::unordered_map<std::string, int>& termFrequency,
+                                         Signature& signature) {
+    const HashFamily& family = getHashFamily();
+    signature.fill(EmptyValue);
+
+    for (const auto& entry : termFrequency) {
+        uint64_t termHash = mix(std::hash<std::string>()(entry.first));
+        int weight = 1 + static_cast<int>(std::log2(static_cast<double>(std::max(entry.second, 1))));
+        for (int copy = 0; copy < weight; ++copy) {
+            uint64_t element = mix(termHash + static_cast<uint64_t>(copy) * 0x9E3779B97F4A7C15ull);
+            for (size_t i = 0; i < SignatureSize; ++i) {
+                uint32_t value = static_cast<uint32_t>((family.multipliers[i] * element + family.increments[i]) >> 32);
+                signature[i] = std::min(signature[i], value);
+            }
+        }
+    }
+}
+
+uint32_t DuplicateDetector::add(uint32_t docId, const Signature& signature) {
+    if (docId >= clusters.size()) {
+        size_t first = clusters.size();
+        clusters.resize(static_cast<size_t>(docId) + 1);
+        for (size_t id = first; id < clusters.size(); ++id) {
+            clusters[id] = static_cast<uint32_t>(id);
+        }
+        clusterSizes.resize(clusters.size(), 1);
+        signatures.resize(clusters.size() * SignatureSize, EmptyValue);
+        chains.resize(clusters.size() * BandCount, 0);
+    }
+    if (isEmpty(signature.data()) || docId > MaxBucketedDocuments) {
+        return docId;
+    }
+
+    std::vector<uint32_t> candidates;
+    for (size_t band = 0; band < BandCount; ++band) {
+        if (table.empty()) {
+            break;
+        }
+        const Bucket& bucket = table[findBucket(bandKey(signature.data(), band))];
+        uint32_t next = bucket.head;
+        for (size_t seen = 0; next != 0 && seen < MaxBucketCandidates; ++seen) {
+            candidates.push_back(static_cast<uint32_t>((next - 1) / BandCount));
+            next = chains[next - 1];
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    uint32_t cluster = docId;
+    double bestSimilarity = threshold;
+    for (uint32_t candidate : candidates) {
+        if (candidate == docId) {
+            continue;
+        }
+        double similarity = estimateSimilarity(signature, candidate);
+        if (similarity >= bestSimilarity) {
+            bestSimilarity = similarity;
+            cluster = clusters[candidate];
+        }
+    }
+    clusters[docId] = cluster;
+    if (cluster != docId) {
+        clusterSizes[cluster]++;
+        duplicates++;
+    }
+
+    std::copy(signature.begin(), signature.end(), signatures.begin() + static_cast<size_t>(docId) * SignatureSize);
+    insertBands(docId);
+    return cluster;
+}
+
+uint32_t DuplicateDetector::getCluster(uint32_t docId) const {
+    return docId < clusters.size() ? clusters[docId] : docId;
+}
+
+size_t DuplicateDetector::getClusterSize(uint32_t docId) const {
+    return docId < clusters.size() ? clusterSizes[clusters[docId]] : 1;
+}
+
+size_t DuplicateDetector::getDuplicateCount() const {
+    return duplicates;
+}
+
+void DuplicateDetector::setThreshold(double similarity) {
+    threshold = similarity;
+}
+
+double DuplicateDetector::getThreshold() const {
+    return threshold;
+}
+
+void DuplicateDetector::remapDocuments(const std::vector<uint32_t>& newIds) {
+    auto remap = [&newIds](uint32_t docId) {
+        return docId < newIds.size() ? newIds[docId] : docId;
+    };
+
+    size_t count = std::max(clusters.size(), newIds.size());
+    std::vector<uint32_t> remappedClusters(count);
+    std::vector<uint32_t> remappedSizes(count, 1);
+    std::vector<uint32_t> remappedSignatures(count * SignatureSize, EmptyValue);
+    for (size_t id = 0; id < count; ++id) {
+        remappedClusters[id] = static_cast<uint32_t>(id);
+    }
+    for (size_t id = 0; id < clusters.size(); ++id) {
+        uint32_t newId = remap(static_cast<uint32_t>(id));
+        remappedClusters[newId] = remap(clusters[id]);
+        remappedSizes[newId] = clusterSizes[id];
+        std::copy(signatures.begin() + id * SignatureSize, signatures.begin() + (id + 1) * SignatureSize,
+                  remappedSignatures.begin() + static_cast<size_t>(newId) * SignatureSize);
+    }
+    clusters = std::move(remappedClusters);
+    clusterSizes = std::move(remappedSizes);
+    signatures = std::move(remappedSignatures);
+
+    // Bucket entries are numbered by docId, so the buckets are rebuilt
+    table.clear();
+    usedBuckets = 0;
+    chains.assign(count * BandCount, 0);
+    for (size_t id = 0; id < count && id <= MaxBucketedDocuments; ++id) {
+        if (!isEmpty(signatures.data() + id * SignatureSize)) {
+            insertBands(static_cast<uint32_t>(id));
+        }
+    }
+}
+
+void DuplicateDetector::clear() {
+    duplicates = 0;
+    signatures.clear();
+    table.clear();
+    usedBuckets = 0;
+    chains.clear();
+    clusters.clear();
+    clusterSizes.clear();
+}
+
+uint32_t DuplicateDetector::bandKey(const uint32_t* signature, size_t band) {
+    uint64_t key = band;
+    for (size_t row = 0; row < RowsPerBand; ++row) {
+        key = mix(key ^ signature[band * RowsPerBand + row]);
+    }
+    return static_cast<uint32_t>(key);
+}
+
+size_t DuplicateDetector::findBucket(uint32_t key) const {
+    size_t mask = table.size() - 1;
+    size_t slot = mix(key) & mask;
+    while (table[slot].head != 0 && table[slot].key != key) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void DuplicateDetector::insertBands(uint32_t docId) {
+    const uint32_t* signature = signatures.data() + static_cast<size_t>(docId) * SignatureSize;
+    for (size_t band = 0; band < BandCount; ++band) {
+        // Keep the table at most half full so probe sequences stay short
+        if ((usedBuckets + 1) * 2 > table.size()) {
+            std::vector<Bucket> old = std::move(table);
+            table.assign(std::max<size_t>(1024, old.size() * 2), Bucket{0, 0});
+            for (const Bucket& bucket : old) {
+                if (bucket.head != 0) {
+                    table[findBucket(bucket.key)] = bucket;
+                }
+            }
+        }
+
+        uint32_t key = bandKey(signature, band);
+        Bucket& bucket = table[findBucket(key)];
+        if (bucket.head == 0) {
+            bucket.key = key;
+            usedBuckets++;
+        }
+        uint32_t entry = static_cast<uint32_t>(static_cast<size_t>(docId) * BandCount + band);
+        chains[entry] = bucket.head;
+        bucket.head = entry + 1;
+    }
+}
+
+double DuplicateDetector::estimateSimilarity(const Signature& signature, uint32_t docId) const {
+    const uint32_t* stored = signatures.data() + static_cast<size_t>(docId) * SignatureSize;
+    size_t matching = 0;
+    for (size_t i = 0; i < SignatureSize; ++i) {
+        matching += stored[i] == signature[i];
+    }
+    return static_cast<double>(matching) / SignatureSize;
+}
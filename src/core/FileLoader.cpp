@@ -0,0 +1,439 @@
+#include "core/FileLoader.h"
+#include <algorithm>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define FILELOADER_IO_URING 1
+#endif
+#endif
+
+#ifdef FILELOADER_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace {
+
+/**
+ * @brief Reads a whole file with blocking I/O.
+ */
+bool readWholeFile(const std::string& filePath, std::string& buffer) {
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(filePath, error)) {
+        return false;
+    }
+    std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::streamoff size = file.tellg();
+    if (size < 0) {
+        return false;
+    }
+    buffer.resize(static_cast<size_t>(size));
+    file.seekg(0);
+    file.read(&buffer[0], static_cast<std::streamsize>(size));
+    buffer.resize(static_cast<size_t>(std::max<std::streamsize>(file.gcount(), 0)));
+    return true;
+}
+
+#ifdef FILELOADER_IO_URING
+
+/**
+ * @brief The submission and completion rings of one io_uring instance.
+ *
+ * Only what file reads need: queue a readv, submit, and reap completions.
+ */
+class IoUring {
+public:
+    IoUring()
+        : fd(-1), sqRing(MAP_FAILED), cqRing(MAP_FAILED), sqes(nullptr),
+          sqRingSize(0), cqRingSize(0), sqesSize(0), sqEntries(0), unsubmitted(0) {
+    }
+
+    ~IoUring() {
+        if (sqes) {
+            munmap(sqes, sqesSize);
+        }
+        if (cqRing != MAP_FAILED && cqRing != sqRing) {
+            munmap(cqRing, cqRingSize);
+        }
+        if (sqRing != MAP_FAILED) {
+            munmap(sqRing, sqRingSize);
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    /**
+     * @brief Creates the ring and maps it.
+     *
+     * @param entries Submission queue size
+     * @return False if io_uring is not available
+     */
+    bool open(unsigned entries) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0) {
+            return false;
+        }
+
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMap) {
+            sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+        }
+
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                      IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED) {
+            return false;
+        }
+        cqRing = singleMap ? sqRing
+                           : mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                                  IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED) {
+            return false;
+        }
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void* mapped = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                            IORING_OFF_SQES);
+        if (mapped == MAP_FAILED) {
+            return false;
+        }
+        sqes = static_cast<io_uring_sqe*>(mapped);
+
+        char* sq = static_cast<char*>(sqRing);
+        sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        char* cq = static_cast<char*>(cqRing);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        sqEntries = params.sq_entries;
+        return true;
+    }
+
+    /**
+     * @brief Queues a single-buffer readv.
+     *
+     * @return False if the submission queue is full
+     */
+    bool prepareRead(int fileFd, const iovec* iov, uint64_t offset, uint64_t userData) {
+        unsigned tail = *sqTail;
+        if (tail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries) {
+            return false;
+        }
+
+        unsigned slot = tail & *sqMask;
+        io_uring_sqe& sqe = sqes[slot];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_READV;
+        sqe.fd = fileFd;
+        sqe.addr = reinterpret_cast<uint64_t>(iov);
+        sqe.len = 1;
+        sqe.off = offset;
+        sqe.user_data = userData;
+        sqArray[slot] = slot;
+
+        // The entry must be complete before the kernel can see the new tail
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+        unsubmitted++;
+        return true;
+    }
+
+    /**
+     * @brief Submits the queued reads and waits for a completion.
+     *
+     * @param submitted Receives how many of the oldest queued reads the kernel took
+     * @return False on an error other than an interrupted or busy call
+     */
+    bool submitAndWait(unsigned& submitted) {
+        submitted = 0;
+        for (;;) {
+            long taken = syscall(__NR_io_uring_enter, fd, unsubmitted, 1u, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (taken >= 0) {
+                submitted = std::min(unsubmitted, static_cast<unsigned>(taken));
+                unsubmitted -= submitted;
+                return true;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            // Completion queue full or kernel short of memory: reap, then retry
+            return errno == EAGAIN || errno == EBUSY;
+        }
+    }
+
+    /**
+     * @brief Takes the oldest completion.
+     *
+     * @return False if no completion is available
+     */
+    bool popCompletion(uint64_t& userData, int& result) {
+        unsigned head = *cqHead;
+        if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+            return false;
+        }
+        const io_uring_cqe& cqe = cqes[head & *cqMask];
+        userData = cqe.user_data;
+        result = cqe.res;
+        __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+private:
+    int fd;
+    void* sqRing;
+    void* cqRing;
+    io_uring_sqe* sqes;
+    size_t sqRingSize;
+    size_t cqRingSize;
+    size_t sqesSize;
+    unsigned sqEntries;
+    unsigned unsubmitted;
+    unsigned* sqHead;
+    unsigned* sqTail;
+    unsigned* sqMask;
+    unsigned* sqArray;
+    unsigned* cqHead;
+    unsigned* cqTail;
+    unsigned* cqMask;
+    io_uring_cqe* cqes;
+};
+
+/**
+ * @brief One file being read through the ring.
+ */
+struct RingRead {
+    size_t index;
+    int fd;
+    std::string* buffer;
+    size_t done;       // bytes read so far
+    iovec iov;
+};
+
+/**
+ * @brief Reads the rest of a file with blocking preads.
+ */
+bool finishWithPread(RingRead& read) {
+    while (read.done < read.buffer->size()) {
+        ssize_t count = pread(read.fd, &(*read.buffer)[read.done], read.buffer->size() - read.done,
+                              static_cast<off_t>(read.done));
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0) {
+            return false;
+        }
+        if (count == 0) {
+            read.buffer->resize(read.done);
+            break;
+        }
+        read.done += static_cast<size_t>(count);
+    }
+    return true;
+}
+
+#endif // FILELOADER_IO_URING
+
+} // namespace
+
+FileLoader::FileLoader(size_t queueDepth, Backend backend)
+    : queueDepth(std::max<size_t>(queueDepth, 1)), backend(backend) {
+}
+
+FileLoader::Backend FileLoader::load(const std::vector<std::string>& filePaths, const BufferProvider& acquire,
+                                     const CompletionHandler& complete) const {
+    if (backend == Backend::IoUring && loadWithIoUring(filePaths, acquire, complete)) {
+        return Backend::IoUring;
+    }
+    loadWithThreads(filePaths, acquire, complete);
+    return Backend::Threads;
+}
+
+size_t FileLoader::getQueueDepth() const {
+    return queueDepth;
+}
+
+bool FileLoader::loadWithIoUring(const std::vector<std::string>& filePaths, const BufferProvider& acquire,
+                                 const CompletionHandler& complete) const {
+#ifdef FILELOADER_IO_URING
+    // The ring is sized once; deeper queues would only wait for free entries
+    const size_t depth = std::min<size_t>(queueDepth, 4096);
+    IoUring ring;
+    if (!ring.open(static_cast<unsigned>(depth))) {
+        return false;
+    }
+
+    std::vector<RingRead> reads(depth);
+    std::vector<size_t> freeReads;
+    for (size_t i = depth; i > 0; --i) {
+        freeReads.push_back(i - 1);
+    }
+    std::deque<size_t> unsubmitted; // queued reads the kernel has not taken yet, oldest first
+    size_t inFlight = 0;
+    bool ringFailed = false;        // after a hard io_uring_enter error reads are finished with pread
+
+    auto finish = [&](size_t slot, bool ok) {
+        RingRead& read = reads[slot];
+        close(read.fd);
+        freeReads.push_back(slot);
+        inFlight--;
+        complete(read.index, ok);
+    };
+    auto queue = [&](size_t slot) {
+        RingRead& read = reads[slot];
+        read.iov.iov_base = &(*read.buffer)[read.done];
+        read.iov.iov_len = read.buffer->size() - read.done;
+        if (!ringFailed && ring.prepareRead(read.fd, &read.iov, read.done, slot)) {
+            unsubmitted.push_back(slot);
+        } else {
+            finish(slot, finishWithPread(read));
+        }
+    };
+
+    size_t next = 0;
+    while (next < filePaths.size() || inFlight > 0) {
+        // Start files while the queue has room and buffers are free
+        while (next < filePaths.size() && inFlight < depth) {
+            std::string* buffer = acquire(next, inFlight == 0);
+            if (!buffer) {
+                break;
+            }
+            size_t index = next++;
+
+            int fileFd = ::open(filePaths[index].c_str(), O_RDONLY | O_CLOEXEC);
+            struct stat info;
+            if (fileFd < 0 || fstat(fileFd, &info) != 0 || !S_ISREG(info.st_mode)) {
+                if (fileFd >= 0) {
+                    close(fileFd);
+                }
+                complete(index, false);
+                continue;
+            }
+            buffer->resize(static_cast<size_t>(info.st_size));
+            if (buffer->empty()) {
+                close(fileFd);
+                complete(index, true);
+                continue;
+            }
+
+            size_t slot = freeReads.back();
+            freeReads.pop_back();
+            reads[slot] = {index, fileFd, buffer, 0, {}};
+            inFlight++;
+            queue(slot);
+        }
+        if (inFlight == 0) {
+            continue;
+        }
+
+        // Nothing more can start until a read completes
+        if (!ringFailed) {
+            unsigned submitted = 0;
+            if (ring.submitAndWait(submitted)) {
+                size_t taken = std::min<size_t>(submitted, unsubmitted.size());
+                unsubmitted.erase(unsubmitted.begin(), unsubmitted.begin() + static_cast<std::ptrdiff_t>(taken));
+            } else {
+                // Reads the kernel never took are safe to finish here; later calls submit nothing
+                ringFailed = true;
+                for (size_t slot : unsubmitted) {
+                    finish(slot, finishWithPread(reads[slot]));
+                }
+                unsubmitted.clear();
+            }
+        }
+
+        uint64_t slot = 0;
+        int result = 0;
+        bool reaped = false;
+        while (ring.popCompletion(slot, result)) {
+            reaped = true;
+            RingRead& read = reads[static_cast<size_t>(slot)];
+            if (result == -EINTR || result == -EAGAIN) {
+                queue(static_cast<size_t>(slot));
+                continue;
+            }
+            if (result < 0) {
+                finish(static_cast<size_t>(slot), false);
+                continue;
+            }
+            read.done += static_cast<size_t>(result);
+            if (result == 0) {
+                read.buffer->resize(read.done); // file shrank since fstat
+            }
+            if (read.done >= read.buffer->size()) {
+                finish(static_cast<size_t>(slot), true);
+            } else {
+                queue(static_cast<size_t>(slot)); // short read
+            }
+        }
+        if (!reaped && ringFailed && inFlight > 0) {
+            // Submitted reads still complete into the ring; yielding lets that work run
+            std::this_thread::yield();
+        }
+    }
+    return true;
+#else
+    (void)filePaths;
+    (void)acquire;
+    (void)complete;
+    return false;
+#endif
+}
+
+void FileLoader::loadWithThreads(const std::vector<std::string>& filePaths, const BufferProvider& acquire,
+                                 const CompletionHandler& complete) const {
+    std::mutex startMutex;
+    size_t next = 0;
+
+    auto worker = [&]() {
+        for (;;) {
+            size_t index = 0;
+            std::string* buffer = nullptr;
+            {
+                // Buffers are taken in index order, so the earliest unfinished file always holds one
+                std::lock_guard<std::mutex> lock(startMutex);
+                if (next >= filePaths.size()) {
+                    return;
+                }
+                index = next++;
+                buffer = acquire(index, true);
+            }
+            complete(index, readWholeFile(filePaths[index], *buffer));
+        }
+    };
+
+    std::vector<std::thread> threads;
+    size_t threadCount = std::min(queueDepth, filePaths.size());
+    for (size_t i = 1; i < threadCount; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
@@ -0,0 +1,265 @@
+#include "core/ImpactIndex.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Budgeted queries check their budget after this many postings
+constexpr uint32_t BudgetChunk = 8192;
+
+/**
+ * @brief A segment waiting to be processed.
+ */
+struct Pending {
+    uint8_t impact;
+    uint32_t list;
+    uint32_t segment;
+};
+
+/**
+ * @brief Per-thread buffers reused by every topK() call on the thread.
+ *
+ * The accumulators are all zero between calls: a call clears exactly the
+ * entries it touched, so the array is never reallocated or wiped.
+ */
+struct TopKScratch {
+    std::vector<uint32_t> accumulators;
+    std::vector<uint32_t> touched;
+    std::vector<uint32_t> nextSegment;
+    std::vector<uint32_t> values;
+    std::vector<Pending> order;
+};
+
+TopKScratch& getTopKScratch() {
+    thread_local TopKScratch scratch;
+    return scratch;
+}
+
+} // namespace
+
+ImpactIndex::ImpactIndex()
+    : scale(0.0), documentCount(0) {
+}
+
+void ImpactIndex::build(const InvertedIndex& index, const Scorer& scorer) {
+    clear();
+    const TermDictionary& dictionary = index.getTermDictionary();
+    std::vector<double> contributions;
+
+    // First pass: the largest contribution fixes the quantization step
+    double maxScore = 0.0;
+    for (TermDictionary::Iterator it = dictionary.begin(); it.valid(); it.next()) {
+        const PostingList* list = index.getPostings(it.term());
+        if (!list || list->size() == 0) {
+            continue;
+        }
+        scorer.scorePostings(*list, contributions);
+        maxScore = std::max(maxScore, *std::max_element(contributions.begin(), contributions.end()));
+        documentCount = std::max(documentCount, list->docIds.back() + 1);
+    }
+    if (maxScore <= 0.0) {
+        return;
+    }
+    scale = maxScore / 255.0;
+
+    // Second pass: bucket each term's postings by impact, keeping docId order
+    std::vector<uint8_t> impacts;
+    for (TermDictionary::Iterator it = dictionary.begin(); it.valid(); it.next()) {
+        const PostingList* list = index.getPostings(it.term());
+        if (!list || list->size() == 0) {
+            continue;
+        }
+        scorer.scorePostings(*list, contributions);
+
+        uint32_t counts[256] = {};
+        impacts.resize(contributions.size());
+        for (size_t i = 0; i < contributions.size(); ++i) {
+            // Postings that add nothing are dropped; everything else keeps at least 1
+            long quantized = contributions[i] > 0.0 ? std::lround(contributions[i] / scale) : 0;
+            impacts[i] = contributions[i] > 0.0 ? static_cast<uint8_t>(std::min(255L, std::max(1L, quantized))) : 0;
+            counts[impacts[i]]++;
+        }
+
+        ImpactList impactList;
+        uint32_t starts[256] = {};
+        uint32_t offset = 0;
+        for (int impact = 255; impact >= 1; --impact) {
+            if (counts[impact] == 0) {
+                continue;
+            }
+            impactList.segments.push_back({static_cast<uint8_t>(impact), offset, offset + counts[impact]});
+            starts[impact] = offset;
+            offset += counts[impact];
+        }
+        if (impactList.segments.empty()) {
+            continue;
+        }
+
+        impactList.docIds.resize(offset);
+        for (size_t i = 0; i < impacts.size(); ++i) {
+            if (impacts[i] > 0) {
+                impactList.docIds[starts[impacts[i]]++] = list->docIds[i];
+            }
+        }
+        lists.emplace(it.term(), std::move(impactList));
+    }
+}
+
+std::vector<ScoredDocument> ImpactIndex::topK(const std::vector<std::string>& terms, size_t k,
+                                              QueryBudget* budget) const {
+    std::vector<ScoredDocument> results;
+    if (k == 0 || documentCount == 0) {
+        return results;
+    }
+
+    std::vector<const ImpactList*> termLists;
+    for (const auto& term : terms) {
+        auto it = lists.find(term);
+        if (it != lists.end()) {
+            termLists.push_back(&it->second);
+        }
+    }
+    if (termLists.empty()) {
+        return results;
+    }
+
+    TopKScratch& scratch = getTopKScratch();
+    std::vector<uint32_t>& accumulators = scratch.accumulators;
+    std::vector<uint32_t>& touched = scratch.touched;
+    std::vector<uint32_t>& nextSegment = scratch.nextSegment;
+    std::vector<uint32_t>& values = scratch.values;
+    std::vector<Pending>& order = scratch.order;
+    if (accumulators.size() < documentCount) {
+        accumulators.resize(documentCount, 0);
+    }
+    touched.clear();
+    nextSegment.assign(termLists.size(), 0);
+    order.clear();
+
+    // Segments of all terms, highest impact first
+    for (size_t i = 0; i < termLists.size(); ++i) {
+        const auto& segments = termLists[i]->segments;
+        for (size_t j = 0; j < segments.size(); ++j) {
+            order.push_back({segments[j].impact, static_cast<uint32_t>(i), static_cast<uint32_t>(j)});
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [](const Pending& a, const Pending& b) {
+        return a.impact > b.impact;
+    });
+
+    // Where a budgeted query stopped inside a segment: postings before this were counted
+    size_t stoppedList = termLists.size();
+    uint32_t stoppedAt = 0;
+    for (size_t p = 0; p < order.size(); ++p) {
+        const Pending& pending = order[p];
+        const ImpactList& list = *termLists[pending.list];
+        const Segment& segment = list.segments[pending.segment];
+        uint32_t chunk = budget ? BudgetChunk : segment.end - segment.begin;
+        for (uint32_t begin = segment.begin; begin < segment.end; begin += chunk) {
+            if (budget && (p > 0 || begin > segment.begin) && budget->shouldStop()) {
+                stoppedList = pending.list;
+                stoppedAt = begin;
+                break;
+            }
+            uint32_t end = std::min(segment.end, begin + chunk);
+            for (uint32_t i = begin; i < end; ++i) {
+                uint32_t docId = list.docIds[i];
+                if (accumulators[docId] == 0) {
+                    touched.push_back(docId);
+                }
+                accumulators[docId] += pending.impact;
+            }
+            if (budget) {
+                budget->charge(end - begin);
+            }
+        }
+        if (stoppedList != termLists.size()) {
+            break;
+        }
+        nextSegment[pending.list] = pending.segment + 1;
+
+        // Check for a stable top K once per impact level
+        if (p + 1 == order.size() || order[p + 1].impact == pending.impact || touched.size() < k) {
+            continue;
+        }
+
+        // No document can gain more than the next impact of every term
+        uint32_t remaining = 0;
+        for (size_t i = 0; i < termLists.size(); ++i) {
+            const auto& segments = termLists[i]->segments;
+            if (nextSegment[i] < segments.size()) {
+                remaining += segments[nextSegment[i]].impact;
+            }
+        }
+
+        values.clear();
+        for (uint32_t docId : touched) {
+            values.push_back(accumulators[docId]);
+        }
+        std::nth_element(values.begin(), values.begin() + (k - 1), values.end(), std::greater<uint32_t>());
+        uint32_t kth = values[k - 1];
+        uint32_t challenger = 0;
+        if (values.size() > k) {
+            challenger = *std::max_element(values.begin() + k, values.end());
+        }
+        // Neither a partially scored nor an unseen document can reach the K-th any more
+        // (strictly, so ties are still broken by docId)
+        if (kth > challenger + remaining) {
+            break;
+        }
+    }
+
+    auto byScore = [&accumulators](uint32_t a, uint32_t b) {
+        return accumulators[a] != accumulators[b] ? accumulators[a] > accumulators[b] : a < b;
+    };
+    size_t count = std::min(k, touched.size());
+    std::partial_sort(touched.begin(), touched.begin() + count, touched.end(), byScore);
+    for (size_t i = count; i < touched.size(); ++i) {
+        accumulators[touched[i]] = 0;
+    }
+    touched.resize(count);
+
+    // Complete the top documents from the segments that were skipped
+    for (uint32_t docId : touched) {
+        for (size_t i = 0; i < termLists.size(); ++i) {
+            const ImpactList& list = *termLists[i];
+            for (size_t j = nextSegment[i]; j < list.segments.size(); ++j) {
+                const Segment& segment = list.segments[j];
+                uint32_t begin = (i == stoppedList && j == nextSegment[i]) ? stoppedAt : segment.begin;
+                if (std::binary_search(list.docIds.begin() + begin,
+                                       list.docIds.begin() + segment.end, docId)) {
+                    accumulators[docId] += segment.impact;
+                    break;
+                }
+            }
+        }
+    }
+    std::sort(touched.begin(), touched.end(), byScore);
+
+    results.reserve(touched.size());
+    for (uint32_t docId : touched) {
+        results.push_back({docId, accumulators[docId] * scale});
+        accumulators[docId] = 0;
+    }
+    return results;
+}
+
+double ImpactIndex::getScale() const {
+    return scale;
+}
+
+size_t ImpactIndex::getMemoryUsage() const {
+    size_t bytes = 0;
+    for (const auto& entry : lists) {
+        bytes += entry.first.capacity() + sizeof(ImpactList);
+        bytes += entry.second.segments.capacity() * sizeof(Segment);
+        bytes += entry.second.docIds.capacity() * sizeof(uint32_t);
+    }
+    return bytes;
+}
+
+void ImpactIndex::clear() {
+    lists.clear();
+    scale = 0.0;
+    documentCount = 0;
+}
@@ -0,0 +1,100 @@
+#include "core/InvertedIndex.h"
+#include <algorithm>
+
+InvertedIndex::InvertedIndex()
+    : dictionaryStale(false) {
+}
+
+void InvertedIndex::addDocument(uint32_t docId, const std::pmr::vector<std::string_view>& terms,
+                                const std::pmr::vector<uint32_t>& positions) {
+    bool positional = !positions.empty() && positions.size() == terms.size();
+    dictionaryStale = true;
+
+    // Group token positions by term; counts alone when positions are not kept
+    std::pmr::memory_resource* scratch = terms.get_allocator().resource();
+    std::pmr::unordered_map<std::string_view, std::pmr::vector<uint32_t>> termPositions(scratch);
+    std::pmr::unordered_map<std::string_view, uint32_t> termCounts(scratch);
+    for (size_t i = 0; i < terms.size(); ++i) {
+        if (positional) {
+            termPositions[terms[i]].push_back(positions[i]);
+        } else {
+            termCounts[terms[i]]++;
+        }
+    }
+
+    if (positional) {
+        for (const auto& entry : termPositions) {
+            PostingList& list = postings[std::string(entry.first)];
+            list.docIds.push_back(docId);
+            list.frequencies.push_back(static_cast<uint32_t>(entry.second.size()));
+            list.positions.insert(list.positions.end(), entry.second.begin(), entry.second.end());
+            list.positionStarts.push_back(static_cast<uint32_t>(list.positions.size()));
+        }
+    } else {
+        for (const auto& entry : termCounts) {
+            PostingList& list = postings[std::string(entry.first)];
+            list.docIds.push_back(docId);
+            list.frequencies.push_back(entry.second);
+            list.positionStarts.push_back(static_cast<uint32_t>(list.positions.size()));
+        }
+    }
+}
+
+void InvertedIndex::remapDocuments(const std::vector<uint32_t>& newIds) {
+    std::vector<uint32_t> order;
+    for (auto& entry : postings) {
+        PostingList& list = entry.second;
+        order.resize(list.size());
+        for (uint32_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&list, &newIds](uint32_t a, uint32_t b) {
+            return newIds[list.docIds[a]] < newIds[list.docIds[b]];
+        });
+
+        PostingList remapped;
+        remapped.docIds.reserve(list.size());
+        remapped.frequencies.reserve(list.size());
+        remapped.positionStarts.reserve(list.size() + 1);
+        remapped.positions.reserve(list.positions.size());
+        for (uint32_t i : order) {
+            remapped.docIds.push_back(newIds[list.docIds[i]]);
+            remapped.frequencies.push_back(list.frequencies[i]);
+            remapped.positions.insert(remapped.positions.end(), list.positionsBegin(i), list.positionsEnd(i));
+            remapped.positionStarts.push_back(static_cast<uint32_t>(remapped.positions.size()));
+        }
+        list = std::move(remapped);
+    }
+}
+
+const PostingList* InvertedIndex::getPostings(const std::string& term) const {
+    auto it = postings.find(term);
+    if (it == postings.end()) {
+        return nullptr;
+    }
+    return &it->second;
+}
+
+size_t InvertedIndex::getTermCount() const {
+    return postings.size();
+}
+
+const TermDictionary& InvertedIndex::getTermDictionary() const {
+    std::lock_guard<std::mutex> lock(dictionaryMutex);
+    if (dictionaryStale) {
+        std::vector<std::string> terms;
+        terms.reserve(postings.size());
+        for (const auto& entry : postings) {
+            terms.push_back(entry.first);
+        }
+        termDictionary.build(std::move(terms));
+        dictionaryStale = false;
+    }
+    return termDictionary;
+}
+
+void InvertedIndex::clear() {
+    postings.clear();
+    termDictionary.build(std::vector<std::string>());
+    dictionaryStale = false;
+}
@@ -0,0 +1,55 @@
+#include "core/LevenshteinAutomaton.h"
+#include "core/Tokenizer.h"
+#include <algorithm>
+
+LevenshteinAutomaton::LevenshteinAutomaton(const std::string& term, uint32_t maxEdits)
+    : maxEdits(std::min<uint32_t>(maxEdits, 254)) {
+    size_t i = 0;
+    while (i < term.size()) {
+        uint32_t codePoint = 0;
+        i += Tokenizer::decodeCharacter(std::string_view(term).substr(i), codePoint);
+        this->term.push_back(codePoint);
+    }
+}
+
+LevenshteinAutomaton::State LevenshteinAutomaton::start() const {
+    uint8_t cap = static_cast<uint8_t>(maxEdits + 1);
+    State state(term.size() + 1);
+    for (size_t i = 0; i < state.size(); ++i) {
+        state[i] = static_cast<uint8_t>(std::min<size_t>(i, cap));
+    }
+    return state;
+}
+
+LevenshteinAutomaton::State LevenshteinAutomaton::step(const State& state, uint32_t codePoint) const {
+    uint8_t cap = static_cast<uint8_t>(maxEdits + 1);
+    State next(state.size());
+    next[0] = static_cast<uint8_t>(std::min<uint32_t>(state[0] + 1u, cap));
+    for (size_t i = 1; i < state.size(); ++i) {
+        uint32_t substitute = state[i - 1] + (term[i - 1] == codePoint ? 0u : 1u);
+        uint32_t insert = state[i] + 1u;
+        uint32_t remove = next[i - 1] + 1u;
+        next[i] = static_cast<uint8_t>(std::min({substitute, insert, remove, static_cast<uint32_t>(cap)}));
+    }
+    return next;
+}
+
+bool LevenshteinAutomaton::canMatch(const State& state) const {
+    return *std::min_element(state.begin(), state.end()) <= maxEdits;
+}
+
+bool LevenshteinAutomaton::isMatch(const State& state) const {
+    return state.back() <= maxEdits;
+}
+
+uint32_t LevenshteinAutomaton::distance(const State& state) const {
+    return state.back();
+}
+
+uint32_t LevenshteinAutomaton::getMaxEdits() const {
+    return maxEdits;
+}
+
+size_t LevenshteinAutomaton::getTermLength() const {
+    return term.size();
+}
@@ -0,0 +1,416 @@
+#include "core/QueryEvaluator.h"
+#include "core/LevenshteinAutomaton.h"
+#include <algorithm>
+#include <numeric>
+#include <queue>
+#include <functional>
+
+QueryEvaluator::QueryEvaluator(const InvertedIndex& index)
+    : index(index), maxExpansions(1024) {
+}
+
+void QueryEvaluator::rewrite(QueryNode& node) const {
+    if (node.type == QueryNode::Type::Wildcard || node.type == QueryNode::Type::Fuzzy) {
+        const TermDictionary& dictionary = index.getTermDictionary();
+        const std::string& pattern = node.terms.front();
+
+        QueryNode expanded;
+        if (node.type == QueryNode::Type::Wildcard) {
+            for (auto& term : dictionary.expandWildcard(pattern, maxExpansions)) {
+                QueryNode leaf;
+                leaf.type = QueryNode::Type::Term;
+                leaf.terms.push_back(std::move(term));
+                leaf.boost = node.boost;
+                expanded.should.push_back(std::move(leaf));
+            }
+        } else {
+            LevenshteinAutomaton automaton(pattern, node.distance);
+            for (auto& match : dictionary.expandFuzzy(automaton, maxExpansions)) {
+                QueryNode leaf;
+                leaf.type = QueryNode::Type::Term;
+                leaf.terms.push_back(std::move(match.term));
+                leaf.boost = node.boost * (1.0 - static_cast<double>(match.distance) / (automaton.getTermLength() + 1));
+                expanded.should.push_back(std::move(leaf));
+            }
+        }
+        if (expanded.should.size() == 1) {
+            QueryNode only = std::move(expanded.should.front());
+            expanded = std::move(only);
+        }
+        node = std::move(expanded);
+        return;
+    }
+
+    for (auto& child : node.must) {
+        rewrite(child);
+    }
+    for (auto& child : node.should) {
+        rewrite(child);
+    }
+    for (auto& child : node.mustNot) {
+        rewrite(child);
+    }
+}
+
+void QueryEvaluator::setMaxExpansions(size_t limit) {
+    maxExpansions = limit;
+}
+
+size_t QueryEvaluator::getMaxExpansions() const {
+    return maxExpansions;
+}
+
+std::vector<uint32_t> QueryEvaluator::match(const QueryNode& node) const {
+    if (node.isLeaf()) {
+        return matchLeaf(node, nullptr);
+    }
+    return matchBoolean(node);
+}
+
+std::vector<uint32_t> QueryEvaluator::matchLeaf(const QueryNode& leaf,
+                                                const std::vector<uint32_t>* candidates) const {
+    std::vector<uint32_t> matches;
+
+    std::vector<const PostingList*> lists;
+    for (const auto& term : leaf.terms) {
+        const PostingList* list = index.getPostings(term);
+        if (!list) {
+            return matches; // A missing term cannot be satisfied
+        }
+        lists.push_back(list);
+    }
+    if (lists.empty()) {
+        return matches;
+    }
+
+    if (leaf.type == QueryNode::Type::Term) {
+        return candidates ? intersect(*candidates, lists.front()->docIds) : lists.front()->docIds;
+    }
+
+    // The candidate list, if any, joins the intersection after the term lists
+    std::vector<const std::vector<uint32_t>*> docLists;
+    for (const PostingList* list : lists) {
+        docLists.push_back(&list->docIds);
+    }
+    if (candidates) {
+        docLists.push_back(candidates);
+    }
+
+    // Drive the intersection from the shortest list
+    std::vector<size_t> order(docLists.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&docLists](size_t a, size_t b) {
+        return docLists[a]->size() < docLists[b]->size();
+    });
+
+    const std::vector<uint32_t>& driver = *docLists[order.front()];
+    std::vector<size_t> cursors(docLists.size(), 0);
+
+    for (size_t i = 0; i < driver.size(); ++i) {
+        uint32_t docId = driver[i];
+        cursors[order.front()] = i;
+
+        bool inAll = true;
+        for (size_t k = 1; k < order.size(); ++k) {
+            size_t j = order[k];
+            cursors[j] = gallop(*docLists[j], cursors[j], docId);
+            if (cursors[j] == docLists[j]->size()) {
+                return matches; // This list is exhausted, nothing further can match
+            }
+            if ((*docLists[j])[cursors[j]] != docId) {
+                inAll = false;
+                break;
+            }
+        }
+        if (!inAll) {
+            continue;
+        }
+
+        // The first lists.size() cursors are the posting indexes of the terms
+        bool matched = (leaf.type == QueryNode::Type::Phrase)
+            ? matchesPhrase(lists, cursors, leaf.offsets)
+            : matchesWithin(lists, cursors, leaf.distance);
+        if (matched) {
+            matches.push_back(docId);
+        }
+    }
+
+    return matches;
+}
+
+std::vector<uint32_t> QueryEvaluator::matchBoolean(const QueryNode& node) const {
+    std::vector<uint32_t> result;
+
+    if (!node.must.empty()) {
+        // Intersect the plain term postings first, shortest first, without copying them
+        std::vector<const std::vector<uint32_t>*> termLists;
+        std::vector<const QueryNode*> others;
+        for (const auto& child : node.must) {
+            if (child.type == QueryNode::Type::Term) {
+                const PostingList* list = index.getPostings(child.terms.front());
+                if (!list) {
+                    return result;
+                }
+                termLists.push_back(&list->docIds);
+            } else {
+                others.push_back(&child);
+            }
+        }
+
+        bool restricted = false;
+        if (!termLists.empty()) {
+            std::sort(termLists.begin(), termLists.end(),
+                      [](const std::vector<uint32_t>* a, const std::vector<uint32_t>* b) {
+                          return a->size() < b->size();
+                      });
+            result = *termLists.front();
+            for (size_t i = 1; i < termLists.size() && !result.empty(); ++i) {
+                result = intersect(result, *termLists[i]);
+            }
+            restricted = true;
+        }
+
+        // Phrases and proximity only check positions for the surviving candidates
+        std::stable_partition(others.begin(), others.end(),
+                              [](const QueryNode* child) { return child->isLeaf(); });
+        for (const QueryNode* child : others) {
+            if (restricted && result.empty()) {
+                return result;
+            }
+            if (child->isLeaf()) {
+                result = matchLeaf(*child, restricted ? &result : nullptr);
+            } else {
+                std::vector<uint32_t> sub = matchBoolean(*child);
+                result = restricted ? intersect(result, sub) : std::move(sub);
+            }
+            restricted = true;
+        }
+    } else if (!node.should.empty()) {
+        std::vector<std::vector<uint32_t>> evaluated;
+        evaluated.reserve(node.should.size());
+        std::vector<const std::vector<uint32_t>*> lists;
+        for (const auto& child : node.should) {
+            if (child.type == QueryNode::Type::Term) {
+                const PostingList* list = index.getPostings(child.terms.front());
+                if (list) {
+                    lists.push_back(&list->docIds);
+                }
+            } else {
+                evaluated.push_back(match(child));
+                lists.push_back(&evaluated.back());
+            }
+        }
+        result = unite(lists);
+    } else {
+        return result; // Only exclusions: matches nothing
+    }
+
+    for (const auto& child : node.mustNot) {
+        if (result.empty()) {
+            break;
+        }
+        if (child.type == QueryNode::Type::Term) {
+            const PostingList* list = index.getPostings(child.terms.front());
+            if (list) {
+                result = difference(result, list->docIds);
+            }
+        } else if (child.isLeaf()) {
+            result = difference(result, matchLeaf(child, &result));
+        } else {
+            result = difference(result, matchBoolean(child));
+        }
+    }
+
+    return result;
+}
+
+size_t QueryEvaluator::gallop(const std::vector<uint32_t>& values, size_t from, uint32_t target) {
+    size_t low = from;
+    size_t high = from;
+    size_t step = 1;
+    while (high < values.size() && values[high] < target) {
+        low = high + 1;
+        high += step;
+        step <<= 1;
+    }
+    high = std::min(high, values.size());
+    return std::lower_bound(values.begin() + low, values.begin() + high, target) - values.begin();
+}
+
+std::vector<uint32_t> QueryEvaluator::intersect(const std::vector<uint32_t>& a,
+                                                const std::vector<uint32_t>& b) {
+    const std::vector<uint32_t>& small = a.size() <= b.size() ? a : b;
+    const std::vector<uint32_t>& large = a.size() <= b.size() ? b : a;
+
+    std::vector<uint32_t> result;
+    size_t cursor = 0;
+    for (uint32_t docId : small) {
+        cursor = gallop(large, cursor, docId);
+        if (cursor == large.size()) {
+            break;
+        }
+        if (large[cursor] == docId) {
+            result.push_back(docId);
+        }
+    }
+    return result;
+}
+
+std::vector<uint32_t> QueryEvaluator::difference(const std::vector<uint32_t>& a,
+                                                 const std::vector<uint32_t>& b) {
+    std::vector<uint32_t> result;
+    result.reserve(a.size());
+    size_t cursor = 0;
+    for (uint32_t docId : a) {
+        cursor = gallop(b, cursor, docId);
+        if (cursor == b.size() || b[cursor] != docId) {
+            result.push_back(docId);
+        }
+    }
+    return result;
+}
+
+std::vector<uint32_t> QueryEvaluator::unite(const std::vector<const std::vector<uint32_t>*>& lists) {
+    if (lists.empty()) {
+        return std::vector<uint32_t>();
+    }
+    if (lists.size() == 1) {
+        return *lists.front();
+    }
+
+    // K-way merge: (docId, list) pairs in a min-heap
+    using Head = std::pair<uint32_t, size_t>;
+    std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heap;
+    std::vector<size_t> cursors(lists.size(), 0);
+    size_t total = 0;
+    for (size_t i = 0; i < lists.size(); ++i) {
+        total += lists[i]->size();
+        if (!lists[i]->empty()) {
+            heap.push({lists[i]->front(), i});
+        }
+    }
+
+    std::vector<uint32_t> result;
+    result.reserve(total);
+    while (!heap.empty()) {
+        Head head = heap.top();
+        heap.pop();
+        if (result.empty() || result.back() != head.first) {
+            result.push_back(head.first);
+        }
+        size_t i = head.second;
+        if (++cursors[i] < lists[i]->size()) {
+            heap.push({(*lists[i])[cursors[i]], i});
+        }
+    }
+    return result;
+}
+
+bool QueryEvaluator::matchesPhrase(const std::vector<const PostingList*>& lists,
+                                   const std::vector<size_t>& postings,
+                                   const std::vector<uint32_t>& offsets) {
+    for (size_t j = 0; j < lists.size(); ++j) {
+        if (!lists[j]->hasPositions(postings[j])) {
+            return true;
+        }
+    }
+
+    // Candidate phrase starts come from the term with the fewest occurrences
+    size_t driver = 0;
+    for (size_t j = 1; j < lists.size(); ++j) {
+        if (lists[j]->frequencies[postings[j]] < lists[driver]->frequencies[postings[driver]]) {
+            driver = j;
+        }
+    }
+
+    std::vector<const uint32_t*> cursors(lists.size());
+    for (size_t j = 0; j < lists.size(); ++j) {
+        cursors[j] = lists[j]->positionsBegin(postings[j]);
+    }
+
+    const uint32_t* end = lists[driver]->positionsEnd(postings[driver]);
+    for (const uint32_t* p = cursors[driver]; p != end; ++p) {
+        if (*p < offsets[driver]) {
+            continue;
+        }
+        uint32_t start = *p - offsets[driver];
+
+        bool aligned = true;
+        for (size_t j = 0; j < lists.size() && aligned; ++j) {
+            if (j == driver) {
+                continue;
+            }
+            // Starts only increase, so each cursor only moves forward
+            uint32_t target = start + offsets[j];
+            const uint32_t* last = lists[j]->positionsEnd(postings[j]);
+            while (cursors[j] != last && *cursors[j] < target) {
+                ++cursors[j];
+            }
+            if (cursors[j] == last) {
+                return false;
+            }
+            aligned = (*cursors[j] == target);
+        }
+        if (aligned) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool QueryEvaluator::matchesWithin(const std::vector<const PostingList*>& lists,
+                                   const std::vector<size_t>& postings,
+                                   uint32_t distance) {
+    for (size_t j = 0; j < lists.size(); ++j) {
+        if (!lists[j]->hasPositions(postings[j])) {
+            return true;
+        }
+    }
+
+    // A term repeated in the query needs as many distinct occurrences in the window
+    std::vector<size_t> terms;
+    std::vector<size_t> counts;
+    for (size_t j = 0; j < lists.size(); ++j) {
+        size_t k = 0;
+        while (k < terms.size() && lists[terms[k]] != lists[j]) {
+            k++;
+        }
+        if (k == terms.size()) {
+            terms.push_back(j);
+            counts.push_back(0);
+        }
+        counts[k]++;
+    }
+
+    std::vector<const uint32_t*> cursors(terms.size());
+    std::vector<const uint32_t*> ends(terms.size());
+    for (size_t k = 0; k < terms.size(); ++k) {
+        size_t j = terms[k];
+        cursors[k] = lists[j]->positionsBegin(postings[j]);
+        ends[k] = lists[j]->positionsEnd(postings[j]);
+        if (static_cast<size_t>(ends[k] - cursors[k]) < counts[k]) {
+            return false;
+        }
+    }
+
+    // Slide a window over the merged position lists, always advancing its lowest end;
+    // each term covers its next counts[k] occurrences
+    while (true) {
+        size_t lowest = 0;
+        uint32_t minPos = *cursors[0];
+        uint32_t maxPos = cursors[0][counts[0] - 1];
+        for (size_t k = 1; k < cursors.size(); ++k) {
+            if (*cursors[k] < minPos) {
+                minPos = *cursors[k];
+                lowest = k;
+            }
+            maxPos = std::max(maxPos, cursors[k][counts[k] - 1]);
+        }
+        if (maxPos - minPos <= distance) {
+            return true;
+        }
+        if (static_cast<size_t>(ends[lowest] - ++cursors[lowest]) < counts[lowest]) {
+            return false;
+        }
+    }
+}
@@ -0,0 +1,521 @@
+#include "core/QueryParser.h"
+#include <cctype>
+#include <algorithm>
+
+namespace {
+
+struct Lexeme {
+    enum class Kind { Word, Phrase, And, Or, Not, Plus, Minus, Open, Close, Near, End };
+
+    Kind kind;
+    std::string text;
+    uint32_t distance;
+};
+
+bool parseNearOperator(const std::string& word, uint32_t& distance) {
+    const std::string prefix = "NEAR/";
+    if (word.size() <= prefix.size() || word.compare(0, prefix.size(), prefix) != 0) {
+        return false;
+    }
+
+    uint32_t value = 0;
+    for (size_t i = prefix.size(); i < word.size(); ++i) {
+        if (!std::isdigit(static_cast<unsigned char>(word[i])) || value > 100000) {
+            return false;
+        }
+        value = value * 10 + static_cast<uint32_t>(word[i] - '0');
+    }
+    distance = value;
+    return true;
+}
+
+std::vector<Lexeme> lex(const std::string& query) {
+    std::vector<Lexeme> lexemes;
+    size_t i = 0;
+    while (i < query.size()) {
+        char c = query[i];
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            i++;
+            continue;
+        }
+
+        if (c == '"') {
+            size_t close = query.find('"', i + 1);
+            size_t end = (close == std::string::npos) ? query.size() : close;
+            lexemes.push_back({Lexeme::Kind::Phrase, query.substr(i + 1, end - i - 1), 0});
+            i = (close == std::string::npos) ? query.size() : close + 1;
+            continue;
+        }
+        if (c == '(' || c == ')') {
+            lexemes.push_back({c == '(' ? Lexeme::Kind::Open : Lexeme::Kind::Close, "", 0});
+            i++;
+            continue;
+        }
+        // A leading + or - marks the following operand as required or excluded
+        if ((c == '+' || c == '-') && i + 1 < query.size() &&
+            !std::isspace(static_cast<unsigned char>(query[i + 1]))) {
+            lexemes.push_back({c == '+' ? Lexeme::Kind::Plus : Lexeme::Kind::Minus, "", 0});
+            i++;
+            continue;
+        }
+
+        size_t start = i;
+        while (i < query.size() && query[i] != '"' && query[i] != '(' && query[i] != ')' &&
+               !std::isspace(static_cast<unsigned char>(query[i]))) {
+            i++;
+        }
+        std::string word = query.substr(start, i - start);
+
+        uint32_t distance = 0;
+        if (word == "AND") {
+            lexemes.push_back({Lexeme::Kind::And, "", 0});
+        } else if (word == "OR") {
+            lexemes.push_back({Lexeme::Kind::Or, "", 0});
+        } else if (word == "NOT") {
+            lexemes.push_back({Lexeme::Kind::Not, "", 0});
+        } else if (parseNearOperator(word, distance)) {
+            lexemes.push_back({Lexeme::Kind::Near, "", distance});
+        } else {
+            lexemes.push_back({Lexeme::Kind::Word, word, 0});
+        }
+    }
+    lexemes.push_back({Lexeme::Kind::End, "", 0});
+    return lexemes;
+}
+
+/**
+ * @brief Recursive-descent parser over the lexemes of one query.
+ *
+ * Grammar, loosest binding first:
+ *   group   := operand*             (juxtaposed operands are optional)
+ *   or      := and ('OR' and)*
+ *   and     := unary ('AND' unary)*
+ *   unary   := ('+' | '-' | 'NOT') unary | primary
+ *   primary := '(' group ')' | PHRASE | WORD ('NEAR/k' WORD)*
+ */
+class QueryParserState {
+public:
+    QueryParserState(const std::string& query, const Tokenizer& tokenizer,
+                     const StopWordRemover& stopWordRemover, const Stemmer* stemmer)
+        : lexemes(lex(query)), position(0),
+          tokenizer(tokenizer), stopWordRemover(stopWordRemover), stemmer(stemmer), exclusions(0) {
+    }
+
+    /**
+     * @brief Gets the words of the terms parsed outside exclusions, before stemming.
+     */
+    std::vector<std::string>& getWords() {
+        return words;
+    }
+
+    QueryNode parseQuery() {
+        std::vector<Operand> operands;
+        while (peek() != Lexeme::Kind::End) {
+            if (peek() == Lexeme::Kind::Close) {
+                position++; // Unbalanced ')'
+                continue;
+            }
+            operands.push_back(parseOr());
+        }
+        return combine(operands, Occur::Should);
+    }
+
+private:
+    enum class Occur { Default, Must, Should, MustNot };
+
+    struct Operand {
+        Occur occur;
+        QueryNode node;
+    };
+
+    std::vector<Lexeme> lexemes;
+    size_t position;
+    const Tokenizer& tokenizer;
+    const StopWordRemover& stopWordRemover;
+    const Stemmer* stemmer;
+    size_t exclusions; // depth of '-' / NOT operands being parsed
+    std::vector<std::string> words;
+
+    Lexeme::Kind peek() const {
+        return lexemes[position].kind;
+    }
+
+    QueryNode parseGroup() {
+        std::vector<Operand> operands;
+        while (peek() != Lexeme::Kind::End && peek() != Lexeme::Kind::Close) {
+            operands.push_back(parseOr());
+        }
+        return combine(operands, Occur::Should);
+    }
+
+    Operand parseOr() {
+        std::vector<Operand> operands;
+        operands.push_back(parseAnd());
+        while (peek() == Lexeme::Kind::Or) {
+            position++;
+            operands.push_back(parseAnd());
+        }
+        if (operands.size() == 1) {
+            return std::move(operands.front());
+        }
+        return {Occur::Default, combine(operands, Occur::Should)};
+    }
+
+    Operand parseAnd() {
+        std::vector<Operand> operands;
+        operands.push_back(parseUnary());
+        while (peek() == Lexeme::Kind::And) {
+            position++;
+            operands.push_back(parseUnary());
+        }
+        if (operands.size() == 1) {
+            return std::move(operands.front());
+        }
+        return {Occur::Default, combine(operands, Occur::Must)};
+    }
+
+    Operand parseUnary() {
+        Lexeme::Kind kind = peek();
+        if (kind == Lexeme::Kind::Plus || kind == Lexeme::Kind::Minus || kind == Lexeme::Kind::Not) {
+            position++;
+            size_t excluding = (kind == Lexeme::Kind::Plus) ? 0 : 1;
+            exclusions += excluding;
+            Operand operand = parseUnary();
+            exclusions -= excluding;
+            operand.occur = (kind == Lexeme::Kind::Plus) ? Occur::Must : Occur::MustNot;
+            return operand;
+        }
+        return {Occur::Default, parsePrimary()};
+    }
+
+    QueryNode parsePrimary() {
+        const Lexeme& lexeme = lexemes[position];
+        switch (lexeme.kind) {
+            case Lexeme::Kind::Open: {
+                position++;
+                QueryNode group = parseGroup();
+                if (peek() == Lexeme::Kind::Close) {
+                    position++;
+                }
+                return group;
+            }
+            case Lexeme::Kind::Phrase:
+                position++;
+                return makePhrase(lexeme.text);
+            case Lexeme::Kind::Word:
+                position++;
+                if (lexeme.text.find_first_of("*?") != std::string::npos) {
+                    return makeWildcard(lexeme.text);
+                }
+                if (lexeme.text.find('~') != std::string::npos) {
+                    return makeFuzzy(lexeme.text);
+                }
+                return parseProximity(analyzeRuns(lexeme.text));
+            case Lexeme::Kind::End:
+            case Lexeme::Kind::Close:
+                return QueryNode();
+            default:
+                position++; // Dangling operator
+                return QueryNode();
+        }
+    }
+
+    /**
+     * @brief Builds the node for a word, folding in any following NEAR/k operands.
+     *
+     * @param runs The word's runs of unseparated tokens (see analyzeRuns())
+     */
+    QueryNode parseProximity(std::vector<QueryNode> runs) {
+        // Runs after the first one that joins a NEAR stay as plain optional runs
+        std::vector<QueryNode> extra;
+        // Runs of several tokens whose outer token joins the NEAR window; they are required too
+        std::vector<QueryNode> sequences;
+        QueryNode node;
+
+        if (!runs.empty()) {
+            node = std::move(runs.back());
+            runs.pop_back();
+        }
+
+        while (peek() == Lexeme::Kind::Near && lexemes[position + 1].kind == Lexeme::Kind::Word) {
+            uint32_t distance = lexemes[position].distance;
+            std::vector<QueryNode> right = analyzeRuns(lexemes[position + 1].text);
+            position += 2;
+            if (node.terms.empty() || right.empty()) {
+                continue;
+            }
+
+            // Chained NEAR operators extend one window using the largest distance
+            if (node.type != QueryNode::Type::Near) {
+                if (node.type == QueryNode::Type::Phrase) {
+                    std::string last = node.terms.back();
+                    sequences.push_back(std::move(node));
+                    node = makeTerm(std::move(last));
+                }
+                node.type = QueryNode::Type::Near;
+                node.distance = distance;
+            } else {
+                node.distance = std::max(node.distance, distance);
+            }
+            node.terms.push_back(right.front().terms.front());
+            if (right.front().type == QueryNode::Type::Phrase) {
+                sequences.push_back(std::move(right.front()));
+            }
+            std::move(right.begin() + 1, right.end(), std::back_inserter(extra));
+        }
+
+        if (!sequences.empty()) {
+            QueryNode required;
+            required.must.push_back(std::move(node));
+            std::move(sequences.begin(), sequences.end(), std::back_inserter(required.must));
+            node = std::move(required);
+        }
+        if (runs.empty() && extra.empty()) {
+            return node;
+        }
+
+        // A word split by punctuation (e.g. "foo-bar") matches any of its runs
+        QueryNode group;
+        std::move(runs.begin(), runs.end(), std::back_inserter(group.should));
+        if (!node.isEmpty()) {
+            group.should.push_back(std::move(node));
+        }
+        std::move(extra.begin(), extra.end(), std::back_inserter(group.should));
+        return group;
+    }
+
+    QueryNode makeTerm(std::string term) const {
+        QueryNode node;
+        node.type = QueryNode::Type::Term;
+        node.terms.push_back(std::move(term));
+        return node;
+    }
+
+    QueryNode makePhrase(const std::string& text) {
+        std::vector<std::string> tokens = tokenizer.tokenize(text);
+        return makeSequence(tokens, 0, tokens.size());
+    }
+
+    /**
+     * @brief Builds a Phrase of tokens [begin, end), or a Term if only one survives stop word removal.
+     */
+    QueryNode makeSequence(const std::vector<std::string>& tokens, size_t begin, size_t end) {
+        QueryNode node;
+        node.type = QueryNode::Type::Phrase;
+        size_t first = begin;
+        for (size_t i = begin; i < end; ++i) {
+            if (stopWordRemover.isStopWord(tokens[i])) {
+                continue;
+            }
+            if (node.terms.empty()) {
+                first = i;
+            }
+            node.terms.push_back(normalize(tokens[i]));
+            node.offsets.push_back(static_cast<uint32_t>(i - first));
+        }
+
+        if (node.terms.size() == 1) {
+            node.type = QueryNode::Type::Term;
+            node.offsets.clear();
+        }
+        return node;
+    }
+
+    /**
+     * @brief Normalizes a wildcard word the way the tokenizer normalizes terms.
+     */
+    QueryNode makeWildcard(const std::string& word) const {
+        std::string pattern;
+        bool hasLiteral = false;
+        size_t literalStart = 0;
+        for (size_t i = 0; i <= word.size(); ++i) {
+            if (i < word.size() && word[i] != '*' && word[i] != '?') {
+                continue;
+            }
+            size_t before = pattern.size();
+            Tokenizer::foldWord(std::string_view(word).substr(literalStart, i - literalStart), pattern);
+            hasLiteral = hasLiteral || pattern.size() > before;
+            if (i < word.size() && (word[i] == '?' || pattern.empty() || pattern.back() != '*')) {
+                pattern += word[i];
+            }
+            literalStart = i + 1;
+        }
+
+        // A bare "*" would expand to the whole vocabulary
+        QueryNode node;
+        if (hasLiteral) {
+            node.type = QueryNode::Type::Wildcard;
+            node.terms.push_back(pattern);
+        }
+        return node;
+    }
+
+    /**
+     * @brief Builds the node for `word~` or `word~N`.
+     *
+     * Without N the edit budget follows the term length: none up to 2
+     * characters, one up to 5, two beyond. More than 2 edits are not allowed.
+     */
+    QueryNode makeFuzzy(const std::string& word) {
+        size_t tilde = word.rfind('~');
+        std::string suffix = word.substr(tilde + 1);
+        bool automatic = suffix.empty() ||
+            !std::all_of(suffix.begin(), suffix.end(), [](char c) { return std::isdigit(static_cast<unsigned char>(c)); });
+        uint32_t requested = automatic ? 0 : static_cast<uint32_t>(std::min<size_t>(std::stoul(suffix.substr(0, 2)), 2));
+
+        QueryNode group;
+        for (auto& run : analyzeRuns(word.substr(0, tilde))) {
+            // Ideographs are single characters; a run of them is matched as a phrase
+            if (run.type == QueryNode::Type::Phrase) {
+                group.should.push_back(std::move(run));
+                continue;
+            }
+
+            uint32_t edits = requested;
+            if (automatic) {
+                size_t length = Tokenizer::countCharacters(run.terms.front());
+                edits = length <= 2 ? 0 : (length <= 5 ? 1 : 2);
+            }
+            if (edits > 0) {
+                run.type = QueryNode::Type::Fuzzy;
+                run.distance = edits;
+            }
+            group.should.push_back(std::move(run));
+        }
+
+        if (group.should.size() == 1) {
+            QueryNode only = std::move(group.should.front());
+            return only;
+        }
+        return group;
+    }
+
+    /**
+     * @brief Tokenizes a query word into runs of tokens that are not separated in it.
+     *
+     * Ideographs are tokens of their own, so "東京" is one run of two tokens
+     * that must match as a phrase, while "foo-bar" is two runs of one token.
+     *
+     * @return One Term or Phrase node per run that survives stop word removal
+     */
+    std::vector<QueryNode> analyzeRuns(const std::string& word) {
+        std::vector<TokenSpan> spans;
+        std::vector<std::string> tokens = tokenizer.tokenize(word, spans);
+
+        std::vector<QueryNode> runs;
+        size_t begin = 0;
+        for (size_t i = 1; i <= tokens.size(); ++i) {
+            if (i < tokens.size() && spans[i - 1].end == spans[i].begin) {
+                continue;
+            }
+            QueryNode run = makeSequence(tokens, begin, i);
+            if (!run.isEmpty()) {
+                runs.push_back(std::move(run));
+            }
+            begin = i;
+        }
+        return runs;
+    }
+
+    std::string normalize(const std::string& token) {
+        if (exclusions == 0) {
+            words.push_back(token);
+        }
+        return stemmer ? stemmer->stem(token) : token;
+    }
+
+    /**
+     * @brief Combines operands into a Boolean node, simplifying trivial results.
+     *
+     * @param operands Operands with their explicit occurrence, if any
+     * @param defaultOccur Occurrence for operands without a + / - / NOT prefix
+     */
+    static QueryNode combine(std::vector<Operand>& operands, Occur defaultOccur) {
+        QueryNode node;
+        for (auto& operand : operands) {
+            if (operand.node.isEmpty()) {
+                continue;
+            }
+            Occur occur = (operand.occur == Occur::Default) ? defaultOccur : operand.occur;
+            std::vector<QueryNode>& target = (occur == Occur::Must) ? node.must
+                                           : (occur == Occur::MustNot) ? node.mustNot
+                                           : node.should;
+
+            // (a OR b) OR c and (a AND b) AND c flatten into one node
+            QueryNode& child = operand.node;
+            bool pureShould = !child.isLeaf() && child.must.empty() && child.mustNot.empty();
+            bool pureMust = !child.isLeaf() && child.should.empty() && child.mustNot.empty();
+            if (occur == Occur::Should && pureShould) {
+                std::move(child.should.begin(), child.should.end(), std::back_inserter(node.should));
+            } else if (occur == Occur::Must && pureMust) {
+                std::move(child.must.begin(), child.must.end(), std::back_inserter(node.must));
+            } else {
+                target.push_back(std::move(child));
+            }
+        }
+
+        // A single positive child needs no wrapper
+        if (node.mustNot.empty() && node.must.size() + node.should.size() == 1) {
+            QueryNode only = std::move(node.must.empty() ? node.should.front() : node.must.front());
+            return only;
+        }
+        return node;
+    }
+};
+
+void collectTerms(const QueryNode& node, std::vector<std::string>& terms) {
+    if (node.isLeaf()) {
+        terms.insert(terms.end(), node.terms.begin(), node.terms.end());
+        return;
+    }
+    for (const auto& child : node.must) {
+        collectTerms(child, terms);
+    }
+    for (const auto& child : node.should) {
+        collectTerms(child, terms);
+    }
+}
+
+void collectLeaves(const QueryNode& node, std::vector<const QueryNode*>& leaves) {
+    if (node.isLeaf()) {
+        if (!node.terms.empty()) {
+            leaves.push_back(&node);
+        }
+        return;
+    }
+    for (const auto& child : node.must) {
+        collectLeaves(child, leaves);
+    }
+    for (const auto& child : node.should) {
+        collectLeaves(child, leaves);
+    }
+}
+
+} // namespace
+
+std::vector<std::string> Query::getTerms() const {
+    std::vector<std::string> terms;
+    collectTerms(root, terms);
+    return terms;
+}
+
+std::vector<const QueryNode*> Query::getScoringLeaves() const {
+    std::vector<const QueryNode*> leaves;
+    collectLeaves(root, leaves);
+    return leaves;
+}
+
+QueryParser::QueryParser() : stemmer(nullptr) {
+}
+
+Query QueryParser::parse(const std::string& query) const {
+    QueryParserState state(query, tokenizer, stopWordRemover, stemmer);
+    Query result;
+    result.root = state.parseQuery();
+    result.words = std::move(state.getWords());
+    return result;
+}
+
+void QueryParser::setStemmer(const Stemmer* wordStemmer) {
+    stemmer = wordStemmer;
+}
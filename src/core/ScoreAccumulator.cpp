@@ -0,0 +1,109 @@
+#include "core/ScoreAccumulator.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SCOREACCUMULATOR_SSE2 1
+#endif
+
+namespace {
+
+bool byScore(const ScoredDocument& a, const ScoredDocument& b) {
+    return a.score != b.score ? a.score > b.score : a.docId < b.docId;
+}
+
+/**
+ * @brief Keeps the k best candidates.
+ *
+ * @return Score of the k-th best, which later candidates have to beat
+ */
+float prune(std::vector<ScoredDocument>& candidates, size_t k) {
+    std::nth_element(candidates.begin(), candidates.begin() + (k - 1), candidates.end(), byScore);
+    candidates.resize(k);
+    return static_cast<float>(candidates[k - 1].score);
+}
+
+} // namespace
+
+ScoreAccumulator::ScoreAccumulator()
+    : documentCount(0), touchedLimit(0), overflowed(false) {
+}
+
+void ScoreAccumulator::reset(size_t count) {
+    if (overflowed) {
+        std::memset(static_cast<void*>(blocks.data()), 0, blocks.size() * sizeof(Block));
+    } else {
+        for (uint32_t docId : touched) {
+            blocks[docId / BlockSize].values[docId % BlockSize] = 0.0f;
+        }
+    }
+    touched.clear();
+    overflowed = false;
+
+    // Past this many documents, clearing the whole array is cheaper than the list
+    documentCount = count;
+    touchedLimit = std::max<size_t>(count / 8, 1024);
+    blocks.resize((count + BlockSize - 1) / BlockSize, Block());
+}
+
+void ScoreAccumulator::topK(size_t k, std::vector<ScoredDocument>& candidates) const {
+    candidates.clear();
+    if (overflowed) {
+        scan(0.0f, k, candidates);
+    } else {
+        candidates.reserve(touched.size());
+        for (uint32_t docId : touched) {
+            float score = get(docId);
+            if (score > 0.0f) {
+                candidates.push_back({docId, score});
+            }
+        }
+        if (k > 0 && candidates.size() > k) {
+            prune(candidates, k);
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end(), byScore);
+}
+
+void ScoreAccumulator::scan(float threshold, size_t k, std::vector<ScoredDocument>& candidates) const {
+    // Candidates are found in docId order, so a later document scoring exactly
+    // the current threshold would lose the tie anyway and can be skipped
+    const size_t pruneAt = k > 0 ? 2 * k + 64 : 0;
+    const size_t lastBlock = blocks.size();
+
+    for (size_t b = 0; b < lastBlock; ++b) {
+        const float* values = blocks[b].values;
+        uint32_t base = static_cast<uint32_t>(b * BlockSize);
+
+#ifdef SCOREACCUMULATOR_SSE2
+        __m128 limit = _mm_set1_ps(threshold);
+        for (size_t i = 0; i < BlockSize; i += 4) {
+            int mask = _mm_movemask_ps(_mm_cmpgt_ps(_mm_load_ps(values + i), limit));
+            while (mask != 0) {
+                int lane = 0;
+                while (!(mask & (1 << lane))) {
+                    lane++;
+                }
+                mask &= mask - 1;
+                candidates.push_back({base + static_cast<uint32_t>(i + lane), values[i + lane]});
+            }
+        }
+#else
+        for (size_t i = 0; i < BlockSize; ++i) {
+            if (values[i] > threshold) {
+                candidates.push_back({base + static_cast<uint32_t>(i), values[i]});
+            }
+        }
+#endif
+
+        if (pruneAt > 0 && candidates.size() >= pruneAt) {
+            threshold = std::max(threshold, prune(candidates, k));
+        }
+    }
+
+    if (k > 0 && candidates.size() > k) {
+        prune(candidates, k);
+    }
+}
@@ -0,0 +1,310 @@
+#include "core/Scorer.h"
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+// Budgeted queries check their budget after each window of this many docIds
+constexpr uint64_t BudgetWindow = 8192;
+
+// ... and after each chunk of this many Boolean matches
+constexpr size_t BudgetChunk = 1024;
+
+// A document's static rank is the number of terms whose best this many postings include it
+constexpr size_t StaticRankDepth = 10;
+
+} // namespace
+
+Scorer::Scorer(const DocumentIndexer& indexer)
+    : indexer(indexer), model(ScoringModel::BM25), normsStale(true), statisticsStale(true) {
+}
+
+void Scorer::setModel(ScoringModel newModel) {
+    if (newModel != model) {
+        model = newModel;
+        std::lock_guard<std::mutex> lock(normsMutex);
+        normsStale = true;
+    }
+}
+
+ScoringModel Scorer::getModel() const {
+    return model;
+}
+
+void Scorer::setBM25Parameters(double k1, double b, double delta) {
+    bm25.k1 = k1;
+    bm25.b = b;
+    bm25.delta = delta;
+    std::lock_guard<std::mutex> lock(normsMutex);
+    normsStale = true;
+}
+
+CollectionStatistics Scorer::getCollectionStatistics() const {
+    std::lock_guard<std::mutex> lock(normsMutex);
+    refreshLocalStatistics();
+    return localStatistics;
+}
+
+GlobalStatistics Scorer::getStatistics(const std::vector<std::string>& terms) const {
+    GlobalStatistics stats;
+    stats.collection = getCollectionStatistics();
+    const InvertedIndex& index = indexer.getInvertedIndex();
+    for (const auto& term : terms) {
+        const PostingList* list = index.getPostings(term);
+        if (list) {
+            stats.documentFrequencies[term] = list->size();
+        }
+    }
+    return stats;
+}
+
+std::vector<double> Scorer::getStaticRanks() const {
+    std::vector<double> ranks(indexer.getDocuments().size(), 0.0);
+    const InvertedIndex& index = indexer.getInvertedIndex();
+    const TermDictionary& dictionary = index.getTermDictionary();
+    std::vector<double> contributions;
+    std::vector<std::pair<double, uint32_t>> best;
+    for (TermDictionary::Iterator it = dictionary.begin(); it.valid(); it.next()) {
+        const PostingList* list = index.getPostings(it.term());
+        if (!list || list->size() == 0) {
+            continue;
+        }
+        scorePostings(*list, contributions);
+        best.clear();
+        for (size_t i = 0; i < list->size(); ++i) {
+            best.push_back({contributions[i], list->docIds[i]});
+        }
+        size_t count = std::min(StaticRankDepth, best.size());
+        std::nth_element(best.begin(), best.begin() + (count - 1), best.end(),
+                         std::greater<std::pair<double, uint32_t>>());
+        for (size_t i = 0; i < count; ++i) {
+            if (best[i].second < ranks.size()) {
+                ranks[best[i].second] += 1.0;
+            }
+        }
+    }
+    return ranks;
+}
+
+void Scorer::invalidate() {
+    std::lock_guard<std::mutex> lock(normsMutex);
+    normsStale = true;
+    statisticsStale = true;
+}
+
+void Scorer::refreshLocalStatistics() const {
+    if (!statisticsStale) {
+        return;
+    }
+    localStatistics = CollectionStatistics();
+    for (const auto& doc : indexer.getDocuments()) {
+        localStatistics.documentCount++;
+        localStatistics.totalTerms += static_cast<uint64_t>(doc->totalTerms);
+    }
+    statisticsStale = false;
+}
+
+template <typename Policy>
+std::shared_ptr<const Scorer::LengthNorms> Scorer::prepare(const Policy& policy, const GlobalStatistics* global) const {
+    std::lock_guard<std::mutex> lock(normsMutex);
+    refreshLocalStatistics();
+
+    const CollectionStatistics& target = global ? global->collection : localStatistics;
+    bool sameStatistics = lengthNorms && target.documentCount == lengthNorms->statistics.documentCount &&
+                          target.totalTerms == lengthNorms->statistics.totalTerms;
+    if (normsStale || !sameStatistics) {
+        auto computed = std::make_shared<LengthNorms>();
+        computed->statistics = target;
+        const auto& documents = indexer.getDocuments();
+        computed->norms.resize(documents.size());
+        for (size_t i = 0; i < documents.size(); ++i) {
+            computed->norms[i] = policy.lengthNorm(static_cast<uint32_t>(documents[i]->totalTerms), target);
+        }
+        lengthNorms = std::move(computed);
+        normsStale = false;
+    }
+    return lengthNorms;
+}
+
+template <typename Policy>
+void Scorer::accumulate(const Policy& policy, const std::vector<const QueryNode*>& leaves,
+                        const QueryEvaluator& evaluator, const std::vector<uint32_t>& matches,
+                        std::vector<double>& scores, const GlobalStatistics* global,
+                        QueryBudget* budget) const {
+    std::shared_ptr<const LengthNorms> snapshot = prepare(policy, global);
+    const CollectionStatistics& statistics = snapshot->statistics;
+    const std::vector<double>& norms = snapshot->norms;
+    const InvertedIndex& index = indexer.getInvertedIndex();
+
+    // Unbudgeted queries score all matches as one chunk
+    std::vector<uint32_t> chunk;
+    size_t chunkSize = budget ? BudgetChunk : matches.size();
+    for (size_t chunkBegin = 0; chunkBegin < matches.size(); chunkBegin += chunkSize) {
+        if (budget && chunkBegin > 0 && budget->shouldStop()) {
+            break;
+        }
+        size_t chunkEnd = std::min(matches.size(), chunkBegin + chunkSize);
+        const std::vector<uint32_t>* candidates = &matches;
+        if (chunkBegin > 0 || chunkEnd < matches.size()) {
+            chunk.assign(matches.begin() + chunkBegin, matches.begin() + chunkEnd);
+            candidates = &chunk;
+        }
+
+        for (const QueryNode* leaf : leaves) {
+            std::vector<uint32_t> leafMatches = evaluator.matchLeaf(*leaf, candidates);
+            if (leafMatches.empty()) {
+                continue;
+            }
+
+            // Each term of the leaf contributes its own score to the documents the leaf matches
+            for (const auto& term : leaf->terms) {
+                const PostingList* list = index.getPostings(term);
+                if (!list) {
+                    continue;
+                }
+                uint64_t df = global ? global->getDocumentFrequency(term, list->size()) : list->size();
+                double weight = leaf->boost * policy.termWeight(df, statistics);
+
+                size_t slot = chunkBegin;
+                size_t posting = 0;
+                for (uint32_t docId : leafMatches) {
+                    posting = QueryEvaluator::gallop(list->docIds, posting, docId);
+                    if (posting == list->size()) {
+                        break;
+                    }
+                    if (list->docIds[posting] != docId) {
+                        continue;
+                    }
+                    while (matches[slot] != docId) {
+                        slot++;
+                    }
+                    scores[slot] += policy.score(list->frequencies[posting], weight, norms[docId]);
+                }
+                if (budget) {
+                    budget->charge(leafMatches.size());
+                }
+            }
+        }
+    }
+}
+
+template <typename Policy>
+void Scorer::scoreList(const Policy& policy, const PostingList& list, std::vector<double>& contributions) const {
+    std::shared_ptr<const LengthNorms> snapshot = prepare(policy, nullptr);
+    const std::vector<double>& norms = snapshot->norms;
+    double weight = policy.termWeight(list.size(), snapshot->statistics);
+    contributions.resize(list.size());
+    for (size_t i = 0; i < list.size(); ++i) {
+        contributions[i] = policy.score(list.frequencies[i], weight, norms[list.docIds[i]]);
+    }
+}
+
+template <typename Policy>
+void Scorer::accumulateTerms(const Policy& policy, const std::vector<const QueryNode*>& leaves,
+                             ScoreAccumulator& accumulator, const GlobalStatistics* global,
+                             QueryBudget* budget) const {
+    std::shared_ptr<const LengthNorms> snapshot = prepare(policy, global);
+    const CollectionStatistics& statistics = snapshot->statistics;
+    const InvertedIndex& index = indexer.getInvertedIndex();
+    const double* norms = snapshot->norms.data();
+
+    if (!budget) {
+        for (const QueryNode* leaf : leaves) {
+            const std::string& term = leaf->terms.front();
+            const PostingList* list = index.getPostings(term);
+            if (!list) {
+                continue;
+            }
+            uint64_t df = global ? global->getDocumentFrequency(term, list->size()) : list->size();
+            double weight = leaf->boost * policy.termWeight(df, statistics);
+            const uint32_t* docIds = list->docIds.data();
+            const uint32_t* frequencies = list->frequencies.data();
+            for (size_t i = 0, n = list->size(); i < n; ++i) {
+                accumulator.add(docIds[i], static_cast<float>(policy.score(frequencies[i], weight, norms[docIds[i]])));
+            }
+        }
+        return;
+    }
+
+    // With a budget, all terms move through the same docId window before the next
+    // check, so the windows done hold complete scores and the rest holds none
+    struct TermCursor {
+        const PostingList* list;
+        double weight;
+        size_t next;
+    };
+    std::vector<TermCursor> cursors;
+    uint64_t remaining = 0;
+    for (const QueryNode* leaf : leaves) {
+        const std::string& term = leaf->terms.front();
+        const PostingList* list = index.getPostings(term);
+        if (!list || list->size() == 0) {
+            continue;
+        }
+        uint64_t df = global ? global->getDocumentFrequency(term, list->size()) : list->size();
+        cursors.push_back({list, leaf->boost * policy.termWeight(df, statistics), 0});
+        remaining += list->size();
+    }
+
+    for (uint64_t windowEnd = BudgetWindow; remaining > 0; windowEnd += BudgetWindow) {
+        if (windowEnd > BudgetWindow && budget->shouldStop()) {
+            break;
+        }
+        for (TermCursor& cursor : cursors) {
+            const uint32_t* docIds = cursor.list->docIds.data();
+            const uint32_t* frequencies = cursor.list->frequencies.data();
+            size_t i = cursor.next;
+            for (size_t n = cursor.list->size(); i < n && docIds[i] < windowEnd; ++i) {
+                accumulator.add(docIds[i], static_cast<float>(policy.score(frequencies[i], cursor.weight, norms[docIds[i]])));
+            }
+            budget->charge(i - cursor.next);
+            remaining -= i - cursor.next;
+            cursor.next = i;
+        }
+    }
+}
+
+void Scorer::scoreTerms(const std::vector<const QueryNode*>& leaves, ScoreAccumulator& accumulator,
+                        const GlobalStatistics* global, QueryBudget* budget) const {
+    switch (model) {
+        case ScoringModel::TFIDF:
+            accumulateTerms(TFIDFScoring(), leaves, accumulator, global, budget);
+            break;
+        case ScoringModel::BM25:
+            accumulateTerms(static_cast<const BM25Scoring&>(bm25), leaves, accumulator, global, budget);
+            break;
+        case ScoringModel::BM25Plus:
+            accumulateTerms(bm25, leaves, accumulator, global, budget);
+            break;
+    }
+}
+
+void Scorer::scorePostings(const PostingList& list, std::vector<double>& contributions) const {
+    switch (model) {
+        case ScoringModel::TFIDF:
+            scoreList(TFIDFScoring(), list, contributions);
+            break;
+        case ScoringModel::BM25:
+            scoreList(static_cast<const BM25Scoring&>(bm25), list, contributions);
+            break;
+        case ScoringModel::BM25Plus:
+            scoreList(bm25, list, contributions);
+            break;
+    }
+}
+
+void Scorer::score(const std::vector<const QueryNode*>& leaves, const QueryEvaluator& evaluator,
+                   const std::vector<uint32_t>& matches, std::vector<double>& scores,
+                   const GlobalStatistics* global, QueryBudget* budget) const {
+    switch (model) {
+        case ScoringModel::TFIDF:
+            accumulate(TFIDFScoring(), leaves, evaluator, matches, scores, global, budget);
+            break;
+        case ScoringModel::BM25:
+            accumulate(static_cast<const BM25Scoring&>(bm25), leaves, evaluator, matches, scores, global, budget);
+            break;
+        case ScoringModel::BM25Plus:
+            accumulate(bm25, leaves, evaluator, matches, scores, global, budget);
+            break;
+    }
+}
@@ -0,0 +1,44 @@
+#include "core/ScratchArena.h"
+#include <algorithm>
+
+ScratchArena::ScratchArena(size_t initialCapacity)
+    : buffer(std::make_unique<std::byte[]>(std::max<size_t>(initialCapacity, 1024))),
+      capacity(std::max<size_t>(initialCapacity, 1024)) {
+    resource.emplace(buffer.get(), capacity, &overflow);
+}
+
+std::pmr::memory_resource* ScratchArena::getResource() {
+    return &*resource;
+}
+
+void ScratchArena::release() {
+    size_t borrowed = overflow.getBorrowed();
+    resource->release();
+    overflow.resetBorrowed();
+    if (borrowed == 0 || capacity >= MaxRetainedCapacity) {
+        return;
+    }
+
+    // Make the next cycle of the same size fit in the buffer
+    capacity = std::min(MaxRetainedCapacity, capacity + borrowed);
+    resource.reset();
+    buffer = std::make_unique<std::byte[]>(capacity);
+    resource.emplace(buffer.get(), capacity, &overflow);
+}
+
+size_t ScratchArena::getCapacity() const {
+    return capacity;
+}
+
+void* ScratchArena::OverflowResource::do_allocate(size_t bytes, size_t alignment) {
+    borrowed += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+void ScratchArena::OverflowResource::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+}
+
+bool ScratchArena::OverflowResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
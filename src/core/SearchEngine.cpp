@@ -1,9 +1,63 @@
 #include "core/SearchEngine.h"
-#include "core/Tokenizer.h"
-#include "core/StopWordRemover.h"
 #include <algorithm>
+#include <unordered_set>
 
-SearchEngine::SearchEngine() {
+namespace {
+
+/**
+ * @brief Collects the leaves of a query that is a plain disjunction of terms.
+ *
+ * @return False if the query uses anything else
+ */
+bool collectBagOfTerms(const QueryNode& node, std::vector<const QueryNode*>& leaves) {
+    if (node.isLeaf()) {
+        if (node.type != QueryNode::Type::Term) {
+            return false;
+        }
+        leaves.push_back(&node);
+        return true;
+    }
+    if (!node.must.empty() || !node.mustNot.empty()) {
+        return false;
+    }
+    for (const auto& child : node.should) {
+        if (!collectBagOfTerms(child, leaves)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Per-thread buffers reused by every query the thread runs.
+ *
+ * Concurrent searches each get their own copy without locking, and a
+ * thread's steady stream of queries stops allocating once the buffers have
+ * grown to the largest collection and query it has seen.
+ */
+struct QueryScratch {
+    ScoreAccumulator accumulator;
+    std::vector<ScoredDocument> topDocuments;
+    std::vector<const QueryNode*> leaves;
+    std::vector<std::string> terms;
+    std::vector<ScoredDocument> similar;
+};
+
+QueryScratch& getQueryScratch() {
+    thread_local QueryScratch scratch;
+    return scratch;
+}
+
+} // namespace
+
+SearchEngine::SearchEngine()
+    : queryEvaluator(indexer.getInvertedIndex()),
+      snippetGenerator(indexer),
+      scorer(indexer),
+      collapsingDuplicates(false),
+      impactOrdering(false),
+      impactIndexStale(true),
+      similarityIndexStale(true) {
     tfidfCalculator = std::make_unique<TFIDFCalculator>(indexer);
 }
 
@@ -12,6 +66,7 @@ bool SearchEngine::indexDocument(const std::string& filePath) {
     // Reset calculator to clear cache when new documents are added
     if (result) {
         tfidfCalculator = std::make_unique<TFIDFCalculator>(indexer);
+        invalidateScores();
     }
     return result;
 }
@@ -21,11 +76,132 @@ int SearchEngine::indexDocuments(const std::vector<std::string>& filePaths) {
     // Reset calculator to clear cache when new documents are added
     if (count > 0) {
         tfidfCalculator = std::make_unique<TFIDFCalculator>(indexer);
+        invalidateScores();
     }
     return count;
 }
 
+void SearchEngine::reorderDocuments(DocumentOrder order) {
+    std::vector<double> staticRanks;
+    if (order == DocumentOrder::StaticRank) {
+        staticRanks = scorer.getStaticRanks();
+    }
+    indexer.reorderDocuments(order, staticRanks);
+    tfidfCalculator = std::make_unique<TFIDFCalculator>(indexer);
+    invalidateScores();
+}
+
 std::vector<SearchResult> SearchEngine::search(const std::string& query, size_t maxResults) const {
+    bool partial = false;
+    return search(query, maxResults, searchBudget, partial);
+}
+
+std::vector<SearchResult> SearchEngine::search(const std::string& query, size_t maxResults,
+                                               const GlobalStatistics& global) const {
+    if (searchBudget.isUnlimited()) {
+        return searchWith(query, maxResults, &global, nullptr);
+    }
+    QueryBudget budget(searchBudget);
+    return searchWith(query, maxResults, &global, &budget);
+}
+
+std::vector<SearchResult> SearchEngine::search(const std::string& query, size_t maxResults,
+                                               const SearchBudget& limits, bool& partial) const {
+    partial = false;
+    if (limits.isUnlimited()) {
+        return searchWith(query, maxResults, nullptr, nullptr);
+    }
+    QueryBudget budget(limits);
+    std::vector<SearchResult> results = searchWith(query, maxResults, nullptr, &budget);
+    partial = budget.stoppedEarly();
+    return results;
+}
+
+std::vector<SearchResult> SearchEngine::findSimilar(uint32_t docId, size_t maxResults) const {
+    std::vector<SearchResult> results;
+    if (docId >= indexer.getDocumentCount()) {
+        return results;
+    }
+    
+    // Collapsing may drop any number of candidates, so it needs all of them
+    std::vector<ScoredDocument>& similar = getQueryScratch().similar;
+    getSimilarityIndex().findSimilar(docId, collapsingDuplicates ? 0 : maxResults, similar);
+    
+    const DuplicateDetector& duplicates = indexer.getDuplicateDetector();
+    uint32_t cluster = duplicates.getCluster(docId);
+    results.reserve(similar.size());
+    for (const auto& scored : similar) {
+        if (!collapsingDuplicates || duplicates.getCluster(scored.docId) != cluster) {
+            results.push_back(SearchResult(scored.docId, static_cast<float>(scored.score)));
+        }
+    }
+    if (collapsingDuplicates) {
+        collapseDuplicates(results);
+        if (maxResults > 0 && results.size() > maxResults) {
+            results.erase(results.begin() + maxResults, results.end());
+        }
+    }
+    return results;
+}
+
+void SearchEngine::setSearchBudget(const SearchBudget& budget) {
+    searchBudget = budget;
+}
+
+SearchBudget SearchEngine::getSearchBudget() const {
+    return searchBudget;
+}
+
+GlobalStatistics SearchEngine::getStatistics(const std::string& query) const {
+    std::vector<std::string> terms;
+    if (!query.empty()) {
+        terms = processQuery(query).getTerms();
+    }
+    return scorer.getStatistics(terms);
+}
+
+std::shared_ptr<Document> SearchEngine::getDocument(uint32_t docId) const {
+    const auto& documents = indexer.getDocuments();
+    if (docId >= documents.size()) {
+        return nullptr;
+    }
+    return documents[docId];
+}
+
+std::string SearchEngine::readDocumentText(uint32_t docId, size_t offset, size_t length) const {
+    std::shared_ptr<Document> document = getDocument(docId);
+    return document ? indexer.readDocumentText(*document, offset, length) : std::string();
+}
+
+bool SearchEngine::isDocumentStored(uint32_t docId) const {
+    return indexer.isDocumentStored(docId);
+}
+
+std::vector<SearchResult> SearchEngine::searchWith(const std::string& query, size_t maxResults,
+                                                   const GlobalStatistics* global, QueryBudget* budget) const {
+    if (!collapsingDuplicates) {
+        return rankDocuments(query, maxResults, global, budget);
+    }
+    
+    // Collapsing folds clusters into one result, so rank more than asked for,
+    // and everything if that still leaves too few. Once the budget is spent a
+    // second pass would score fewer documents than the first, so keep the first.
+    size_t ranked = maxResults > 0 ? maxResults * 4 : 0;
+    std::vector<SearchResult> results = rankDocuments(query, ranked, global, budget);
+    bool complete = ranked == 0 || results.size() < ranked;
+    collapseDuplicates(results);
+    if (!complete && results.size() < maxResults && !(budget && budget->shouldStop())) {
+        results = rankDocuments(query, 0, global, budget);
+        collapseDuplicates(results);
+    }
+    if (maxResults > 0 && results.size() > maxResults) {
+        results.erase(results.begin() + maxResults, results.end());
+    }
+    return results;
+}
+
+std::vector<SearchResult> SearchEngine::rankDocuments(const std::string& query, size_t maxResults,
+                                                      const GlobalStatistics* global, QueryBudget* budget) const {
     std::vector<SearchResult> results;
     
     if (query.empty() || indexer.getDocumentCount() == 0) {
@@ -33,17 +209,55 @@ std::vector<SearchResult> SearchEngine::search(const std::string& query, size_t
     }
     
     // Process query
-    std::vector<std::string> queryTerms = processQuery(query);
-    if (queryTerms.empty()) {
+    Query parsed = processQuery(query);
+    if (parsed.isEmpty()) {
         return results;
     }
     
-    // Calculate scores for each document
-    const auto& documents = indexer.getDocuments();
-    for (const auto& doc : documents) {
-        double score = calculateRelevanceScore(queryTerms, doc);
-        if (score > 0.0) {
-            results.push_back(SearchResult(doc, score));
+    QueryScratch& scratch = getQueryScratch();
+    std::vector<const QueryNode*>& bagOfTerms = scratch.leaves;
+    bagOfTerms.clear();
+    if (collectBagOfTerms(parsed.root, bagOfTerms)) {
+        bool unboosted = std::all_of(bagOfTerms.begin(), bagOfTerms.end(),
+                                     [](const QueryNode* leaf) { return leaf->boost == 1.0; });
+        
+        // Top-K queries can stop early on impact-ordered postings (built from local statistics)
+        if (impactOrdering && maxResults > 0 && unboosted && !global) {
+            std::vector<std::string>& terms = scratch.terms;
+            terms.clear();
+            for (const QueryNode* leaf : bagOfTerms) {
+                terms.push_back(leaf->terms.front());
+            }
+            for (const auto& scored : getImpactIndex().topK(terms, maxResults, budget)) {
+                results.push_back(SearchResult(scored.docId, static_cast<float>(scored.score)));
+            }
+            return results;
+        }
+        
+        // Otherwise every posting counts: score term at a time into the dense accumulator
+        scratch.accumulator.reset(indexer.getDocumentCount());
+        scorer.scoreTerms(bagOfTerms, scratch.accumulator, global, budget);
+        scratch.accumulator.topK(maxResults, scratch.topDocuments);
+        results.reserve(scratch.topDocuments.size());
+        for (const auto& scored : scratch.topDocuments) {
+            results.push_back(SearchResult(scored.docId, static_cast<float>(scored.score)));
+        }
+        return results;
+    }
+    
+    // Boolean matching decides which documents qualify
+    std::vector<uint32_t> matches = queryEvaluator.match(parsed.root);
+    if (matches.empty()) {
+        return results;
+    }
+    
+    // Every scoring leaf a matching document satisfies adds the boosted score of its terms
+    std::vector<double> scores(matches.size(), 0.0);
+    scorer.score(parsed.getScoringLeaves(), queryEvaluator, matches, scores, global, budget);
+    
+    for (size_t i = 0; i < matches.size(); ++i) {
+        if (scores[i] > 0.0) {
+            results.push_back(SearchResult(matches[i], static_cast<float>(scores[i])));
         }
     }
     
@@ -52,12 +266,27 @@ std::vector<SearchResult> SearchEngine::search(const std::string& query, size_t
     
     // Limit results if specified
     if (maxResults > 0 && results.size() > maxResults) {
-        results.resize(maxResults);
+        results.erase(results.begin() + maxResults, results.end());
     }
     
     return results;
 }
 
+void SearchEngine::collapseDuplicates(std::vector<SearchResult>& results) const {
+    const DuplicateDetector& duplicates = indexer.getDuplicateDetector();
+    std::unordered_set<uint32_t> seenClusters;
+    size_t kept = 0;
+    for (const SearchResult& result : results) {
+        // Most documents have no near-duplicates and skip the set
+        if (duplicates.getClusterSize(result.docId) > 1 &&
+            !seenClusters.insert(duplicates.getCluster(result.docId)).second) {
+            continue;
+        }
+        results[kept++] = result;
+    }
+    results.erase(results.begin() + kept, results.end());
+}
+
 size_t SearchEngine::getDocumentCount() const {
     return indexer.getDocumentCount();
 }
@@ -65,6 +294,7 @@ size_t SearchEngine::getDocumentCount() const {
 void SearchEngine::clear() {
     indexer.clear();
     tfidfCalculator = std::make_unique<TFIDFCalculator>(indexer);
+    invalidateScores();
 }
 
 std::vector<std::string> SearchEngine::getIndexedFiles() const {
@@ -76,23 +306,128 @@ std::vector<std::string> SearchEngine::getIndexedFiles() const {
     return files;
 }
 
-std::vector<std::string> SearchEngine::processQuery(const std::string& query) const {
-    Tokenizer tokenizer;
-    StopWordRemover stopWordRemover;
-    
-    std::vector<std::string> tokens = tokenizer.tokenize(query);
-    return stopWordRemover.removeStopWords(tokens);
+std::vector<std::string> SearchEngine::getQueryTerms(const std::string& query) const {
+    return processQuery(query).getTerms();
+}
+
+std::vector<std::string> SearchEngine::getQueryWords(const std::string& query) const {
+    return queryParser.parse(query).words;
 }
 
-double SearchEngine::calculateRelevanceScore(const std::vector<std::string>& queryTerms, 
-                                             const std::shared_ptr<Document>& document) const {
-    double totalScore = 0.0;
+std::vector<std::string> SearchEngine::getSnippets(const std::string& query,
+                                                   const std::vector<SearchResult>& results,
+                                                   size_t offset, size_t count,
+                                                   std::chrono::milliseconds budget) const {
+    size_t end = std::min(results.size(), offset + count);
+    std::vector<std::string> snippets(end > offset ? end - offset : 0);
+    if (snippets.empty()) {
+        return snippets;
+    }
     
-    for (const auto& term : queryTerms) {
-        double tfidf = tfidfCalculator->calculateTFIDF(term, document);
-        totalScore += tfidf;
+    // Distinct query terms, weighted by rarity; common terms still count a little
+    std::vector<std::string> terms = processQuery(query).getTerms();
+    std::sort(terms.begin(), terms.end());
+    terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+    std::vector<double> weights;
+    for (const auto& term : terms) {
+        weights.push_back(std::max(tfidfCalculator->calculateIDF(term), 0.1));
     }
     
-    return totalScore;
+    const auto& documents = indexer.getDocuments();
+    auto deadline = std::chrono::steady_clock::now() + budget;
+    for (size_t i = offset; i < end; ++i) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            break;
+        }
+        if (results[i].docId < documents.size()) {
+            snippets[i - offset] = snippetGenerator.generate(*documents[results[i].docId], terms, weights);
+        }
+    }
+    return snippets;
+}
+
+void SearchEngine::setPositionalIndexing(bool enabled) {
+    indexer.setPositionalIndexing(enabled);
+}
+
+void SearchEngine::setStemming(bool enabled) {
+    indexer.setStemming(enabled);
+    queryParser.setStemmer(indexer.getStemmer());
+}
+
+bool SearchEngine::setDocumentStore(const std::string& path) {
+    return indexer.setDocumentStore(path);
 }
 
+void SearchEngine::setCollapseDuplicates(bool enabled) {
+    collapsingDuplicates = enabled;
+}
+
+void SearchEngine::setDuplicateThreshold(double similarity) {
+    indexer.setDuplicateThreshold(similarity);
+}
+
+void SearchEngine::setIndexingDuplicates(bool enabled) {
+    indexer.setIndexingDuplicates(enabled);
+}
+
+size_t SearchEngine::getDuplicateCount(uint32_t docId) const {
+    return indexer.getDuplicateDetector().getClusterSize(docId) - 1;
+}
+
+void SearchEngine::setIngestionThreads(size_t threads) {
+    indexer.setIngestionThreads(threads);
+}
+
+void SearchEngine::setMaxTermExpansions(size_t limit) {
+    queryEvaluator.setMaxExpansions(limit);
+}
+
+void SearchEngine::setScoringModel(ScoringModel model) {
+    if (model != scorer.getModel()) {
+        scorer.setModel(model);
+        invalidateScores();
+    }
+}
+
+ScoringModel SearchEngine::getScoringModel() const {
+    return scorer.getModel();
+}
+
+void SearchEngine::setImpactOrdering(bool enabled) {
+    impactOrdering = enabled;
+}
+
+Query SearchEngine::processQuery(const std::string& query) const {
+    Query parsed = queryParser.parse(query);
+    queryEvaluator.rewrite(parsed.root);
+    return parsed;
+}
+
+const ImpactIndex& SearchEngine::getImpactIndex() const {
+    std::lock_guard<std::mutex> lock(impactIndexMutex);
+    if (impactIndexStale) {
+        impactIndex.build(indexer.getInvertedIndex(), scorer);
+        impactIndexStale = false;
+    }
+    return impactIndex;
+}
+
+const SimilarityIndex& SearchEngine::getSimilarityIndex() const {
+    std::lock_guard<std::mutex> lock(similarityIndexMutex);
+    if (similarityIndexStale) {
+        similarityIndex.build(indexer.getDocuments());
+        similarityIndexStale = false;
+    }
+    return similarityIndex;
+}
+
+void SearchEngine::invalidateScores() {
+    scorer.invalidate();
+    {
+        std::lock_guard<std::mutex> lock(impactIndexMutex);
+        impactIndexStale = true;
+    }
+    std::lock_guard<std::mutex> lock(similarityIndexMutex);
+    similarityIndexStale = true;
+}
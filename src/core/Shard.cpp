@@ -0,0 +1,148 @@
+#include "core/Shard.h"
+#include <filesystem>
+
+LocalShard::LocalShard(const SearchEngine& engine)
+    : engine(engine) {
+}
+
+bool LocalShard::getStatistics(const std::string& query, GlobalStatistics& stats) {
+    stats = engine.getStatistics(query);
+    return true;
+}
+
+bool LocalShard::search(const std::string& query, size_t maxResults, const GlobalStatistics& global,
+                        std::vector<ShardHit>& hits) {
+    hits = ShardServer::toHits(engine.search(query, maxResults, global));
+    return true;
+}
+
+bool LocalShard::getDocuments(const std::vector<uint32_t>& docIds,
+                              std::vector<std::shared_ptr<Document>>& documents) {
+    documents.clear();
+    for (uint32_t docId : docIds) {
+        documents.push_back(engine.getDocument(docId));
+    }
+    return true;
+}
+
+RemoteShard::RemoteShard(int inputFd, int outputFd)
+    : inputFd(inputFd), outputFd(outputFd) {
+}
+
+bool RemoteShard::getStatistics(const std::string& query, GlobalStatistics& stats) {
+    std::string response;
+    return exchange(ShardProtocol::encodeStatisticsRequest(query), response) &&
+           ShardProtocol::decodeStatisticsResponse(response, stats);
+}
+
+bool RemoteShard::search(const std::string& query, size_t maxResults, const GlobalStatistics& global,
+                         std::vector<ShardHit>& hits) {
+    std::string response;
+    return exchange(ShardProtocol::encodeSearchRequest(query, maxResults, global), response) &&
+           ShardProtocol::decodeSearchResponse(response, hits);
+}
+
+bool RemoteShard::getDocuments(const std::vector<uint32_t>& docIds,
+                               std::vector<std::shared_ptr<Document>>& documents) {
+    std::string response;
+    std::vector<std::string> filePaths;
+    if (!exchange(ShardProtocol::encodeDocumentsRequest(docIds), response) ||
+        !ShardProtocol::decodeDocumentsResponse(response, filePaths) || filePaths.size() != docIds.size()) {
+        return false;
+    }
+
+    documents.clear();
+    for (size_t i = 0; i < docIds.size(); ++i) {
+        if (filePaths[i].empty()) {
+            documents.push_back(nullptr);
+            continue;
+        }
+        auto document = std::make_shared<Document>();
+        document->docId = docIds[i];
+        document->filePath = filePaths[i];
+        document->fileName = std::filesystem::path(filePaths[i]).filename().string();
+        documents.push_back(document);
+    }
+    return true;
+}
+
+bool RemoteShard::shutdown() {
+    std::lock_guard<std::mutex> lock(channelMutex);
+    return ShardProtocol::writeFrame(outputFd, ShardProtocol::encodeShutdown());
+}
+
+bool RemoteShard::exchange(const std::string& request, std::string& response) {
+    std::lock_guard<std::mutex> lock(channelMutex);
+    return ShardProtocol::writeFrame(outputFd, request) && ShardProtocol::readFrame(inputFd, response);
+}
+
+ShardServer::ShardServer(const SearchEngine& engine)
+    : engine(engine) {
+}
+
+bool ShardServer::handle(const std::string& request, std::string& response) const {
+    ShardProtocol::MessageType type;
+    if (!ShardProtocol::getMessageType(request, type)) {
+        return false;
+    }
+
+    switch (type) {
+        case ShardProtocol::MessageType::StatisticsRequest: {
+            std::string query;
+            if (!ShardProtocol::decodeStatisticsRequest(request, query)) {
+                return false;
+            }
+            response = ShardProtocol::encodeStatisticsResponse(engine.getStatistics(query));
+            return true;
+        }
+        case ShardProtocol::MessageType::SearchRequest: {
+            std::string query;
+            size_t maxResults = 0;
+            GlobalStatistics global;
+            if (!ShardProtocol::decodeSearchRequest(request, query, maxResults, global)) {
+                return false;
+            }
+            response = ShardProtocol::encodeSearchResponse(toHits(engine.search(query, maxResults, global)));
+            return true;
+        }
+        case ShardProtocol::MessageType::DocumentsRequest: {
+            std::vector<uint32_t> docIds;
+            if (!ShardProtocol::decodeDocumentsRequest(request, docIds)) {
+                return false;
+            }
+            std::vector<std::string> filePaths;
+            for (uint32_t docId : docIds) {
+                std::shared_ptr<Document> document = engine.getDocument(docId);
+                filePaths.push_back(document ? document->filePath : std::string());
+            }
+            response = ShardProtocol::encodeDocumentsResponse(filePaths);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+bool ShardServer::serve(int inputFd, int outputFd) const {
+    std::string request;
+    std::string response;
+    while (ShardProtocol::readFrame(inputFd, request)) {
+        ShardProtocol::MessageType type;
+        if (ShardProtocol::getMessageType(request, type) && type == ShardProtocol::MessageType::Shutdown) {
+            return true;
+        }
+        if (!handle(request, response) || !ShardProtocol::writeFrame(outputFd, response)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<ShardHit> ShardServer::toHits(const std::vector<SearchResult>& results) {
+    std::vector<ShardHit> hits;
+    hits.reserve(results.size());
+    for (const auto& result : results) {
+        hits.push_back({result.docId, result.score});
+    }
+    return hits;
+}
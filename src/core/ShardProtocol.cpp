@@ -0,0 +1,356 @@
+#include "core/ShardProtocol.h"
+#include <cstring>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <unistd.h>
+#endif
+
+namespace {
+
+void writeU8(std::string& out, uint8_t value) {
+    out.push_back(static_cast<char>(value));
+}
+
+void writeU32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+void writeU64(std::string& out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+void writeFloat(std::string& out, float value) {
+    uint32_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    writeU32(out, bits);
+}
+
+void writeString(std::string& out, const std::string& value) {
+    writeU32(out, static_cast<uint32_t>(value.size()));
+    out.append(value);
+}
+
+void writeStatistics(std::string& out, const GlobalStatistics& stats) {
+    writeU64(out, stats.collection.documentCount);
+    writeU64(out, stats.collection.totalTerms);
+    writeU32(out, static_cast<uint32_t>(stats.documentFrequencies.size()));
+    for (const auto& entry : stats.documentFrequencies) {
+        writeString(out, entry.first);
+        writeU64(out, entry.second);
+    }
+}
+
+/**
+ * @brief Bounds-checked reader; every read fails once the input is exhausted.
+ */
+class Reader {
+public:
+    explicit Reader(const std::string& data) : data(data), offset(0) {}
+
+    bool readU8(uint8_t& value) {
+        if (data.size() - offset < 1) {
+            return false;
+        }
+        value = static_cast<uint8_t>(data[offset++]);
+        return true;
+    }
+
+    bool readU32(uint32_t& value) {
+        if (data.size() - offset < 4) {
+            return false;
+        }
+        value = 0;
+        for (int i = 0; i < 4; ++i) {
+            value |= static_cast<uint32_t>(static_cast<uint8_t>(data[offset++])) << (8 * i);
+        }
+        return true;
+    }
+
+    bool readU64(uint64_t& value) {
+        if (data.size() - offset < 8) {
+            return false;
+        }
+        value = 0;
+        for (int i = 0; i < 8; ++i) {
+            value |= static_cast<uint64_t>(static_cast<uint8_t>(data[offset++])) << (8 * i);
+        }
+        return true;
+    }
+
+    bool readFloat(float& value) {
+        uint32_t bits = 0;
+        if (!readU32(bits)) {
+            return false;
+        }
+        std::memcpy(&value, &bits, sizeof(value));
+        return true;
+    }
+
+    bool readString(std::string& value) {
+        uint32_t length = 0;
+        if (!readU32(length) || data.size() - offset < length) {
+            return false;
+        }
+        value.assign(data, offset, length);
+        offset += length;
+        return true;
+    }
+
+    bool readStatistics(GlobalStatistics& stats) {
+        uint32_t count = 0;
+        if (!readU64(stats.collection.documentCount) || !readU64(stats.collection.totalTerms) ||
+            !readU32(count)) {
+            return false;
+        }
+        stats.documentFrequencies.clear();
+        for (uint32_t i = 0; i < count; ++i) {
+            std::string term;
+            uint64_t frequency = 0;
+            if (!readString(term) || !readU64(frequency)) {
+                return false;
+            }
+            stats.documentFrequencies[term] = frequency;
+        }
+        return true;
+    }
+
+    bool expect(ShardProtocol::MessageType type) {
+        uint8_t value = 0;
+        return readU8(value) && value == static_cast<uint8_t>(type);
+    }
+
+    bool atEnd() const {
+        return offset == data.size();
+    }
+
+private:
+    const std::string& data;
+    size_t offset;
+};
+
+} // namespace
+
+std::string ShardProtocol::encodeStatisticsRequest(const std::string& query) {
+    std::string out;
+    writeU8(out, static_cast<uint8_t>(MessageType::StatisticsRequest));
+    writeString(out, query);
+    return out;
+}
+
+std::string ShardProtocol::encodeStatisticsResponse(const GlobalStatistics& stats) {
+    std::string out;
+    writeU8(out, static_cast<uint8_t>(MessageType::StatisticsResponse));
+    writeStatistics(out, stats);
+    return out;
+}
+
+std::string ShardProtocol::encodeSearchRequest(const std::string& query, size_t maxResults,
+                                               const GlobalStatistics& global) {
+    std::string out;
+    writeU8(out, static_cast<uint8_t>(MessageType::SearchRequest));
+    writeString(out, query);
+    writeU64(out, maxResults);
+    writeStatistics(out, global);
+    return out;
+}
+
+std::string ShardProtocol::encodeSearchResponse(const std::vector<ShardHit>& hits) {
+    std::string out;
+    writeU8(out, static_cast<uint8_t>(MessageType::SearchResponse));
+    writeU32(out, static_cast<uint32_t>(hits.size()));
+    for (const auto& hit : hits) {
+        writeU32(out, hit.docId);
+        writeFloat(out, hit.score);
+    }
+    return out;
+}
+
+std::string ShardProtocol::encodeDocumentsRequest(const std::vector<uint32_t>& docIds) {
+    std::string out;
+    writeU8(out, static_cast<uint8_t>(MessageType::DocumentsRequest));
+    writeU32(out, static_cast<uint32_t>(docIds.size()));
+    for (uint32_t docId : docIds) {
+        writeU32(out, docId);
+    }
+    return out;
+}
+
+std::string ShardProtocol::encodeDocumentsResponse(const std::vector<std::string>& filePaths) {
+    std::string out;
+    writeU8(out, static_cast<uint8_t>(MessageType::DocumentsResponse));
+    writeU32(out, static_cast<uint32_t>(filePaths.size()));
+    for (const auto& filePath : filePaths) {
+        writeString(out, filePath);
+    }
+    return out;
+}
+
+std::string ShardProtocol::encodeShutdown() {
+    std::string out;
+    writeU8(out, static_cast<uint8_t>(MessageType::Shutdown));
+    return out;
+}
+
+bool ShardProtocol::getMessageType(const std::string& message, MessageType& type) {
+    if (message.empty()) {
+        return false;
+    }
+    uint8_t value = static_cast<uint8_t>(message[0]);
+    if (value < static_cast<uint8_t>(MessageType::StatisticsRequest) ||
+        value > static_cast<uint8_t>(MessageType::DocumentsResponse)) {
+        return false;
+    }
+    type = static_cast<MessageType>(value);
+    return true;
+}
+
+bool ShardProtocol::decodeStatisticsRequest(const std::string& message, std::string& query) {
+    Reader reader(message);
+    return reader.expect(MessageType::StatisticsRequest) && reader.readString(query) && reader.atEnd();
+}
+
+bool ShardProtocol::decodeStatisticsResponse(const std::string& message, GlobalStatistics& stats) {
+    Reader reader(message);
+    return reader.expect(MessageType::StatisticsResponse) && reader.readStatistics(stats) && reader.atEnd();
+}
+
+bool ShardProtocol::decodeSearchRequest(const std::string& message, std::string& query, size_t& maxResults,
+                                        GlobalStatistics& global) {
+    Reader reader(message);
+    uint64_t limit = 0;
+    if (!reader.expect(MessageType::SearchRequest) || !reader.readString(query) || !reader.readU64(limit) ||
+        !reader.readStatistics(global) || !reader.atEnd()) {
+        return false;
+    }
+    maxResults = static_cast<size_t>(limit);
+    return true;
+}
+
+bool ShardProtocol::decodeSearchResponse(const std::string& message, std::vector<ShardHit>& hits) {
+    Reader reader(message);
+    uint32_t count = 0;
+    if (!reader.expect(MessageType::SearchResponse) || !reader.readU32(count)) {
+        return false;
+    }
+    hits.clear();
+    for (uint32_t i = 0; i < count; ++i) {
+        ShardHit hit;
+        if (!reader.readU32(hit.docId) || !reader.readFloat(hit.score)) {
+            return false;
+        }
+        hits.push_back(hit);
+    }
+    return reader.atEnd();
+}
+
+bool ShardProtocol::decodeDocumentsRequest(const std::string& message, std::vector<uint32_t>& docIds) {
+    Reader reader(message);
+    uint32_t count = 0;
+    if (!reader.expect(MessageType::DocumentsRequest) || !reader.readU32(count)) {
+        return false;
+    }
+    docIds.clear();
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t docId = 0;
+        if (!reader.readU32(docId)) {
+            return false;
+        }
+        docIds.push_back(docId);
+    }
+    return reader.atEnd();
+}
+
+bool ShardProtocol::decodeDocumentsResponse(const std::string& message, std::vector<std::string>& filePaths) {
+    Reader reader(message);
+    uint32_t count = 0;
+    if (!reader.expect(MessageType::DocumentsResponse) || !reader.readU32(count)) {
+        return false;
+    }
+    filePaths.clear();
+    for (uint32_t i = 0; i < count; ++i) {
+        std::string filePath;
+        if (!reader.readString(filePath)) {
+            return false;
+        }
+        filePaths.push_back(std::move(filePath));
+    }
+    return reader.atEnd();
+}
+
+#ifndef _WIN32
+
+namespace {
+
+bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool readAll(int fd, char* data, size_t size) {
+    while (size > 0) {
+        ssize_t received = ::read(fd, data, size);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        data += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+} // namespace
+
+bool ShardProtocol::writeFrame(int fd, const std::string& message) {
+    if (message.size() > MaxFrameSize) {
+        return false;
+    }
+    std::string header;
+    writeU32(header, static_cast<uint32_t>(message.size()));
+    return writeAll(fd, header.data(), header.size()) && writeAll(fd, message.data(), message.size());
+}
+
+bool ShardProtocol::readFrame(int fd, std::string& message) {
+    char header[4];
+    if (!readAll(fd, header, sizeof(header))) {
+        return false;
+    }
+    uint32_t length = 0;
+    for (int i = 0; i < 4; ++i) {
+        length |= static_cast<uint32_t>(static_cast<uint8_t>(header[i])) << (8 * i);
+    }
+    if (length > MaxFrameSize) {
+        return false;
+    }
+    message.resize(length);
+    return length == 0 || readAll(fd, &message[0], length);
+}
+
+#else
+
+bool ShardProtocol::writeFrame(int, const std::string&) {
+    return false;
+}
+
+bool ShardProtocol::readFrame(int, std::string&) {
+    return false;
+}
+
+#endif
@@ -0,0 +1,322 @@
+#include "core/ShardedSearchEngine.h"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+/**
+ * @brief A thread that runs one shard's requests in submission order.
+ */
+class ShardedSearchEngine::Worker {
+public:
+    Worker() : stopping(false), thread([this]() { run(); }) {
+    }
+
+    ~Worker() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        thread.join();
+    }
+
+    /**
+     * @brief Queues a task.
+     *
+     * @return Future that becomes ready when the task has run, or rethrows what it threw
+     */
+    std::future<void> submit(std::function<void()> task) {
+        std::packaged_task<void()> packaged(std::move(task));
+        std::future<void> done = packaged.get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(std::move(packaged));
+        }
+        wake.notify_one();
+        return done;
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::packaged_task<void()>> tasks;
+    bool stopping;
+    std::thread thread; // last, so it starts after the members it uses
+
+    void run() {
+        while (true) {
+            std::packaged_task<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this]() { return stopping || !tasks.empty(); });
+                if (tasks.empty()) {
+                    return;
+                }
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+};
+
+namespace {
+
+/**
+ * @brief Waits for every task, then rethrows the first failure.
+ *
+ * The tasks point into the caller's frame, so none may still be running
+ * when an exception leaves it.
+ */
+void waitAll(std::vector<std::future<void>>& pending) {
+    for (auto& done : pending) {
+        done.wait();
+    }
+    for (auto& done : pending) {
+        done.get();
+    }
+}
+
+} // namespace
+
+ShardedSearchEngine::ShardedSearchEngine(size_t shardCount) {
+    shardCount = std::max<size_t>(shardCount, 1);
+    // Shards index in parallel, so they share the processors between them
+    size_t threads = std::max<size_t>(std::thread::hardware_concurrency() / shardCount, 1);
+    for (size_t i = 0; i < shardCount; ++i) {
+        engines.push_back(std::make_unique<SearchEngine>());
+        engines.back()->setIngestionThreads(threads);
+        shards.push_back(std::make_unique<LocalShard>(*engines.back()));
+        workers.push_back(std::make_unique<Worker>());
+    }
+}
+
+ShardedSearchEngine::~ShardedSearchEngine() {
+    // Join the workers before the shards they run requests on go away
+    workers.clear();
+}
+
+bool ShardedSearchEngine::indexDocument(const std::string& filePath) {
+    return engines[routeDocument(filePath, engines.size())]->indexDocument(filePath);
+}
+
+int ShardedSearchEngine::indexDocuments(const std::vector<std::string>& filePaths) {
+    std::vector<std::vector<std::string>> routed(engines.size());
+    for (const auto& filePath : filePaths) {
+        routed[routeDocument(filePath, engines.size())].push_back(filePath);
+    }
+
+    // Shards share nothing, so each one indexes its files on its own worker
+    std::vector<int> indexed(engines.size(), 0);
+    std::vector<std::future<void>> pending;
+    for (size_t i = 0; i < engines.size(); ++i) {
+        if (routed[i].empty()) {
+            continue;
+        }
+        SearchEngine* engine = engines[i].get();
+        const std::vector<std::string>* files = &routed[i];
+        int* count = &indexed[i];
+        pending.push_back(workers[i]->submit([engine, files, count]() {
+            *count = engine->indexDocuments(*files);
+        }));
+    }
+
+    waitAll(pending);
+    int count = 0;
+    for (int shardCount : indexed) {
+        count += shardCount;
+    }
+    return count;
+}
+
+void ShardedSearchEngine::reorderDocuments(DocumentOrder order) {
+    std::vector<std::future<void>> pending;
+    for (size_t i = 0; i < engines.size(); ++i) {
+        SearchEngine* shard = engines[i].get();
+        pending.push_back(workers[i]->submit([shard, order]() {
+            shard->reorderDocuments(order);
+        }));
+    }
+    waitAll(pending);
+}
+
+void ShardedSearchEngine::addShard(std::unique_ptr<Shard> shard) {
+    shards.push_back(std::move(shard));
+    workers.push_back(std::make_unique<Worker>());
+}
+
+std::vector<ShardedSearchResult> ShardedSearchEngine::search(const std::string& query, size_t maxResults) const {
+    std::vector<ShardedSearchResult> results;
+    if (query.empty()) {
+        return results;
+    }
+
+    // Scatter 1: every shard's share of the statistics, summed into the global view.
+    // Each task writes its own slots; std::vector<bool> would pack them into shared words
+    std::vector<GlobalStatistics> shardStats(shards.size());
+    std::vector<char> reachable(shards.size(), 0);
+    std::vector<std::future<void>> gathered;
+    for (size_t i = 0; i < shards.size(); ++i) {
+        Shard* shard = shards[i].get();
+        GlobalStatistics* stats = &shardStats[i];
+        char* reached = &reachable[i];
+        gathered.push_back(workers[i]->submit([shard, stats, reached, &query]() {
+            *reached = shard->getStatistics(query, *stats);
+        }));
+    }
+
+    waitAll(gathered);
+    GlobalStatistics global;
+    for (size_t i = 0; i < shards.size(); ++i) {
+        if (reachable[i]) {
+            global.merge(shardStats[i]);
+        }
+    }
+    if (global.collection.documentCount == 0) {
+        return results;
+    }
+
+    // Scatter 2: every shard ranks its documents on the global scale
+    std::vector<std::vector<ShardHit>> shardHits(shards.size());
+    std::vector<std::future<void>> searched;
+    for (size_t i = 0; i < shards.size(); ++i) {
+        if (!reachable[i]) {
+            continue;
+        }
+        Shard* shard = shards[i].get();
+        std::vector<ShardHit>* hits = &shardHits[i];
+        searched.push_back(workers[i]->submit([shard, hits, &query, maxResults, &global]() {
+            if (!shard->search(query, maxResults, global, *hits)) {
+                hits->clear();
+            }
+        }));
+    }
+    waitAll(searched);
+
+    // Gather: k-way merge of the per-shard lists, each already sorted by score
+    struct Head {
+        float score;
+        size_t shard;
+        size_t index;
+    };
+    auto worse = [&shardHits](const Head& a, const Head& b) {
+        if (a.score != b.score) {
+            return a.score < b.score;
+        }
+        if (a.shard != b.shard) {
+            return a.shard > b.shard;
+        }
+        return shardHits[a.shard][a.index].docId > shardHits[b.shard][b.index].docId;
+    };
+    std::priority_queue<Head, std::vector<Head>, decltype(worse)> heap(worse);
+    for (size_t i = 0; i < shardHits.size(); ++i) {
+        if (!shardHits[i].empty()) {
+            heap.push({shardHits[i][0].score, i, 0});
+        }
+    }
+
+    while (!heap.empty() && (maxResults == 0 || results.size() < maxResults)) {
+        Head head = heap.top();
+        heap.pop();
+        const ShardHit& hit = shardHits[head.shard][head.index];
+        results.push_back({static_cast<uint32_t>(head.shard), hit.docId, hit.score});
+        if (head.index + 1 < shardHits[head.shard].size()) {
+            heap.push({shardHits[head.shard][head.index + 1].score, head.shard, head.index + 1});
+        }
+    }
+    return results;
+}
+
+std::vector<std::shared_ptr<Document>> ShardedSearchEngine::getDocuments(
+    const std::vector<ShardedSearchResult>& results, size_t offset, size_t count) const {
+    size_t end = std::min(results.size(), offset + count);
+    std::vector<std::shared_ptr<Document>> documents(end > offset ? end - offset : 0);
+
+    // One request per shard, answers scattered back into result order
+    std::vector<std::vector<uint32_t>> docIds(shards.size());
+    std::vector<std::vector<size_t>> slots(shards.size());
+    for (size_t i = offset; i < end; ++i) {
+        if (results[i].shard < shards.size()) {
+            docIds[results[i].shard].push_back(results[i].docId);
+            slots[results[i].shard].push_back(i - offset);
+        }
+    }
+
+    std::vector<std::shared_ptr<Document>> resolved;
+    for (size_t shard = 0; shard < shards.size(); ++shard) {
+        if (docIds[shard].empty() || !shards[shard]->getDocuments(docIds[shard], resolved)) {
+            continue;
+        }
+        for (size_t j = 0; j < slots[shard].size() && j < resolved.size(); ++j) {
+            documents[slots[shard][j]] = resolved[j];
+        }
+    }
+    return documents;
+}
+
+size_t ShardedSearchEngine::getDocumentCount() const {
+    size_t count = 0;
+    for (const auto& shard : shards) {
+        GlobalStatistics stats;
+        if (shard->getStatistics("", stats)) {
+            count += static_cast<size_t>(stats.collection.documentCount);
+        }
+    }
+    return count;
+}
+
+size_t ShardedSearchEngine::getShardCount() const {
+    return shards.size();
+}
+
+SearchEngine& ShardedSearchEngine::getLocalShard(size_t index) {
+    return *engines[index];
+}
+
+size_t ShardedSearchEngine::getLocalShardCount() const {
+    return engines.size();
+}
+
+void ShardedSearchEngine::setScoringModel(ScoringModel model) {
+    for (auto& engine : engines) {
+        engine->setScoringModel(model);
+    }
+}
+
+void ShardedSearchEngine::setStemming(bool enabled) {
+    for (auto& engine : engines) {
+        engine->setStemming(enabled);
+    }
+}
+
+void ShardedSearchEngine::setCollapseDuplicates(bool enabled) {
+    for (auto& engine : engines) {
+        engine->setCollapseDuplicates(enabled);
+    }
+}
+
+void ShardedSearchEngine::setSearchBudget(const SearchBudget& budget) {
+    for (auto& engine : engines) {
+        engine->setSearchBudget(budget);
+    }
+}
+
+void ShardedSearchEngine::clear() {
+    for (auto& engine : engines) {
+        engine->clear();
+    }
+}
+
+size_t ShardedSearchEngine::routeDocument(const std::string& filePath, size_t shardCount) {
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : filePath) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ull;
+    }
+    return static_cast<size_t>(hash % shardCount);
+}
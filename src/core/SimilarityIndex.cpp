@@ -0,0 +1,237 @@
+#include "core/SimilarityIndex.h"
+#include "core/TFIDFCalculator.h"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SIMILARITYINDEX_SSE2 1
+#endif
+
+namespace {
+
+/**
+ * @brief A term of the vector being built.
+ */
+struct WeightedTerm {
+    float weight;
+    uint32_t termId;
+};
+
+bool byWeight(const WeightedTerm& a, const WeightedTerm& b) {
+    return a.weight != b.weight ? a.weight > b.weight : a.termId < b.termId;
+}
+
+bool byScore(const ScoredDocument& a, const ScoredDocument& b) {
+    return a.score != b.score ? a.score > b.score : a.docId < b.docId;
+}
+
+/**
+ * @brief Per-thread buffers reused by every findSimilar() call on the thread.
+ */
+struct SimilarScratch {
+    std::vector<WeightedTerm> probes;
+    std::vector<uint32_t> candidates;
+};
+
+SimilarScratch& getSimilarScratch() {
+    thread_local SimilarScratch scratch;
+    return scratch;
+}
+
+} // namespace
+
+SimilarityIndex::SimilarityIndex() {
+}
+
+void SimilarityIndex::build(const std::vector<std::shared_ptr<Document>>& documents) {
+    clear();
+
+    // Term ids and document frequencies in one pass over the term counts
+    std::unordered_map<std::string, uint32_t> termIdMap;
+    std::vector<uint32_t> documentFrequencies;
+    for (const auto& document : documents) {
+        for (const auto& entry : document->termFrequency) {
+            auto inserted = termIdMap.emplace(entry.first, static_cast<uint32_t>(documentFrequencies.size()));
+            if (inserted.second) {
+                documentFrequencies.push_back(0);
+            }
+            documentFrequencies[inserted.first->second]++;
+        }
+    }
+
+    std::vector<double> idf(documentFrequencies.size());
+    for (size_t termId = 0; termId < idf.size(); ++termId) {
+        idf[termId] = TFIDFCalculator::calculateIDF(documentFrequencies[termId], documents.size());
+    }
+
+    vectorStarts.reserve(documents.size() + 1);
+    vectorStarts.push_back(0);
+    std::vector<WeightedTerm> vector;
+    for (const auto& document : documents) {
+        vector.clear();
+        double norm = 0.0;
+        for (const auto& entry : document->termFrequency) {
+            uint32_t termId = termIdMap.find(entry.first)->second;
+            double weight = TFIDFCalculator::calculateTF(entry.second, document->totalTerms) * idf[termId];
+            if (weight > 0.0) {
+                norm += weight * weight;
+                vector.push_back({static_cast<float>(weight), termId});
+            }
+        }
+
+        // The norm covers every term, so pruned vectors keep their true scale
+        if (vector.size() > MaxVectorTerms) {
+            std::nth_element(vector.begin(), vector.begin() + (MaxVectorTerms - 1), vector.end(), byWeight);
+            vector.resize(MaxVectorTerms);
+        }
+        std::sort(vector.begin(), vector.end(), [](const WeightedTerm& a, const WeightedTerm& b) {
+            return a.termId < b.termId;
+        });
+        float scale = norm > 0.0 ? static_cast<float>(1.0 / std::sqrt(norm)) : 0.0f;
+        for (const WeightedTerm& term : vector) {
+            termIds.push_back(term.termId);
+            weights.push_back(term.weight * scale);
+        }
+        vectorStarts.push_back(static_cast<uint32_t>(termIds.size()));
+    }
+
+    // Candidate lists: count, then fill in docId order so each list is ascending
+    listStarts.assign(documentFrequencies.size() + 1, 0);
+    for (uint32_t termId : termIds) {
+        listStarts[termId + 1]++;
+    }
+    for (size_t termId = 0; termId < documentFrequencies.size(); ++termId) {
+        listStarts[termId + 1] += listStarts[termId];
+    }
+    listDocIds.resize(termIds.size());
+    std::vector<uint32_t> fill(listStarts.begin(), listStarts.end() - 1);
+    for (uint32_t docId = 0; docId + 1 < vectorStarts.size(); ++docId) {
+        for (uint32_t entry = vectorStarts[docId]; entry < vectorStarts[docId + 1]; ++entry) {
+            listDocIds[fill[termIds[entry]]++] = docId;
+        }
+    }
+}
+
+void SimilarityIndex::findSimilar(uint32_t docId, size_t k, std::vector<ScoredDocument>& results) const {
+    results.clear();
+    if (static_cast<size_t>(docId) + 1 >= vectorStarts.size() || vectorStarts[docId] == vectorStarts[docId + 1]) {
+        return;
+    }
+
+    const uint32_t* queryIds = termIds.data() + vectorStarts[docId];
+    const float* queryWeights = weights.data() + vectorStarts[docId];
+    size_t querySize = vectorStarts[docId + 1] - vectorStarts[docId];
+
+    // Probe the lists of the heaviest terms only
+    SimilarScratch& scratch = getSimilarScratch();
+    scratch.probes.clear();
+    for (size_t i = 0; i < querySize; ++i) {
+        scratch.probes.push_back({queryWeights[i], queryIds[i]});
+    }
+    size_t probeCount = std::min(querySize, ProbeTerms);
+    std::partial_sort(scratch.probes.begin(), scratch.probes.begin() + probeCount, scratch.probes.end(), byWeight);
+
+    scratch.candidates.clear();
+    for (size_t i = 0; i < probeCount; ++i) {
+        uint32_t termId = scratch.probes[i].termId;
+        scratch.candidates.insert(scratch.candidates.end(), listDocIds.begin() + listStarts[termId],
+                                  listDocIds.begin() + listStarts[termId + 1]);
+    }
+    std::sort(scratch.candidates.begin(), scratch.candidates.end());
+    scratch.candidates.erase(std::unique(scratch.candidates.begin(), scratch.candidates.end()),
+                             scratch.candidates.end());
+
+    for (uint32_t candidate : scratch.candidates) {
+        if (candidate == docId) {
+            continue;
+        }
+        uint32_t begin = vectorStarts[candidate];
+        float similarity = dotProduct(queryIds, queryWeights, querySize, termIds.data() + begin,
+                                      weights.data() + begin, vectorStarts[candidate + 1] - begin);
+        if (similarity > 0.0f) {
+            results.push_back({candidate, similarity});
+        }
+    }
+
+    if (k > 0 && results.size() > k) {
+        std::nth_element(results.begin(), results.begin() + (k - 1), results.end(), byScore);
+        results.resize(k);
+    }
+    std::sort(results.begin(), results.end(), byScore);
+}
+
+double SimilarityIndex::getSimilarity(uint32_t first, uint32_t second) const {
+    if (static_cast<size_t>(std::max(first, second)) + 1 >= vectorStarts.size()) {
+        return 0.0;
+    }
+    uint32_t firstBegin = vectorStarts[first];
+    uint32_t secondBegin = vectorStarts[second];
+    return dotProduct(termIds.data() + firstBegin, weights.data() + firstBegin, vectorStarts[first + 1] - firstBegin,
+                      termIds.data() + secondBegin, weights.data() + secondBegin,
+                      vectorStarts[second + 1] - secondBegin);
+}
+
+size_t SimilarityIndex::getMemoryUsage() const {
+    return (vectorStarts.capacity() + termIds.capacity() + listStarts.capacity() + listDocIds.capacity()) *
+               sizeof(uint32_t) +
+           weights.capacity() * sizeof(float);
+}
+
+void SimilarityIndex::clear() {
+    vectorStarts.clear();
+    termIds.clear();
+    weights.clear();
+    listStarts.clear();
+    listDocIds.clear();
+}
+
+float SimilarityIndex::dotProduct(const uint32_t* firstIds, const float* firstWeights, size_t firstSize,
+                                  const uint32_t* secondIds, const float* secondWeights, size_t secondSize) {
+    size_t i = 0;
+    size_t j = 0;
+    float sum = 0.0f;
+
+#ifdef SIMILARITYINDEX_SSE2
+    // Compare four ids of each vector against each other by rotating the
+    // second block; a lane whose ids match adds its weight product
+    __m128 sums = _mm_setzero_ps();
+    while (i + 4 <= firstSize && j + 4 <= secondSize) {
+        __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(firstIds + i));
+        __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(secondIds + j));
+        __m128 firstValues = _mm_loadu_ps(firstWeights + i);
+        __m128 secondValues = _mm_loadu_ps(secondWeights + j);
+        for (int rotation = 0; rotation < 4; ++rotation) {
+            __m128 match = _mm_castsi128_ps(_mm_cmpeq_epi32(first, second));
+            sums = _mm_add_ps(sums, _mm_and_ps(match, _mm_mul_ps(firstValues, secondValues)));
+            second = _mm_shuffle_epi32(second, _MM_SHUFFLE(0, 3, 2, 1));
+            secondValues = _mm_shuffle_ps(secondValues, secondValues, _MM_SHUFFLE(0, 3, 2, 1));
+        }
+
+        // Ids ascend, so the block ending lower has no matches left
+        uint32_t firstLast = firstIds[i + 3];
+        uint32_t secondLast = secondIds[j + 3];
+        if (firstLast <= secondLast) {
+            i += 4;
+        }
+        if (secondLast <= firstLast) {
+            j += 4;
+        }
+    }
+    sums = _mm_add_ps(sums, _mm_movehl_ps(sums, sums));
+    sums = _mm_add_ss(sums, _mm_shuffle_ps(sums, sums, _MM_SHUFFLE(1, 1, 1, 1)));
+    sum = _mm_cvtss_f32(sums);
+#endif
+
+    while (i < firstSize && j < secondSize) {
+        if (firstIds[i] < secondIds[j]) {
+            i++;
+        } else if (secondIds[j] < firstIds[i]) {
+            j++;
+        } else {
+            sum += firstWeights[i++] * secondWeights[j++];
+        }
+    }
+    return sum;
+}
@@ -0,0 +1,121 @@
+#include "core/SnippetGenerator.h"
+#include <algorithm>
+#include <cctype>
+
+namespace {
+
+struct TermHit {
+    uint32_t position;
+    uint32_t term;
+
+    bool operator<(const TermHit& other) const {
+        return position < other.position;
+    }
+};
+
+} // namespace
+
+SnippetGenerator::SnippetGenerator(const DocumentIndexer& indexer)
+    : indexer(indexer), windowSize(24) {
+}
+
+void SnippetGenerator::setWindowSize(size_t tokens) {
+    windowSize = std::max<size_t>(tokens, 1);
+}
+
+std::string SnippetGenerator::generate(const Document& document,
+                                       const std::vector<std::string>& terms,
+                                       const std::vector<double>& weights) const {
+    const std::vector<TokenSpan>& spans = document.tokenSpans;
+    if (spans.empty()) {
+        return "";
+    }
+
+    // Gather every occurrence of every query term from the positional postings
+    const InvertedIndex& index = indexer.getInvertedIndex();
+    std::vector<TermHit> hits;
+    for (size_t t = 0; t < terms.size(); ++t) {
+        const PostingList* list = index.getPostings(terms[t]);
+        if (!list) {
+            continue;
+        }
+        auto it = std::lower_bound(list->docIds.begin(), list->docIds.end(), document.docId);
+        if (it == list->docIds.end() || *it != document.docId) {
+            continue;
+        }
+        size_t posting = it - list->docIds.begin();
+        for (const uint32_t* p = list->positionsBegin(posting); p != list->positionsEnd(posting); ++p) {
+            hits.push_back({*p, static_cast<uint32_t>(t)});
+        }
+    }
+    if (hits.empty()) {
+        return "";
+    }
+    std::sort(hits.begin(), hits.end());
+
+    // Slide a window of windowSize positions across the hits
+    std::vector<int> counts(terms.size(), 0);
+    double distinctWeight = 0.0;
+    double bestScore = -1.0;
+    size_t bestFirst = 0;
+    size_t bestLast = 0;
+    size_t right = 0;
+    for (size_t left = 0; left < hits.size(); ++left) {
+        while (right < hits.size() && hits[right].position < hits[left].position + windowSize) {
+            if (counts[hits[right].term]++ == 0) {
+                distinctWeight += weights[hits[right].term];
+            }
+            right++;
+        }
+
+        double score = distinctWeight + 0.01 * static_cast<double>(right - left);
+        if (score > bestScore) {
+            bestScore = score;
+            bestFirst = hits[left].position;
+            bestLast = hits[right - 1].position;
+        }
+
+        if (--counts[hits[left].term] == 0) {
+            distinctWeight -= weights[hits[left].term];
+        }
+    }
+
+    // Centre the hits in the window, leaving some leading context
+    size_t covered = bestLast - bestFirst + 1;
+    size_t slack = windowSize > covered ? windowSize - covered : 0;
+    size_t start = bestFirst - std::min<size_t>(bestFirst, slack / 2);
+    size_t end = std::min(start + windowSize, spans.size());
+    if (start >= end) {
+        return "";
+    }
+
+    size_t byteBegin = spans[start].begin;
+    size_t byteEnd = spans[end - 1].end;
+    std::string raw = indexer.readDocumentText(document, byteBegin, byteEnd - byteBegin);
+    if (raw.empty()) {
+        return "";
+    }
+
+    // Collapse line breaks and runs of whitespace into single spaces
+    std::string snippet;
+    snippet.reserve(raw.size() + 6);
+    if (start > 0) {
+        snippet += "...";
+    }
+    bool pendingSpace = false;
+    for (char c : raw) {
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            pendingSpace = true;
+            continue;
+        }
+        if (pendingSpace) {
+            snippet += ' ';
+            pendingSpace = false;
+        }
+        snippet += c;
+    }
+    if (end < spans.size()) {
+        snippet += "...";
+    }
+    return snippet;
+}
@@ -0,0 +1,375 @@
+#include "core/Stemmer.h"
+#include <algorithm>
+#include <functional>
+#include <mutex>
+
+namespace {
+
+/**
+ * @brief A word being stemmed, following Porter's reference implementation.
+ *
+ * The word is b[0..k]; suffix tests set j so that b[0..j] is the part that
+ * precedes the suffix.
+ */
+class PorterWord {
+public:
+    explicit PorterWord(std::string_view word)
+        : b(word), k(static_cast<int>(word.size()) - 1), j(0) {}
+
+    std::string stem() {
+        // Words of one or two letters are left alone
+        if (k <= 1) {
+            return b;
+        }
+        step1ab();
+        if (k > 0) {
+            step1c();
+            step2();
+            step3();
+            step4();
+            step5();
+        }
+        return b.substr(0, static_cast<size_t>(k + 1));
+    }
+
+private:
+    std::string b;
+    int k;
+    int j;
+
+    bool isConsonant(int i) const {
+        switch (b[i]) {
+            case 'a': case 'e': case 'i': case 'o': case 'u':
+                return false;
+            case 'y':
+                return i == 0 ? true : !isConsonant(i - 1);
+            default:
+                return true;
+        }
+    }
+
+    // Number of vowel-consonant sequences in b[0..j]
+    int measure() const {
+        int n = 0;
+        int i = 0;
+        while (true) {
+            if (i > j) {
+                return n;
+            }
+            if (!isConsonant(i)) {
+                break;
+            }
+            i++;
+        }
+        i++;
+        while (true) {
+            while (true) {
+                if (i > j) {
+                    return n;
+                }
+                if (isConsonant(i)) {
+                    break;
+                }
+                i++;
+            }
+            i++;
+            n++;
+            while (true) {
+                if (i > j) {
+                    return n;
+                }
+                if (!isConsonant(i)) {
+                    break;
+                }
+                i++;
+            }
+            i++;
+        }
+    }
+
+    bool vowelInStem() const {
+        for (int i = 0; i <= j; ++i) {
+            if (!isConsonant(i)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool doubleConsonant(int i) const {
+        return i >= 1 && b[i] == b[i - 1] && isConsonant(i);
+    }
+
+    // consonant-vowel-consonant ending at i, where the last is not w, x or y
+    bool cvc(int i) const {
+        if (i < 2 || !isConsonant(i) || isConsonant(i - 1) || !isConsonant(i - 2)) {
+            return false;
+        }
+        return b[i] != 'w' && b[i] != 'x' && b[i] != 'y';
+    }
+
+    bool ends(std::string_view suffix) {
+        int length = static_cast<int>(suffix.size());
+        if (length > k + 1 || b.compare(static_cast<size_t>(k + 1 - length), suffix.size(), suffix) != 0) {
+            return false;
+        }
+        j = k - length;
+        return true;
+    }
+
+    void setTo(std::string_view replacement) {
+        b.replace(static_cast<size_t>(j + 1), static_cast<size_t>(k - j), replacement);
+        k = j + static_cast<int>(replacement.size());
+    }
+
+    void replaceIfMeasured(std::string_view replacement) {
+        if (measure() > 0) {
+            setTo(replacement);
+        }
+    }
+
+    // Plurals and -ed / -ing: caresses -> caress, ponies -> poni, meetings -> meet
+    void step1ab() {
+        if (b[k] == 's') {
+            if (ends("sses")) {
+                k -= 2;
+            } else if (ends("ies")) {
+                setTo("i");
+            } else if (b[k - 1] != 's') {
+                k--;
+            }
+        }
+        if (ends("eed")) {
+            if (measure() > 0) {
+                k--;
+            }
+        } else if ((ends("ed") || ends("ing")) && vowelInStem()) {
+            k = j;
+            if (ends("at")) {
+                setTo("ate");
+            } else if (ends("bl")) {
+                setTo("ble");
+            } else if (ends("iz")) {
+                setTo("ize");
+            } else if (doubleConsonant(k)) {
+                k--;
+                char c = b[k];
+                if (c == 'l' || c == 's' || c == 'z') {
+                    k++;
+                }
+            } else {
+                j = k;
+                if (measure() == 1 && cvc(k)) {
+                    setTo("e");
+                }
+            }
+        }
+    }
+
+    // Terminal y to i when there is another vowel: happy -> happi
+    void step1c() {
+        if (ends("y") && vowelInStem()) {
+            b[k] = 'i';
+        }
+    }
+
+    // Double suffixes to single ones: relational -> relate
+    void step2() {
+        switch (b[k - 1]) {
+            case 'a':
+                if (ends("ational")) { replaceIfMeasured("ate"); break; }
+                if (ends("tional")) { replaceIfMeasured("tion"); break; }
+                break;
+            case 'c':
+                if (ends("enci")) { replaceIfMeasured("ence"); break; }
+                if (ends("anci")) { replaceIfMeasured("ance"); break; }
+                break;
+            case 'e':
+                if (ends("izer")) { replaceIfMeasured("ize"); break; }
+                break;
+            case 'l':
+                if (ends("bli")) { replaceIfMeasured("ble"); break; }
+                if (ends("alli")) { replaceIfMeasured("al"); break; }
+                if (ends("entli")) { replaceIfMeasured("ent"); break; }
+                if (ends("eli")) { replaceIfMeasured("e"); break; }
+                if (ends("ousli")) { replaceIfMeasured("ous"); break; }
+                break;
+            case 'o':
+                if (ends("ization")) { replaceIfMeasured("ize"); break; }
+                if (ends("ation")) { replaceIfMeasured("ate"); break; }
+                if (ends("ator")) { replaceIfMeasured("ate"); break; }
+                break;
+            case 's':
+                if (ends("alism")) { replaceIfMeasured("al"); break; }
+                if (ends("iveness")) { replaceIfMeasured("ive"); break; }
+                if (ends("fulness")) { replaceIfMeasured("ful"); break; }
+                if (ends("ousness")) { replaceIfMeasured("ous"); break; }
+                break;
+            case 't':
+                if (ends("aliti")) { replaceIfMeasured("al"); break; }
+                if (ends("iviti")) { replaceIfMeasured("ive"); break; }
+                if (ends("biliti")) { replaceIfMeasured("ble"); break; }
+                break;
+            case 'g':
+                if (ends("logi")) { replaceIfMeasured("log"); break; }
+                break;
+            default:
+                break;
+        }
+    }
+
+    // -ic-, -full, -ness etc.: electrical -> electric
+    void step3() {
+        switch (b[k]) {
+            case 'e':
+                if (ends("icate")) { replaceIfMeasured("ic"); break; }
+                if (ends("ative")) { replaceIfMeasured(""); break; }
+                if (ends("alize")) { replaceIfMeasured("al"); break; }
+                break;
+            case 'i':
+                if (ends("iciti")) { replaceIfMeasured("ic"); break; }
+                break;
+            case 'l':
+                if (ends("ical")) { replaceIfMeasured("ic"); break; }
+                if (ends("ful")) { replaceIfMeasured(""); break; }
+                break;
+            case 's':
+                if (ends("ness")) { replaceIfMeasured(""); break; }
+                break;
+            default:
+                break;
+        }
+    }
+
+    // Remaining suffixes when the stem is long enough: adjustment -> adjust
+    void step4() {
+        switch (b[k - 1]) {
+            case 'a':
+                if (ends("al")) break;
+                return;
+            case 'c':
+                if (ends("ance")) break;
+                if (ends("ence")) break;
+                return;
+            case 'e':
+                if (ends("er")) break;
+                return;
+            case 'i':
+                if (ends("ic")) break;
+                return;
+            case 'l':
+                if (ends("able")) break;
+                if (ends("ible")) break;
+                return;
+            case 'n':
+                if (ends("ant")) break;
+                if (ends("ement")) break;
+                if (ends("ment")) break;
+                if (ends("ent")) break;
+                return;
+            case 'o':
+                if (ends("ion") && j >= 0 && (b[j] == 's' || b[j] == 't')) break;
+                if (ends("ou")) break;
+                return;
+            case 's':
+                if (ends("ism")) break;
+                return;
+            case 't':
+                if (ends("ate")) break;
+                if (ends("iti")) break;
+                return;
+            case 'u':
+                if (ends("ous")) break;
+                return;
+            case 'v':
+                if (ends("ive")) break;
+                return;
+            case 'z':
+                if (ends("ize")) break;
+                return;
+            default:
+                return;
+        }
+        if (measure() > 1) {
+            k = j;
+        }
+    }
+
+    // Final -e and double l: probate -> probat, controll -> control
+    void step5() {
+        j = k;
+        if (b[k] == 'e') {
+            int m = measure();
+            if (m > 1 || (m == 1 && !cvc(k - 1))) {
+                k--;
+            }
+        }
+        if (b[k] == 'l' && doubleConsonant(k) && measure() > 1) {
+            k--;
+        }
+    }
+};
+
+} // namespace
+
+std::string Stemmer::stem(std::string_view word) const {
+    // Short words never change, so they are not worth a cache entry
+    if (word.size() <= 2) {
+        return std::string(word);
+    }
+
+    CachePart& part = cache[std::hash<std::string_view>()(word) % CachePartCount];
+    std::string key(word);
+    {
+        std::shared_lock<std::shared_mutex> lock(part.mutex);
+        auto it = part.stems.find(key);
+        if (it != part.stems.end()) {
+            return it->second;
+        }
+    }
+
+    std::string result = computeStem(word);
+    std::unique_lock<std::shared_mutex> lock(part.mutex);
+    if (part.stems.size() < MaxWordsPerPart) {
+        part.stems.emplace(std::move(key), result);
+    }
+    return result;
+}
+
+size_t Stemmer::getCacheSize() const {
+    size_t size = 0;
+    for (const auto& part : cache) {
+        std::shared_lock<std::shared_mutex> lock(part.mutex);
+        size += part.stems.size();
+    }
+    return size;
+}
+
+void Stemmer::clearCache() {
+    for (auto& part : cache) {
+        std::unique_lock<std::shared_mutex> lock(part.mutex);
+        part.stems.clear();
+    }
+}
+
+std::string Stemmer::computeStem(std::string_view word) {
+    // Possessives stem like the bare word: "engine's" -> "engine"
+    std::string_view bare = word;
+    if (bare.size() >= 2 && bare.compare(bare.size() - 2, 2, "'s") == 0) {
+        bare.remove_suffix(2);
+    }
+    while (!bare.empty() && bare.back() == '\'') {
+        bare.remove_suffix(1);
+    }
+    if (bare.empty()) {
+        return std::string(word);
+    }
+
+    bool letters = std::all_of(bare.begin(), bare.end(), [](char c) {
+        return c >= 'a' && c <= 'z';
+    });
+    if (!letters) {
+        return std::string(bare);
+    }
+    return PorterWord(bare).stem();
+}
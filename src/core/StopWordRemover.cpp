@@ -1,6 +1,8 @@
 #include "core/StopWordRemover.h"
+#include <algorithm>
 
-StopWordRemover::StopWordRemover() {
+StopWordRemover::StopWordRemover()
+    : longestStopWord(0) {
     initializeStopWords();
 }
 
@@ -46,6 +48,7 @@ void StopWordRemover::initializeStopWords() {
     
     for (const auto& word : words) {
         stopWords.insert(word);
+        longestStopWord = std::max(longestStopWord, word.size());
     }
 }
 
@@ -61,7 +64,11 @@ std::vector<std::string> StopWordRemover::removeStopWords(const std::vector<std:
     return filtered;
 }
 
-bool StopWordRemover::isStopWord(const std::string& word) const {
-    return stopWords.find(word) != stopWords.end();
+bool StopWordRemover::isStopWord(std::string_view word) const {
+    // Longer words cannot match, and shorter ones fit std::string's inline buffer
+    if (word.size() > longestStopWord) {
+        return false;
+    }
+    return stopWords.find(std::string(word)) != stopWords.end();
 }
 
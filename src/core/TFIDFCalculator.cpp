@@ -11,32 +11,34 @@ double TFIDFCalculator::calculateTFIDF(const std::string& term, const std::share
 }
 
 double TFIDFCalculator::calculateTF(const std::string& term, const std::shared_ptr<Document>& document) const {
-    if (document->totalTerms == 0) {
-        return 0.0;
-    }
-    
     auto it = document->termFrequency.find(term);
     if (it == document->termFrequency.end()) {
         return 0.0;
     }
     
-    // Normalized term frequency
-    return static_cast<double>(it->second) / document->totalTerms;
+    return calculateTF(it->second, document->totalTerms);
 }
 
-double TFIDFCalculator::calculateIDF(const std::string& term) const {
-    int df = getDocumentFrequency(term);
-    if (df == 0) {
+double TFIDFCalculator::calculateTF(int count, int totalTerms) {
+    if (totalTerms == 0) {
         return 0.0;
     }
     
-    size_t totalDocs = indexer.getDocumentCount();
-    if (totalDocs == 0) {
+    // Normalized term frequency
+    return static_cast<double>(count) / totalTerms;
+}
+
+double TFIDFCalculator::calculateIDF(const std::string& term) const {
+    return calculateIDF(static_cast<size_t>(getDocumentFrequency(term)), indexer.getDocumentCount());
+}
+
+double TFIDFCalculator::calculateIDF(size_t documentFrequency, size_t totalDocuments) {
+    if (documentFrequency == 0 || totalDocuments == 0) {
         return 0.0;
     }
     
     // IDF = log(total_documents / documents_containing_term)
-    return std::log(static_cast<double>(totalDocs) / df);
+    return std::log(static_cast<double>(totalDocuments) / documentFrequency);
 }
 
 int TFIDFCalculator::getDocumentFrequency(const std::string& term) const {
@@ -0,0 +1,319 @@
+#include "core/TermDictionary.h"
+#include "core/LevenshteinAutomaton.h"
+#include "core/Tokenizer.h"
+#include <algorithm>
+
+namespace {
+
+void writeVarint(std::string& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+// Bytes of the UTF-8 character starting at text[i]: its lead byte and continuation bytes
+size_t characterLength(const std::string& text, size_t i) {
+    size_t length = 1;
+    while (i + length < text.size() && (static_cast<uint8_t>(text[i + length]) & 0xC0) == 0x80) {
+        length++;
+    }
+    return length;
+}
+
+uint32_t readVarint(const std::string& in, size_t& offset) {
+    uint32_t value = 0;
+    int shift = 0;
+    while (true) {
+        uint8_t byte = static_cast<uint8_t>(in[offset++]);
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+        shift += 7;
+    }
+}
+
+/**
+ * @brief Computes the smallest string greater than every string with the prefix.
+ *
+ * @return The successor, or empty if no such string exists (all bytes 0xFF)
+ */
+std::string prefixSuccessor(std::string prefix) {
+    while (!prefix.empty()) {
+        unsigned char last = static_cast<unsigned char>(prefix.back());
+        if (last != 0xFF) {
+            prefix.back() = static_cast<char>(last + 1);
+            return prefix;
+        }
+        prefix.pop_back();
+    }
+    return prefix;
+}
+
+} // namespace
+
+void TermDictionary::Iterator::next() {
+    if (!valid()) {
+        return;
+    }
+    ordinal++;
+    if (!valid()) {
+        return;
+    }
+
+    if (ordinal % BlockSize == 0) {
+        loadBlock(ordinal / BlockSize);
+        return;
+    }
+
+    const std::string& data = dictionary->data;
+    uint32_t shared = readVarint(data, offset);
+    uint32_t suffix = readVarint(data, offset);
+    current.resize(shared);
+    current.append(data, offset, suffix);
+    offset += suffix;
+}
+
+void TermDictionary::Iterator::loadBlock(size_t block) {
+    const std::string& data = dictionary->data;
+    ordinal = static_cast<uint32_t>(block * BlockSize);
+    offset = dictionary->blockOffsets[block];
+    uint32_t length = readVarint(data, offset);
+    current.assign(data, offset, length);
+    offset += length;
+}
+
+TermDictionary::TermDictionary()
+    : termCount(0) {
+}
+
+void TermDictionary::build(std::vector<std::string> terms) {
+    std::sort(terms.begin(), terms.end());
+    terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+
+    data.clear();
+    blockOffsets.clear();
+    termCount = terms.size();
+
+    for (size_t i = 0; i < terms.size(); ++i) {
+        const std::string& term = terms[i];
+        if (i % BlockSize == 0) {
+            blockOffsets.push_back(static_cast<uint32_t>(data.size()));
+            writeVarint(data, static_cast<uint32_t>(term.size()));
+            data.append(term);
+            continue;
+        }
+
+        const std::string& previous = terms[i - 1];
+        size_t limit = std::min(previous.size(), term.size());
+        size_t shared = 0;
+        while (shared < limit && previous[shared] == term[shared]) {
+            shared++;
+        }
+        writeVarint(data, static_cast<uint32_t>(shared));
+        writeVarint(data, static_cast<uint32_t>(term.size() - shared));
+        data.append(term, shared, std::string::npos);
+    }
+
+    data.shrink_to_fit();
+    blockOffsets.shrink_to_fit();
+}
+
+size_t TermDictionary::size() const {
+    return termCount;
+}
+
+size_t TermDictionary::getMemoryUsage() const {
+    return data.capacity() + blockOffsets.capacity() * sizeof(uint32_t);
+}
+
+bool TermDictionary::find(const std::string& term, uint32_t& ordinal) const {
+    Iterator it = seek(term);
+    if (!it.valid() || it.term() != term) {
+        return false;
+    }
+    ordinal = it.getOrdinal();
+    return true;
+}
+
+TermDictionary::Iterator TermDictionary::begin() const {
+    Iterator it;
+    it.dictionary = this;
+    if (termCount > 0) {
+        it.loadBlock(0);
+    }
+    return it;
+}
+
+TermDictionary::Iterator TermDictionary::seek(const std::string& target) const {
+    Iterator it;
+    it.dictionary = this;
+    if (termCount == 0) {
+        return it;
+    }
+
+    // Last block whose head is <= target; the target cannot sort before it
+    size_t low = 0;
+    size_t high = blockOffsets.size();
+    while (high - low > 1) {
+        size_t mid = low + (high - low) / 2;
+        if (compareBlockHead(mid, target) <= 0) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+
+    it.loadBlock(low);
+    while (it.valid() && it.term() < target) {
+        it.next();
+    }
+    return it;
+}
+
+std::vector<std::string> TermDictionary::expandPrefix(const std::string& prefix, size_t limit) const {
+    std::string upper = prefixSuccessor(prefix);
+    return expandRange(prefix, upper, limit);
+}
+
+std::vector<std::string> TermDictionary::expandWildcard(const std::string& pattern, size_t limit) const {
+    size_t wildcard = pattern.find_first_of("*?");
+    if (wildcard == std::string::npos) {
+        uint32_t ordinal = 0;
+        return find(pattern, ordinal) ? std::vector<std::string>{pattern} : std::vector<std::string>();
+    }
+
+    // Terms that can match all share the literal prefix, so only that range is scanned
+    std::string prefix = pattern.substr(0, wildcard);
+    std::string upper = prefixSuccessor(prefix);
+
+    std::vector<std::string> matches;
+    for (Iterator it = seek(prefix); it.valid() && matches.size() < limit; it.next()) {
+        if (!upper.empty() && it.term() >= upper) {
+            break;
+        }
+        if (matchesWildcard(pattern, it.term())) {
+            matches.push_back(it.term());
+        }
+    }
+    return matches;
+}
+
+std::vector<std::string> TermDictionary::expandRange(const std::string& lower, const std::string& upper,
+                                                     size_t limit) const {
+    std::vector<std::string> matches;
+    for (Iterator it = seek(lower); it.valid() && matches.size() < limit; it.next()) {
+        if (!upper.empty() && it.term() >= upper) {
+            break;
+        }
+        matches.push_back(it.term());
+    }
+    return matches;
+}
+
+std::vector<FuzzyTerm> TermDictionary::expandFuzzy(const LevenshteinAutomaton& automaton, size_t limit) const {
+    std::vector<FuzzyTerm> matches;
+
+    // states[d] is the automaton state after the first d bytes of `previous`;
+    // inside a multi-byte character it is the state before that character
+    std::vector<LevenshteinAutomaton::State> states;
+    states.push_back(automaton.start());
+    std::string previous;
+
+    Iterator it = begin();
+    while (it.valid()) {
+        const std::string& term = it.term();
+        size_t shared = 0;
+        size_t limitShared = std::min(previous.size(), term.size());
+        while (shared < limitShared && previous[shared] == term[shared]) {
+            shared++;
+        }
+        // Resume at the start of the character the terms first differ in
+        while (shared > 0 && shared < term.size() && (static_cast<unsigned char>(term[shared]) & 0xC0) == 0x80) {
+            shared--;
+        }
+        states.resize(shared + 1);
+
+        size_t depth = shared;
+        size_t length = 0;
+        bool dead = false;
+        while (depth < term.size()) {
+            uint32_t codePoint = 0;
+            length = Tokenizer::decodeCharacter(std::string_view(term).substr(depth), codePoint);
+            LevenshteinAutomaton::State next = automaton.step(states[depth], codePoint);
+            if (!automaton.canMatch(next)) {
+                dead = true;
+                break;
+            }
+            for (size_t i = 1; i < length; ++i) {
+                states.push_back(states[depth]);
+            }
+            states.push_back(std::move(next));
+            depth += length;
+        }
+
+        if (dead) {
+            // No term starting with term[0..depth + length) can be accepted
+            std::string successor = prefixSuccessor(term.substr(0, depth + length));
+            previous = term.substr(0, depth);
+            if (successor.empty()) {
+                break;
+            }
+            it = seek(successor);
+            continue;
+        }
+
+        if (automaton.isMatch(states.back())) {
+            matches.push_back({term, automaton.distance(states.back())});
+        }
+        previous = term;
+        it.next();
+    }
+
+    // Matches are collected in term order; keep the closest ones
+    std::stable_sort(matches.begin(), matches.end(), [](const FuzzyTerm& a, const FuzzyTerm& b) {
+        return a.distance < b.distance;
+    });
+    if (matches.size() > limit) {
+        matches.erase(matches.begin() + limit, matches.end());
+    }
+    return matches;
+}
+
+bool TermDictionary::matchesWildcard(const std::string& pattern, const std::string& term) {
+    // Greedy matching that backtracks to the most recent '*'
+    size_t p = 0;
+    size_t t = 0;
+    size_t star = std::string::npos;
+    size_t resume = 0;
+    while (t < term.size()) {
+        if (p < pattern.size() && pattern[p] == '?') {
+            p++;
+            t += characterLength(term, t);
+        } else if (p < pattern.size() && pattern[p] == term[t]) {
+            p++;
+            t++;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            resume = t;
+        } else if (star != std::string::npos) {
+            p = star + 1;
+            resume += characterLength(term, resume);
+            t = resume;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') {
+        p++;
+    }
+    return p == pattern.size();
+}
+
+int TermDictionary::compareBlockHead(size_t block, const std::string& target) const {
+    size_t offset = blockOffsets[block];
+    uint32_t length = readVarint(data, offset);
+    return data.compare(offset, length, target);
+}
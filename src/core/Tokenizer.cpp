@@ -2,38 +2,642 @@
 #include <sstream>
 #include <regex>
 
-std::vector<std::string> Tokenizer::tokenize(const std::string& text) {
-    std::vector<std::string> tokens;
-    std::string currentToken;
-    
-    for (char c : text) {
-        if (std::isalnum(c) || c == '\'') {
-            currentToken += std::tolower(c);
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TOKENIZER_SSE2 1
+#endif
+
+namespace {
+
+/**
+ * @brief How a character takes part in words.
+ */
+enum class CharClass : uint8_t {
+    Separator, // ends the current word
+    Letter,    // letters, digits, combining marks: continue the current word
+    Ideograph  // a word on its own
+};
+
+/**
+ * @brief Code points [first, last] of one class.
+ */
+struct ClassRange {
+    uint32_t first;
+    uint32_t last;
+    CharClass charClass;
+};
+
+// Punctuation, symbols, spaces and ideographs beyond ASCII, by ascending
+// code point. Everything else is a letter, so scripts without an entry
+// still form words.
+const ClassRange ClassRanges[] = {
+    {0x0080, 0x00A9, CharClass::Separator}, // C1 controls, no-break space, Latin-1 punctuation
+    {0x00AB, 0x00B4, CharClass::Separator},
+    {0x00B6, 0x00B9, CharClass::Separator},
+    {0x00BB, 0x00BF, CharClass::Separator},
+    {0x00D7, 0x00D7, CharClass::Separator}, // multiplication sign
+    {0x00F7, 0x00F7, CharClass::Separator}, // division sign
+    {0x02C2, 0x02C5, CharClass::Separator}, // modifier symbols
+    {0x02D2, 0x02DF, CharClass::Separator},
+    {0x02E5, 0x02EB, CharClass::Separator},
+    {0x02ED, 0x02ED, CharClass::Separator},
+    {0x02EF, 0x02FF, CharClass::Separator},
+    {0x037E, 0x037E, CharClass::Separator}, // Greek question mark
+    {0x0384, 0x0385, CharClass::Separator},
+    {0x0387, 0x0387, CharClass::Separator},
+    {0x03F6, 0x03F6, CharClass::Separator},
+    {0x0482, 0x0482, CharClass::Separator},
+    {0x055A, 0x055F, CharClass::Separator}, // Armenian punctuation
+    {0x0589, 0x058A, CharClass::Separator},
+    {0x058D, 0x058F, CharClass::Separator},
+    {0x05BE, 0x05BE, CharClass::Separator}, // Hebrew punctuation
+    {0x05C0, 0x05C0, CharClass::Separator},
+    {0x05C3, 0x05C3, CharClass::Separator},
+    {0x05C6, 0x05C6, CharClass::Separator},
+    {0x05F3, 0x05F4, CharClass::Separator},
+    {0x0600, 0x060F, CharClass::Separator}, // Arabic punctuation
+    {0x061B, 0x061F, CharClass::Separator},
+    {0x066A, 0x066D, CharClass::Separator},
+    {0x06D4, 0x06D4, CharClass::Separator},
+    {0x06DD, 0x06DE, CharClass::Separator},
+    {0x06E9, 0x06E9, CharClass::Separator},
+    {0x06FD, 0x06FE, CharClass::Separator},
+    {0x0700, 0x070F, CharClass::Separator}, // Syriac punctuation
+    {0x0964, 0x0965, CharClass::Separator}, // danda
+    {0x0970, 0x0970, CharClass::Separator},
+    {0x0E3F, 0x0E3F, CharClass::Separator}, // Thai currency and punctuation
+    {0x0E4F, 0x0E4F, CharClass::Separator},
+    {0x0E5A, 0x0E5B, CharClass::Separator},
+    {0x0F04, 0x0F14, CharClass::Separator}, // Tibetan punctuation
+    {0x104A, 0x104F, CharClass::Separator}, // Myanmar punctuation
+    {0x10FB, 0x10FB, CharClass::Separator},
+    {0x1360, 0x1368, CharClass::Separator}, // Ethiopic punctuation
+    {0x1680, 0x1680, CharClass::Separator},
+    {0x16EB, 0x16ED, CharClass::Separator},
+    {0x17D4, 0x17D6, CharClass::Separator}, // Khmer punctuation
+    {0x17D8, 0x17DA, CharClass::Separator},
+    {0x1800, 0x180A, CharClass::Separator}, // Mongolian punctuation
+    {0x1FBD, 0x1FBD, CharClass::Separator}, // Greek spacing accents
+    {0x1FBF, 0x1FC1, CharClass::Separator},
+    {0x1FCD, 0x1FCF, CharClass::Separator},
+    {0x1FDD, 0x1FDF, CharClass::Separator},
+    {0x1FED, 0x1FEF, CharClass::Separator},
+    {0x1FFD, 0x1FFE, CharClass::Separator},
+    {0x2000, 0x200B, CharClass::Separator}, // spaces; zero-width (non-)joiners stay in words
+    {0x200E, 0x2018, CharClass::Separator}, // U+2019 is folded to an apostrophe
+    {0x201A, 0x206F, CharClass::Separator},
+    {0x2070, 0x20CF, CharClass::Separator}, // super- and subscripts, currency
+    {0x2100, 0x2BFF, CharClass::Separator}, // letterlike, number forms, arrows, math, shapes, dingbats
+    {0x2CF9, 0x2CFF, CharClass::Separator},
+    {0x2E00, 0x2E7F, CharClass::Separator}, // supplemental punctuation
+    {0x2E80, 0x2FFF, CharClass::Separator}, // CJK radicals, ideographic description
+    {0x3000, 0x3004, CharClass::Separator}, // ideographic space and punctuation
+    {0x3005, 0x3007, CharClass::Ideograph},
+    {0x3008, 0x3020, CharClass::Separator}, // CJK brackets
+    {0x3021, 0x3029, CharClass::Ideograph},
+    {0x3030, 0x3030, CharClass::Separator},
+    {0x3036, 0x3037, CharClass::Separator},
+    {0x303D, 0x303F, CharClass::Separator},
+    {0x3041, 0x3096, CharClass::Ideograph}, // hiragana
+    {0x30A0, 0x30A0, CharClass::Separator},
+    {0x30FB, 0x30FB, CharClass::Separator}, // katakana middle dot
+    {0x3200, 0x33FF, CharClass::Separator}, // enclosed and compatibility CJK
+    {0x3400, 0x4DBF, CharClass::Ideograph}, // CJK extension A
+    {0x4DC0, 0x4DFF, CharClass::Separator},
+    {0x4E00, 0x9FFF, CharClass::Ideograph}, // CJK unified ideographs
+    {0xD800, 0xF8FF, CharClass::Separator}, // surrogates, private use
+    {0xF900, 0xFAFF, CharClass::Ideograph}, // CJK compatibility ideographs
+    {0xFD3E, 0xFD3F, CharClass::Separator},
+    {0xFE10, 0xFE1F, CharClass::Separator}, // vertical forms
+    {0xFE30, 0xFE6F, CharClass::Separator}, // CJK compatibility and small forms
+    {0xFEFF, 0xFEFF, CharClass::Separator}, // byte order mark
+    {0xFF00, 0xFF0F, CharClass::Separator}, // fullwidth punctuation
+    {0xFF1A, 0xFF20, CharClass::Separator},
+    {0xFF3B, 0xFF40, CharClass::Separator},
+    {0xFF5B, 0xFF65, CharClass::Separator},
+    {0xFFE0, 0xFFFF, CharClass::Separator},
+    {0x1D000, 0x1D24F, CharClass::Separator}, // musical symbols
+    {0x1F000, 0x1FAFF, CharClass::Separator}, // emoji and pictographs
+    {0x20000, 0x3FFFF, CharClass::Ideograph}, // CJK extensions B and later
+    {0xE0000, 0x10FFFF, CharClass::Separator}, // tags, private use
+};
+
+/**
+ * @brief Code points [first, last], every stride-th from first, fold to code point + delta.
+ */
+struct FoldRange {
+    uint32_t first;
+    uint32_t last;
+    int32_t delta;
+    uint32_t stride;
+};
+
+// Simple case folding beyond ASCII, by ascending code point
+const FoldRange FoldRanges[] = {
+    {0x00B5, 0x00B5, 775, 1}, // micro sign -> Greek mu
+    {0x00C0, 0x00D6, 32, 1},
+    {0x00D8, 0x00DE, 32, 1},
+    {0x0100, 0x012F, 1, 2},
+    {0x0130, 0x0130, -199, 1}, // dotted capital I -> i
+    {0x0132, 0x0137, 1, 2},
+    {0x0139, 0x0148, 1, 2},
+    {0x014A, 0x0177, 1, 2},
+    {0x0178, 0x0178, -121, 1},
+    {0x0179, 0x017E, 1, 2},
+    {0x017F, 0x017F, -268, 1}, // long s
+    {0x0181, 0x0181, 210, 1},
+    {0x0182, 0x0185, 1, 2},
+    {0x0186, 0x0186, 206, 1},
+    {0x0187, 0x0187, 1, 1},
+    {0x0189, 0x018A, 205, 1},
+    {0x018B, 0x018B, 1, 1},
+    {0x018E, 0x018E, 79, 1},
+    {0x018F, 0x018F, 202, 1},
+    {0x0190, 0x0190, 203, 1},
+    {0x0191, 0x0191, 1, 1},
+    {0x0193, 0x0193, 205, 1},
+    {0x0194, 0x0194, 207, 1},
+    {0x0196, 0x0196, 211, 1},
+    {0x0197, 0x0197, 209, 1},
+    {0x0198, 0x0198, 1, 1},
+    {0x019C, 0x019C, 211, 1},
+    {0x019D, 0x019D, 213, 1},
+    {0x019F, 0x019F, 214, 1},
+    {0x01A0, 0x01A5, 1, 2},
+    {0x01A6, 0x01A6, 218, 1},
+    {0x01A7, 0x01A7, 1, 1},
+    {0x01A9, 0x01A9, 218, 1},
+    {0x01AC, 0x01AC, 1, 1},
+    {0x01AE, 0x01AE, 218, 1},
+    {0x01AF, 0x01AF, 1, 1},
+    {0x01B1, 0x01B2, 217, 1},
+    {0x01B3, 0x01B5, 1, 2},
+    {0x01B7, 0x01B7, 219, 1},
+    {0x01B8, 0x01B8, 1, 1},
+    {0x01BC, 0x01BC, 1, 1},
+    {0x01C4, 0x01C4, 2, 1},
+    {0x01C5, 0x01C5, 1, 1},
+    {0x01C7, 0x01C7, 2, 1},
+    {0x01C8, 0x01C8, 1, 1},
+    {0x01CA, 0x01CA, 2, 1},
+    {0x01CB, 0x01DB, 1, 2},
+    {0x01DE, 0x01EE, 1, 2},
+    {0x01F1, 0x01F1, 2, 1},
+    {0x01F2, 0x01F4, 1, 2},
+    {0x01F6, 0x01F6, -97, 1},
+    {0x01F7, 0x01F7, -56, 1},
+    {0x01F8, 0x021E, 1, 2},
+    {0x0220, 0x0220, -130, 1},
+    {0x0222, 0x0232, 1, 2},
+    {0x023A, 0x023A, 10795, 1},
+    {0x023B, 0x023B, 1, 1},
+    {0x023D, 0x023D, -163, 1},
+    {0x023E, 0x023E, 10792, 1},
+    {0x0241, 0x0241, 1, 1},
+    {0x0243, 0x0243, -195, 1},
+    {0x0244, 0x0244, 69, 1},
+    {0x0245, 0x0245, 71, 1},
+    {0x0246, 0x024E, 1, 2},
+    {0x0345, 0x0345, 116, 1},
+    {0x0370, 0x0372, 1, 2},
+    {0x0376, 0x0376, 1, 1},
+    {0x037F, 0x037F, 116, 1},
+    {0x0386, 0x0386, 38, 1},
+    {0x0388, 0x038A, 37, 1},
+    {0x038C, 0x038C, 64, 1},
+    {0x038E, 0x038F, 63, 1},
+    {0x0391, 0x03A1, 32, 1},
+    {0x03A3, 0x03AB, 32, 1},
+    {0x03C2, 0x03C2, 1, 1}, // final sigma
+    {0x03CF, 0x03CF, 8, 1},
+    {0x03D0, 0x03D0, -30, 1},
+    {0x03D1, 0x03D1, -25, 1},
+    {0x03D5, 0x03D5, -15, 1},
+    {0x03D6, 0x03D6, -22, 1},
+    {0x03D8, 0x03EE, 1, 2},
+    {0x03F0, 0x03F0, -54, 1},
+    {0x03F1, 0x03F1, -48, 1},
+    {0x03F4, 0x03F4, -60, 1},
+    {0x03F5, 0x03F5, -64, 1},
+    {0x03F7, 0x03F7, 1, 1},
+    {0x03F9, 0x03F9, -7, 1},
+    {0x03FA, 0x03FA, 1, 1},
+    {0x03FD, 0x03FF, -130, 1},
+    {0x0400, 0x040F, 80, 1},
+    {0x0410, 0x042F, 32, 1},
+    {0x0460, 0x0480, 1, 2},
+    {0x048A, 0x04BE, 1, 2},
+    {0x04C0, 0x04C0, 15, 1},
+    {0x04C1, 0x04CD, 1, 2},
+    {0x04D0, 0x052E, 1, 2},
+    {0x0531, 0x0556, 48, 1},
+    {0x10A0, 0x10C5, 7264, 1},
+    {0x10C7, 0x10C7, 7264, 1},
+    {0x10CD, 0x10CD, 7264, 1},
+    {0x1E00, 0x1E94, 1, 2},
+    {0x1E9B, 0x1E9B, -58, 1},
+    {0x1E9E, 0x1E9E, -7615, 1}, // capital sharp s -> sharp s
+    {0x1EA0, 0x1EFE, 1, 2},
+    {0x1F08, 0x1F0F, -8, 1},
+    {0x1F18, 0x1F1D, -8, 1},
+    {0x1F28, 0x1F2F, -8, 1},
+    {0x1F38, 0x1F3F, -8, 1},
+    {0x1F48, 0x1F4D, -8, 1},
+    {0x1F59, 0x1F5F, -8, 2},
+    {0x1F68, 0x1F6F, -8, 1},
+    {0x1FB8, 0x1FB9, -8, 1},
+    {0x1FBA, 0x1FBB, -74, 1},
+    {0x1FBE, 0x1FBE, -7173, 1},
+    {0x1FC8, 0x1FCB, -86, 1},
+    {0x1FD8, 0x1FD9, -8, 1},
+    {0x1FDA, 0x1FDB, -100, 1},
+    {0x1FE8, 0x1FE9, -8, 1},
+    {0x1FEA, 0x1FEB, -112, 1},
+    {0x1FEC, 0x1FEC, -7, 1},
+    {0x1FF8, 0x1FF9, -128, 1},
+    {0x1FFA, 0x1FFB, -126, 1},
+    {0x2019, 0x2019, -8178, 1}, // right single quotation mark -> apostrophe
+    {0x2C00, 0x2C2F, 48, 1},
+    {0x2C60, 0x2C60, 1, 1},
+    {0x2C62, 0x2C62, -10743, 1},
+    {0x2C63, 0x2C63, -3814, 1},
+    {0x2C64, 0x2C64, -10727, 1},
+    {0x2C67, 0x2C6B, 1, 2},
+    {0x2C80, 0x2CE2, 1, 2},
+    {0xA640, 0xA66C, 1, 2},
+    {0xA680, 0xA69A, 1, 2},
+    {0xA722, 0xA72E, 1, 2},
+    {0xA732, 0xA76E, 1, 2},
+    {0xA779, 0xA77B, 1, 2},
+    {0xA77E, 0xA786, 1, 2},
+    {0xFF21, 0xFF3A, 32, 1}, // fullwidth Latin capitals
+    {0x10400, 0x10427, 40, 1},
+};
+
+// Code points below this (all of one- and two-byte UTF-8) are looked up directly
+constexpr uint32_t DirectLimit = 0x800;
+
+constexpr uint32_t SharpS = 0xDF;
+
+template <typename Range, size_t Count>
+const Range* findRange(const Range (&ranges)[Count], uint32_t codePoint) {
+    const Range* it = std::upper_bound(ranges, ranges + Count, codePoint,
+                                       [](uint32_t value, const Range& range) { return value < range.first; });
+    if (it == ranges || codePoint > (it - 1)->last) {
+        return nullptr;
+    }
+    return it - 1;
+}
+
+CharClass lookupClass(uint32_t codePoint) {
+    const ClassRange* range = findRange(ClassRanges, codePoint);
+    return range ? range->charClass : CharClass::Letter;
+}
+
+uint32_t lookupFold(uint32_t codePoint) {
+    const FoldRange* range = findRange(FoldRanges, codePoint);
+    if (!range || (codePoint - range->first) % range->stride != 0) {
+        return codePoint;
+    }
+    return static_cast<uint32_t>(static_cast<int32_t>(codePoint) + range->delta);
+}
+
+/**
+ * @brief Class and folding of every code point below DirectLimit, expanded from the range tables.
+ */
+struct CharTables {
+    uint8_t asciiFolded[128];          // lowercase byte of ASCII word characters, 0 for separators
+    CharClass classes[DirectLimit];
+    uint16_t folded[DirectLimit];
+
+    CharTables() {
+        for (uint32_t c = 0; c < 128; ++c) {
+            bool word = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '\'';
+            asciiFolded[c] = word ? static_cast<uint8_t>(c >= 'A' && c <= 'Z' ? c + 32 : c) : 0;
+        }
+        for (uint32_t c = 0; c < DirectLimit; ++c) {
+            classes[c] = c < 128 ? (asciiFolded[c] ? CharClass::Letter : CharClass::Separator) : lookupClass(c);
+            folded[c] = static_cast<uint16_t>(c < 128 ? (asciiFolded[c] ? asciiFolded[c] : c) : lookupFold(c));
+        }
+    }
+};
+
+const CharTables& getCharTables() {
+    static const CharTables tables;
+    return tables;
+}
+
+/**
+ * @brief Decodes one UTF-8 sequence, rejecting overlong forms, surrogates and values past U+10FFFF.
+ *
+ * @param text Bytes starting with a non-ASCII lead byte
+ * @param available Number of bytes left in the text
+ * @param codePoint Receives the decoded code point
+ * @return Length of the sequence, 0 if it is not valid UTF-8
+ */
+size_t decodeUtf8(const unsigned char* text, size_t available, uint32_t& codePoint) {
+    unsigned char lead = text[0];
+    size_t length;
+    unsigned char low = 0x80;
+    unsigned char high = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+        codePoint = lead & 0x1F;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        codePoint = lead & 0x0F;
+        low = lead == 0xE0 ? 0xA0 : 0x80;
+        high = lead == 0xED ? 0x9F : 0xBF;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        codePoint = lead & 0x07;
+        low = lead == 0xF0 ? 0x90 : 0x80;
+        high = lead == 0xF4 ? 0x8F : 0xBF;
+    } else {
+        return 0;
+    }
+    if (available < length || text[1] < low || text[1] > high) {
+        return 0;
+    }
+    codePoint = (codePoint << 6) | (text[1] & 0x3F);
+    for (size_t i = 2; i < length; ++i) {
+        if ((text[i] & 0xC0) != 0x80) {
+            return 0;
+        }
+        codePoint = (codePoint << 6) | (text[i] & 0x3F);
+    }
+    return length;
+}
+
+template <typename String>
+void appendUtf8(String& text, uint32_t codePoint) {
+    if (codePoint < 0x80) {
+        text += static_cast<char>(codePoint);
+    } else if (codePoint < 0x800) {
+        text += static_cast<char>(0xC0 | (codePoint >> 6));
+        text += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else if (codePoint < 0x10000) {
+        text += static_cast<char>(0xE0 | (codePoint >> 12));
+        text += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        text += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else {
+        text += static_cast<char>(0xF0 | (codePoint >> 18));
+        text += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+        text += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        text += static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+}
+
+/**
+ * @brief Appends the folded form of a word character.
+ *
+ * @param source The character's UTF-8 bytes
+ * @param length Number of bytes
+ * @param codePoint The character
+ * @param folded Its folded code point
+ */
+template <typename String>
+void appendFolded(String& text, const unsigned char* source, size_t length, uint32_t codePoint, uint32_t folded) {
+    // Full case folding of sharp s, so "straße" matches "strasse"
+    if (folded == SharpS) {
+        text += "ss";
+    } else if (folded == codePoint) {
+        // Most characters fold to themselves: copy their bytes as they are
+        text.append(reinterpret_cast<const char*>(source), length);
+    } else {
+        appendUtf8(text, folded);
+    }
+}
+
+/**
+ * @brief Decodes, classifies and folds the non-ASCII character at the start of text.
+ *
+ * @param length Receives the number of bytes consumed (1 for an invalid byte)
+ * @param codePoint Receives the decoded code point
+ * @param folded Receives the folded code point of a word character
+ * @return The character's class; invalid bytes are separators
+ */
+CharClass classify(const unsigned char* text, size_t available, size_t& length, uint32_t& codePoint,
+                   uint32_t& folded) {
+    const CharTables& tables = getCharTables();
+    length = decodeUtf8(text, available, codePoint);
+    if (length == 0) {
+        length = 1;
+        return CharClass::Separator;
+    }
+    if (codePoint < DirectLimit) {
+        folded = tables.folded[codePoint];
+        return tables.classes[codePoint];
+    }
+    folded = lookupFold(codePoint);
+    return lookupClass(codePoint);
+}
+
+#ifdef TOKENIZER_SSE2
+int countTrailingZeros(unsigned int mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(mask);
+#else
+    int count = 0;
+    while (!(mask & 1u)) {
+        mask >>= 1;
+        count++;
+    }
+    return count;
+#endif
+}
+#endif
+
+} // namespace
+
+template <typename Tokens>
+void Tokenizer::tokenizeText(std::string_view text, Tokens& tokens, std::vector<TokenSpan>* spans) const {
+    const CharTables& tables = getCharTables();
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(text.data());
+    size_t size = text.size();
+
+    typename Tokens::value_type currentToken(tokens.get_allocator());
+    size_t tokenStart = 0;
+    size_t tokenChars = 0; // code points in currentToken
+
+    auto emitToken = [&](size_t begin, size_t end) {
+        tokens.emplace_back(currentToken);
+        if (spans) {
+            spans->push_back({static_cast<uint32_t>(begin), static_cast<uint32_t>(end)});
+        }
+        currentToken.clear();
+    };
+
+    // Single characters are not worth indexing, except ideographs
+    auto finishToken = [&](size_t end) {
+        if (tokenChars > 1) {
+            emitToken(tokenStart, end);
         } else {
-            if (!currentToken.empty() && currentToken.length() > 1) {
-                tokens.push_back(currentToken);
-                currentToken.clear();
+            currentToken.clear();
+        }
+        tokenChars = 0;
+    };
+
+    size_t i = 0;
+    while (i < size) {
+#ifdef TOKENIZER_SSE2
+        // Pure ASCII blocks: classify and lowercase 16 bytes at once, then
+        // copy whole runs of word characters
+        if (i + 16 <= size) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i));
+            if (_mm_movemask_epi8(block) == 0) {
+                __m128i caseless = _mm_or_si128(block, _mm_set1_epi8(0x20));
+                __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(caseless, _mm_set1_epi8('a' - 1)),
+                                                _mm_cmplt_epi8(caseless, _mm_set1_epi8('z' + 1)));
+                __m128i digits = _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8('0' - 1)),
+                                               _mm_cmplt_epi8(block, _mm_set1_epi8('9' + 1)));
+                __m128i apostrophes = _mm_cmpeq_epi8(block, _mm_set1_epi8('\''));
+                __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8('A' - 1)),
+                                              _mm_cmplt_epi8(block, _mm_set1_epi8('Z' + 1)));
+                alignas(16) char lowered[16];
+                _mm_store_si128(reinterpret_cast<__m128i*>(lowered),
+                                _mm_or_si128(block, _mm_and_si128(upper, _mm_set1_epi8(0x20))));
+                unsigned int wordMask = static_cast<unsigned int>(
+                    _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(letters, digits), apostrophes)));
+
+                size_t offset = 0;
+                while (offset < 16) {
+                    unsigned int rest = wordMask >> offset;
+                    if (rest & 1u) {
+                        size_t run = static_cast<size_t>(countTrailingZeros(~rest));
+                        if (tokenChars == 0) {
+                            tokenStart = i + offset;
+                        }
+                        currentToken.append(lowered + offset, run);
+                        tokenChars += run;
+                        offset += run;
+                    } else {
+                        finishToken(i + offset);
+                        offset += rest == 0 ? 16 - offset : static_cast<size_t>(countTrailingZeros(rest));
+                    }
+                }
+                i += 16;
+                continue;
+            }
+        }
+#endif
+
+        unsigned char c = bytes[i];
+        if (c < 0x80) {
+            uint8_t folded = tables.asciiFolded[c];
+            if (folded) {
+                if (tokenChars == 0) {
+                    tokenStart = i;
+                }
+                currentToken += static_cast<char>(folded);
+                tokenChars++;
             } else {
-                currentToken.clear();
+                finishToken(i);
             }
+            i++;
+            continue;
         }
+
+        size_t length;
+        uint32_t codePoint = 0;
+        uint32_t folded = 0;
+        switch (classify(bytes + i, size - i, length, codePoint, folded)) {
+            case CharClass::Letter:
+                if (tokenChars == 0) {
+                    tokenStart = i;
+                }
+                appendFolded(currentToken, bytes + i, length, codePoint, folded);
+                tokenChars++;
+                break;
+            case CharClass::Ideograph:
+                finishToken(i);
+                currentToken.append(text.data() + i, length);
+                emitToken(i, i + length);
+                break;
+            case CharClass::Separator:
+                finishToken(i);
+                break;
+        }
+        i += length;
     }
-    
+
     // Add the last token if exists
-    if (!currentToken.empty() && currentToken.length() > 1) {
-        tokens.push_back(currentToken);
-    }
-    
+    finishToken(size);
+}
+
+std::vector<std::string> Tokenizer::tokenize(const std::string& text) const {
+    std::vector<std::string> tokens;
+    tokenizeText(text, tokens, nullptr);
     return tokens;
 }
 
+std::vector<std::string> Tokenizer::tokenize(const std::string& text, std::vector<TokenSpan>& spans) const {
+    std::vector<std::string> tokens;
+    spans.clear();
+    tokenizeText(text, tokens, &spans);
+    return tokens;
+}
+
+void Tokenizer::tokenize(std::string_view text, std::pmr::vector<std::pmr::string>& tokens,
+                         std::vector<TokenSpan>* spans) const {
+    tokenizeText(text, tokens, spans);
+}
+
 bool Tokenizer::isAlphanumeric(char c) {
-    return std::isalnum(c) != 0;
+    unsigned char u = static_cast<unsigned char>(c);
+    return u < 0x80 && u != '\'' && getCharTables().asciiFolded[u] != 0;
+}
+
+void Tokenizer::foldWord(std::string_view text, std::string& folded) {
+    const CharTables& tables = getCharTables();
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(text.data());
+    size_t i = 0;
+    while (i < text.size()) {
+        if (bytes[i] < 0x80) {
+            if (tables.asciiFolded[bytes[i]]) {
+                folded += static_cast<char>(tables.asciiFolded[bytes[i]]);
+            }
+            i++;
+            continue;
+        }
+
+        size_t length;
+        uint32_t codePoint = 0;
+        uint32_t foldedPoint = 0;
+        if (classify(bytes + i, text.size() - i, length, codePoint, foldedPoint) != CharClass::Separator) {
+            appendFolded(folded, bytes + i, length, codePoint, foldedPoint);
+        }
+        i += length;
+    }
+}
+
+size_t Tokenizer::decodeCharacter(std::string_view text, uint32_t& codePoint) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(text.data());
+    if (bytes[0] < 0x80) {
+        codePoint = bytes[0];
+        return 1;
+    }
+    size_t length = decodeUtf8(bytes, text.size(), codePoint);
+    if (length == 0) {
+        codePoint = 0xDC00 + bytes[0];
+        return 1;
+    }
+    return length;
+}
+
+size_t Tokenizer::countCharacters(std::string_view text) {
+    size_t count = 0;
+    uint32_t codePoint = 0;
+    for (size_t i = 0; i < text.size(); i += decodeCharacter(text.substr(i), codePoint)) {
+        count++;
+    }
+    return count;
 }
 
 std::string Tokenizer::toLower(const std::string& str) const {
     std::string result = str;
-    std::transform(result.begin(), result.end(), result.begin(), ::tolower);
+    std::transform(result.begin(), result.end(), result.begin(), [](char c) {
+        return c >= 'A' && c <= 'Z' ? static_cast<char>(c + 32) : c;
+    });
     return result;
 }
-
@@ -0,0 +1,397 @@
+#include "gui/DocumentPreview.h"
+#include <QScrollBar>
+#include <QSyntaxHighlighter>
+#include <QRegularExpression>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+// Bytes decoded into the editor per chunk, and how many chunks may be resident
+constexpr qint64 ChunkSize = 64 * 1024;
+constexpr size_t MaxLoadedChunks = 8;
+
+// Bytes scanned per read when the file cannot be memory-mapped
+constexpr qint64 ScanBlockSize = 1024 * 1024;
+
+inline char asciiLower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+inline bool isWordByte(char c) {
+    unsigned char u = static_cast<unsigned char>(c);
+    return u >= 0x80 || (u >= '0' && u <= '9') || (u >= 'a' && u <= 'z') || (u >= 'A' && u <= 'Z');
+}
+
+struct AsciiFoldHash {
+    size_t operator()(char c) const {
+        return static_cast<unsigned char>(asciiLower(c));
+    }
+};
+
+struct AsciiFoldEqual {
+    bool operator()(char a, char b) const {
+        return asciiLower(a) == asciiLower(b);
+    }
+};
+
+/**
+ * @brief Finds the first occurrence of a term that starts a word.
+ *
+ * @return Offset of the hit relative to begin, -1 if not found
+ */
+qint64 findWordStart(const char* begin, const char* end, const QByteArray& term) {
+    std::boyer_moore_horspool_searcher<const char*, AsciiFoldHash, AsciiFoldEqual>
+        searcher(term.constData(), term.constData() + term.size());
+
+    const char* from = begin;
+    while (from < end) {
+        const char* hit = std::search(from, end, searcher);
+        if (hit == end) {
+            return -1;
+        }
+        if (hit == begin || !isWordByte(*(hit - 1))) {
+            return hit - begin;
+        }
+        from = hit + 1;
+    }
+    return -1;
+}
+
+} // namespace
+
+/**
+ * @brief Highlights query terms, including inflected forms, in loaded text.
+ */
+class TermHighlighter : public QSyntaxHighlighter {
+public:
+    explicit TermHighlighter(QTextDocument* parent)
+        : QSyntaxHighlighter(parent) {
+        format.setBackground(QColor("#fff59d"));
+        format.setFontWeight(QFont::Bold);
+    }
+
+    void setTerms(const QStringList& terms) {
+        QStringList escaped;
+        for (const QString& term : terms) {
+            escaped << QRegularExpression::escape(term);
+        }
+
+        if (escaped.isEmpty()) {
+            pattern = QRegularExpression();
+        } else {
+            // Match at word starts so "connect" also marks "connection"
+            pattern = QRegularExpression(
+                QString("\\b(?:%1)\\w*").arg(escaped.join('|')),
+                QRegularExpression::CaseInsensitiveOption |
+                QRegularExpression::UseUnicodePropertiesOption);
+        }
+        rehighlight();
+    }
+
+protected:
+    void highlightBlock(const QString& text) override {
+        if (pattern.pattern().isEmpty()) {
+            return;
+        }
+
+        QRegularExpressionMatchIterator it = pattern.globalMatch(text);
+        while (it.hasNext()) {
+            QRegularExpressionMatch match = it.next();
+            setFormat(match.capturedStart(), match.capturedLength(), format);
+        }
+    }
+
+private:
+    QRegularExpression pattern;
+    QTextCharFormat format;
+};
+
+DocumentPreview::DocumentPreview(QWidget* parent)
+    : QPlainTextEdit(parent), mapped(nullptr), fileSize(0), loading(false) {
+    setReadOnly(true);
+    highlighter = new TermHighlighter(document());
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, &DocumentPreview::onScrolled);
+}
+
+DocumentPreview::~DocumentPreview() {
+}
+
+bool DocumentPreview::showDocument(const QString& filePath, const QStringList& terms) {
+    clearDocument();
+
+    file.setFileName(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    fileSize = file.size();
+    if (fileSize > 0) {
+        // Falls back to seek/read when the file system does not support mapping
+        mapped = file.map(0, fileSize);
+    }
+    return showFirstChunk(terms);
+}
+
+bool DocumentPreview::showDocument(qint64 size, TextReader textReader, const QStringList& terms) {
+    clearDocument();
+    if (!textReader) {
+        return false;
+    }
+
+    reader = std::move(textReader);
+    fileSize = size;
+    return showFirstChunk(terms);
+}
+
+bool DocumentPreview::showFirstChunk(const QStringList& terms) {
+    highlightTerms = terms;
+    highlighter->setTerms(terms);
+
+    if (fileSize == 0) {
+        return true;
+    }
+
+    qint64 hit = findFirstHit();
+    qint64 begin = 0;
+    if (hit > 0) {
+        // Start the first chunk about a quarter chunk before the hit for context
+        begin = chunkBeginBefore(std::max<qint64>(hit - ChunkSize / 4, 0) + ChunkSize);
+    }
+
+    Chunk first{begin, chunkEndFrom(begin), 0};
+    QString text = chunkText(first);
+
+    loading = true;
+    setPlainText(text);
+    chunks.push_back(first);
+    loading = false;
+
+    if (hit >= 0 && hit < first.end) {
+        QString prefix = QString::fromUtf8(readBytes(begin, hit - begin));
+        prefix.remove(QLatin1Char('\r'));
+
+        QTextCursor cursor(document());
+        cursor.setPosition(prefix.size());
+        setTextCursor(cursor);
+        centerCursor();
+    } else {
+        moveCursor(QTextCursor::Start);
+    }
+
+    return true;
+}
+
+void DocumentPreview::clearDocument() {
+    loading = true;
+    clear();
+    loading = false;
+
+    chunks.clear();
+    highlightTerms.clear();
+    if (file.isOpen()) {
+        if (mapped) {
+            file.unmap(mapped);
+        }
+        file.close();
+    }
+    mapped = nullptr;
+    reader = nullptr;
+    fileSize = 0;
+}
+
+void DocumentPreview::onScrolled(int value) {
+    if (loading || chunks.empty()) {
+        return;
+    }
+
+    QScrollBar* bar = verticalScrollBar();
+    if (value >= bar->maximum() - bar->pageStep() && chunks.back().end < fileSize) {
+        appendChunk();
+        if (chunks.size() > MaxLoadedChunks) {
+            dropFrontChunk();
+        }
+    } else if (value <= bar->pageStep() && chunks.front().begin > 0) {
+        prependChunk();
+        if (chunks.size() > MaxLoadedChunks) {
+            dropBackChunk();
+        }
+    }
+}
+
+QByteArray DocumentPreview::readBytes(qint64 offset, qint64 length) {
+    length = std::min(length, fileSize - offset);
+    if (length <= 0) {
+        return QByteArray();
+    }
+
+    if (mapped) {
+        return QByteArray(reinterpret_cast<const char*>(mapped + offset), static_cast<int>(length));
+    }
+    if (reader) {
+        return reader(offset, length);
+    }
+
+    file.seek(offset);
+    return file.read(length);
+}
+
+qint64 DocumentPreview::findFirstHit() {
+    QList<QByteArray> needles;
+    int longest = 0;
+    for (const QString& term : highlightTerms) {
+        QByteArray needle = term.toUtf8();
+        if (!needle.isEmpty()) {
+            longest = std::max(longest, static_cast<int>(needle.size()));
+            needles << needle;
+        }
+    }
+    if (needles.isEmpty()) {
+        return -1;
+    }
+
+    qint64 best = -1;
+    if (mapped) {
+        const char* begin = reinterpret_cast<const char*>(mapped);
+        for (const QByteArray& needle : needles) {
+            // Only look for hits that start before the best one found so far
+            qint64 limit = best >= 0 ? std::min<qint64>(best + needle.size(), fileSize) : fileSize;
+            qint64 hit = findWordStart(begin, begin + limit, needle);
+            if (hit >= 0 && (best < 0 || hit < best)) {
+                best = hit;
+            }
+        }
+        return best;
+    }
+
+    // Scan in blocks, overlapping by the longest term so no hit straddles a boundary
+    for (qint64 offset = 0; offset < fileSize; offset += ScanBlockSize) {
+        qint64 lead = std::min<qint64>(offset, longest);
+        QByteArray block = readBytes(offset - lead, ScanBlockSize + lead);
+        const char* begin = block.constData();
+        const char* end = begin + block.size();
+
+        for (const QByteArray& needle : needles) {
+            qint64 hit = findWordStart(begin, end, needle);
+            if (hit >= 0 && (best < 0 || offset - lead + hit < best)) {
+                best = offset - lead + hit;
+            }
+        }
+        if (best >= 0) {
+            return best;
+        }
+    }
+    return -1;
+}
+
+qint64 DocumentPreview::chunkEndFrom(qint64 begin) {
+    qint64 end = std::min(begin + ChunkSize, fileSize);
+    if (end >= fileSize) {
+        return fileSize;
+    }
+
+    // Extend to the end of the current line, within one more chunk
+    QByteArray tail = readBytes(end, ChunkSize);
+    int newline = tail.indexOf('\n');
+    if (newline >= 0) {
+        return end + newline + 1;
+    }
+
+    // Very long line: cut it, but never inside a UTF-8 sequence
+    QByteArray head = readBytes(begin, end - begin + 1);
+    while (end > begin && (static_cast<unsigned char>(head[static_cast<int>(end - begin)]) & 0xC0) == 0x80) {
+        --end;
+    }
+    return end;
+}
+
+qint64 DocumentPreview::chunkBeginBefore(qint64 end) {
+    qint64 begin = std::max<qint64>(end - ChunkSize, 0);
+    if (begin == 0) {
+        return 0;
+    }
+
+    // Move back to the start of the line, within a quarter chunk
+    qint64 lookBack = std::min<qint64>(begin, ChunkSize / 4);
+    QByteArray head = readBytes(begin - lookBack, lookBack);
+    int newline = head.lastIndexOf('\n');
+    if (newline >= 0) {
+        return begin - lookBack + newline + 1;
+    }
+
+    // No line start nearby: skip UTF-8 continuation bytes instead
+    QByteArray at = readBytes(begin, 4);
+    int skip = 0;
+    while (skip < at.size() && (static_cast<unsigned char>(at[skip]) & 0xC0) == 0x80) {
+        ++skip;
+    }
+    return begin + skip;
+}
+
+QString DocumentPreview::chunkText(Chunk& chunk) {
+    QString text = QString::fromUtf8(readBytes(chunk.begin, chunk.end - chunk.begin));
+    text.remove(QLatin1Char('\r'));
+    // Every chunk occupies whole editor lines so chunks can be dropped by line count
+    if (!text.endsWith(QLatin1Char('\n'))) {
+        text += QLatin1Char('\n');
+    }
+    chunk.lineCount = text.count(QLatin1Char('\n'));
+    return text;
+}
+
+void DocumentPreview::appendChunk() {
+    Chunk next{chunks.back().end, chunkEndFrom(chunks.back().end), 0};
+    QString text = chunkText(next);
+
+    loading = true;
+    QTextCursor cursor(document());
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText(text);
+    chunks.push_back(next);
+    loading = false;
+}
+
+void DocumentPreview::prependChunk() {
+    Chunk previous{chunkBeginBefore(chunks.front().begin), chunks.front().begin, 0};
+    QString text = chunkText(previous);
+
+    loading = true;
+    int value = verticalScrollBar()->value();
+    QTextCursor cursor(document());
+    cursor.movePosition(QTextCursor::Start);
+    cursor.insertText(text);
+    chunks.push_front(previous);
+    // Keep the same lines in view after the inserted text pushed them down
+    verticalScrollBar()->setValue(value + previous.lineCount);
+    loading = false;
+}
+
+void DocumentPreview::dropFrontChunk() {
+    Chunk front = chunks.front();
+
+    loading = true;
+    int value = verticalScrollBar()->value();
+    QTextCursor cursor(document());
+    cursor.movePosition(QTextCursor::Start);
+    cursor.movePosition(QTextCursor::NextBlock, QTextCursor::KeepAnchor, front.lineCount);
+    cursor.removeSelectedText();
+    chunks.pop_front();
+    verticalScrollBar()->setValue(std::max(0, value - front.lineCount));
+    loading = false;
+}
+
+void DocumentPreview::dropBackChunk() {
+    int firstLine = 0;
+    for (size_t i = 0; i + 1 < chunks.size(); ++i) {
+        firstLine += chunks[i].lineCount;
+    }
+
+    loading = true;
+    QTextCursor cursor(document()->findBlockByNumber(firstLine));
+    cursor.movePosition(QTextCursor::End, QTextCursor::KeepAnchor);
+    cursor.removeSelectedText();
+    chunks.pop_back();
+    loading = false;
+}
@@ -1,19 +1,50 @@
 #include "gui/MainWindow.h"
-#include <QFile>
-#include <QTextStream>
 #include <QScrollBar>
 #include <QApplication>
 #include <QHeaderView>
+#include <QStandardPaths>
+#include <QDir>
+#include <QFile>
 #include <sstream>
 #include <iomanip>
 
+namespace {
+
+// Interactive searches stop after this long and show the best hits found by then
+const SearchBudget InteractiveSearchBudget(std::chrono::milliseconds(250), 0);
+
+// Number of related documents listed by "More Like This"
+constexpr size_t MoreLikeThisResults = 50;
+
+} // namespace
+
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent) {
+    // Index word stems so a query also finds inflected forms of its words
+    searchEngine.setStemming(true);
+    
+    // Show one hit per group of near-identical files (rotated logs, drafts)
+    searchEngine.setCollapseDuplicates(true);
+    
+    // Previews and snippets read the indexed text from a local compressed store
+    QString storeDirectory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (!storeDirectory.isEmpty() && QDir().mkpath(storeDirectory)) {
+        documentStorePath = QDir(storeDirectory).filePath(
+            QString("documents-%1.store").arg(QCoreApplication::applicationPid()));
+        if (!searchEngine.setDocumentStore(documentStorePath.toStdString())) {
+            documentStorePath.clear();
+        }
+    }
+    
     setupUI();
     updateStatus("Ready. Load documents to begin searching.");
 }
 
 MainWindow::~MainWindow() {
+    if (!documentStorePath.isEmpty()) {
+        searchEngine.setDocumentStore("");
+        QFile::remove(documentStorePath);
+    }
 }
 
 void MainWindow::setupUI() {
@@ -46,13 +77,17 @@ void MainWindow::setupUI() {
     buttonLayout = new QHBoxLayout();
     loadFilesButton = new QPushButton("Load Files", this);
     clearIndexButton = new QPushButton("Clear Index", this);
+    moreLikeThisButton = new QPushButton("More Like This", this);
+    moreLikeThisButton->setEnabled(false);
     
     buttonLayout->addWidget(loadFilesButton);
     buttonLayout->addWidget(clearIndexButton);
+    buttonLayout->addWidget(moreLikeThisButton);
     buttonLayout->addStretch();
     
     connect(loadFilesButton, &QPushButton::clicked, this, &MainWindow::onLoadFilesClicked);
     connect(clearIndexButton, &QPushButton::clicked, this, &MainWindow::onClearIndexClicked);
+    connect(moreLikeThisButton, &QPushButton::clicked, this, &MainWindow::onMoreLikeThisClicked);
     
     mainLayout->addLayout(buttonLayout);
     
@@ -65,14 +100,21 @@ void MainWindow::setupUI() {
     QHBoxLayout* contentLayout = new QHBoxLayout();
     
     // Results list
-    resultsList = new QListWidget(this);
+    resultsModel = new ResultListModel(this);
+    resultsModel->setDocumentResolver([this](uint32_t docId) {
+        return searchEngine.getDocument(docId);
+    });
+    resultsList = new QListView(this);
+    resultsList->setModel(resultsModel);
+    // All rows have the same four-line layout, so the view never needs to
+    // measure off-screen rows
+    resultsList->setUniformItemSizes(true);
     resultsList->setMinimumWidth(400);
     resultsList->setMaximumWidth(500);
-    connect(resultsList, &QListWidget::itemClicked, this, &MainWindow::onResultSelected);
+    connect(resultsList, &QListView::clicked, this, &MainWindow::onResultSelected);
     
     // Document preview
-    documentPreview = new QTextEdit(this);
-    documentPreview->setReadOnly(true);
+    documentPreview = new DocumentPreview(this);
     documentPreview->setPlaceholderText("Select a result to preview document content...");
     
     contentLayout->addWidget(resultsList);
@@ -112,18 +154,18 @@ void MainWindow::setupUI() {
         "  font-size: 12pt; "
         "}"
         "QLineEdit:focus { border: 2px solid #4CAF50; }"
-        "QListWidget { "
+        "QListView { "
         "  border: 1px solid #ddd; "
         "  border-radius: 4px; "
         "  background-color: white; "
         "}"
-        "QListWidget::item { "
+        "QListView::item { "
         "  padding: 8px; "
         "  border-bottom: 1px solid #eee; "
         "}"
-        "QListWidget::item:hover { background-color: #f0f0f0; }"
-        "QListWidget::item:selected { background-color: #e3f2fd; }"
-        "QTextEdit { "
+        "QListView::item:hover { background-color: #f0f0f0; }"
+        "QListView::item:selected { background-color: #e3f2fd; }"
+        "QPlainTextEdit { "
         "  border: 1px solid #ddd; "
         "  border-radius: 4px; "
         "  background-color: white; "
@@ -148,13 +190,35 @@ void MainWindow::onSearchClicked() {
     updateStatus("Searching...");
     QApplication::processEvents();
     
-    std::vector<SearchResult> results = searchEngine.search(query.toStdString());
+    // Stems need not prefix the words they match ("happi" for "happy"), so
+    // highlight the query words as typed too
+    currentQueryTerms.clear();
+    for (const auto& term : searchEngine.getQueryTerms(query.toStdString())) {
+        currentQueryTerms << QString::fromStdString(term);
+    }
+    for (const auto& word : searchEngine.getQueryWords(query.toStdString())) {
+        currentQueryTerms << QString::fromStdString(word);
+    }
+    currentQueryTerms.removeDuplicates();
+    
+    std::string queryText = query.toStdString();
+    bool partial = false;
+    std::vector<SearchResult> results = searchEngine.search(queryText, 0, InteractiveSearchBudget, partial);
+    size_t resultCount = results.size();
+    
+    resultsModel->setSnippetProvider(
+        [this, queryText](const std::vector<SearchResult>& all, size_t offset, size_t count) {
+            return searchEngine.getSnippets(queryText, all, offset, count);
+        });
     
-    displayResults(results);
+    displayResults(std::move(results));
     
     QString statusMsg = QString("Found %1 result(s) for '%2'")
-                       .arg(results.size())
+                       .arg(resultCount)
                        .arg(query);
+    if (partial) {
+        statusMsg += " (search time limit reached, showing the best matches found)";
+    }
     updateStatus(statusMsg);
 }
 
@@ -183,6 +247,17 @@ void MainWindow::onLoadFilesClicked() {
     
     int indexed = searchEngine.indexDocuments(paths);
     
+    // Put the highest ranked documents first, clustering similar ones within
+    // each rank tier; this renumbers them, so drop shown results
+    if (indexed > 0) {
+        updateStatus("Optimizing index...");
+        QApplication::processEvents();
+        searchEngine.reorderDocuments(DocumentOrder::StaticRank);
+        resultsModel->clear();
+        documentPreview->clearDocument();
+        moreLikeThisButton->setEnabled(false);
+    }
+    
     progressBar->setValue(filePaths.size());
     progressBar->setVisible(false);
     
@@ -212,22 +287,51 @@ void MainWindow::onClearIndexClicked() {
     
     if (ret == QMessageBox::Yes) {
         searchEngine.clear();
-        resultsList->clear();
-        documentPreview->clear();
+        resultsModel->clear();
+        documentPreview->clearDocument();
+        moreLikeThisButton->setEnabled(false);
         updateStatus("Index cleared. Ready to load new documents.");
     }
 }
 
-void MainWindow::onResultSelected(QListWidgetItem* item) {
-    if (!item) {
+void MainWindow::onResultSelected(const QModelIndex& index) {
+    if (!index.isValid()) {
+        return;
+    }
+    
+    const SearchResult* result = resultsModel->resultAt(index.row());
+    if (result) {
+        displayDocumentPreview(result->docId);
+        moreLikeThisButton->setEnabled(true);
+    }
+}
+
+void MainWindow::onMoreLikeThisClicked() {
+    const SearchResult* result = resultsModel->resultAt(resultsList->currentIndex().row());
+    if (!result) {
         return;
     }
     
-    // Extract file path from item data
-    QString filePath = item->data(Qt::UserRole).toString();
-    if (!filePath.isEmpty()) {
-        displayDocumentPreview(filePath);
+    uint32_t docId = result->docId;
+    std::shared_ptr<Document> document = searchEngine.getDocument(docId);
+    if (!document) {
+        return;
     }
+    
+    updateStatus("Finding similar documents...");
+    QApplication::processEvents();
+    
+    // Related documents are not tied to a query: nothing to highlight or excerpt
+    currentQueryTerms.clear();
+    resultsModel->setSnippetProvider(nullptr);
+    
+    std::vector<SearchResult> results = searchEngine.findSimilar(docId, MoreLikeThisResults);
+    size_t resultCount = results.size();
+    displayResults(std::move(results));
+    
+    updateStatus(QString("Found %1 document(s) similar to '%2'")
+                 .arg(resultCount)
+                 .arg(QString::fromStdString(document->fileName)));
 }
 
 void MainWindow::updateStatus(const QString& message) {
@@ -235,48 +339,38 @@ void MainWindow::updateStatus(const QString& message) {
     statusBar()->showMessage(message, 5000);
 }
 
-void MainWindow::displayResults(const std::vector<SearchResult>& results) {
-    resultsList->clear();
-    documentPreview->clear();
+void MainWindow::displayResults(std::vector<SearchResult> results) {
+    documentPreview->clearDocument();
+    moreLikeThisButton->setEnabled(false);
     
     if (results.empty()) {
+        resultsModel->clear();
         resultsLabel->setText("Results: No matches found.");
         return;
     }
     
     resultsLabel->setText(QString("Results: %1 match(es)").arg(results.size()));
-    
-    for (const auto& result : results) {
-        QString formatted = formatResult(result);
-        QListWidgetItem* item = new QListWidgetItem(formatted, resultsList);
-        item->setData(Qt::UserRole, QString::fromStdString(result.document->filePath));
-        resultsList->addItem(item);
-    }
-}
-
-QString MainWindow::formatResult(const SearchResult& result) {
-    QString fileName = QString::fromStdString(result.document->fileName);
-    QString score = QString::number(result.score, 'f', 4);
-    QString filePath = QString::fromStdString(result.document->filePath);
-    
-    return QString("%1\nScore: %2\n%3")
-           .arg(fileName)
-           .arg(score)
-           .arg(filePath);
+    resultsModel->setResults(std::move(results));
+    resultsList->scrollToTop();
 }
 
-void MainWindow::displayDocumentPreview(const QString& filePath) {
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        documentPreview->setPlainText("Error: Could not read file.");
-        return;
+void MainWindow::displayDocumentPreview(uint32_t docId) {
+    std::shared_ptr<Document> document = searchEngine.getDocument(docId);
+    bool shown = false;
+    if (document && searchEngine.isDocumentStored(docId)) {
+        DocumentPreview::TextReader reader = [this, docId](qint64 offset, qint64 length) {
+            std::string text = searchEngine.readDocumentText(docId, static_cast<size_t>(offset),
+                                                             static_cast<size_t>(length));
+            return QByteArray(text.data(), static_cast<int>(text.size()));
+        };
+        shown = documentPreview->showDocument(static_cast<qint64>(document->textSize), reader,
+                                              currentQueryTerms);
+    } else if (document) {
+        shown = documentPreview->showDocument(QString::fromStdString(document->filePath),
+                                              currentQueryTerms);
     }
     
-    QTextStream in(&file);
-    QString content = in.readAll();
-    file.close();
-    
-    documentPreview->setPlainText(content);
-    documentPreview->moveCursor(QTextCursor::Start);
+    if (!shown) {
+        documentPreview->setPlainText("Error: Could not read file.");
+    }
 }
-
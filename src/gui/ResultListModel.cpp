@@ -0,0 +1,130 @@
+#include "gui/ResultListModel.h"
+#include <algorithm>
+
+ResultListModel::ResultListModel(QObject* parent)
+    : QAbstractListModel(parent), loadedRows(0), pageSize(200) {
+}
+
+void ResultListModel::setResults(std::vector<SearchResult> newResults) {
+    beginResetModel();
+    results = std::move(newResults);
+    rows.clear();
+    loadedRows = static_cast<int>(std::min<size_t>(results.size(), pageSize));
+    loadRows(0, loadedRows);
+    endResetModel();
+}
+
+void ResultListModel::setSnippetProvider(SnippetProvider provider) {
+    snippetProvider = std::move(provider);
+}
+
+void ResultListModel::setDocumentResolver(DocumentResolver resolver) {
+    documentResolver = std::move(resolver);
+}
+
+void ResultListModel::clear() {
+    beginResetModel();
+    results.clear();
+    rows.clear();
+    loadedRows = 0;
+    endResetModel();
+}
+
+size_t ResultListModel::getTotalCount() const {
+    return results.size();
+}
+
+const SearchResult* ResultListModel::resultAt(int row) const {
+    if (row < 0 || row >= loadedRows) {
+        return nullptr;
+    }
+    return &results[row];
+}
+
+void ResultListModel::setPageSize(int size) {
+    pageSize = std::max(1, size);
+}
+
+int ResultListModel::rowCount(const QModelIndex& parent) const {
+    // Flat list: only the invisible root has children
+    if (parent.isValid()) {
+        return 0;
+    }
+    return loadedRows;
+}
+
+QVariant ResultListModel::data(const QModelIndex& index, int role) const {
+    const SearchResult* result = resultAt(index.row());
+    if (!index.isValid() || !result) {
+        return QVariant();
+    }
+
+    switch (role) {
+        case Qt::DisplayRole:
+            return formatResult(index.row());
+        case Qt::ToolTipRole:
+        case Qt::UserRole:
+            return rows[index.row()].filePath;
+        default:
+            return QVariant();
+    }
+}
+
+bool ResultListModel::canFetchMore(const QModelIndex& parent) const {
+    if (parent.isValid()) {
+        return false;
+    }
+    return static_cast<size_t>(loadedRows) < results.size();
+}
+
+void ResultListModel::fetchMore(const QModelIndex& parent) {
+    if (parent.isValid()) {
+        return;
+    }
+
+    int remaining = static_cast<int>(results.size()) - loadedRows;
+    int toFetch = std::min(pageSize, remaining);
+    if (toFetch <= 0) {
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), loadedRows, loadedRows + toFetch - 1);
+    loadRows(loadedRows, toFetch);
+    loadedRows += toFetch;
+    endInsertRows();
+}
+
+void ResultListModel::loadRows(int first, int count) {
+    rows.resize(static_cast<size_t>(first + count));
+    if (count <= 0) {
+        return;
+    }
+
+    if (documentResolver) {
+        for (int row = first; row < first + count; ++row) {
+            std::shared_ptr<Document> document = documentResolver(results[row].docId);
+            if (document) {
+                rows[row].fileName = QString::fromStdString(document->fileName);
+                rows[row].filePath = QString::fromStdString(document->filePath);
+            }
+        }
+    }
+
+    if (snippetProvider) {
+        std::vector<std::string> page = snippetProvider(results, first, count);
+        for (size_t i = 0; i < page.size() && i < static_cast<size_t>(count); ++i) {
+            rows[first + i].snippet = QString::fromStdString(page[i]);
+        }
+    }
+}
+
+QString ResultListModel::formatResult(int row) const {
+    const Row& display = rows[row];
+    QString score = QString::number(results[row].score, 'f', 4);
+
+    return QString("%1\nScore: %2\n%3\n%4")
+           .arg(display.fileName)
+           .arg(score)
+           .arg(display.filePath)
+           .arg(display.snippet);
+}
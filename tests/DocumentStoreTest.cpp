@@ -0,0 +1,166 @@
+#include "core/DocumentStore.h"
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+/*
+ * Stores documents of various sizes and compressibility, reads them back
+ * at random offsets and lengths, and checks that malformed encodings are
+ * rejected by add() and corrupted blocks by read().
+ */
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << std::endl;
+        failures++;
+    }
+}
+
+/**
+ * @brief Text of words from a small vocabulary, so it compresses well.
+ */
+std::string makeText(std::mt19937& random, size_t size) {
+    static const char* const words[] = {"connection", "reset", "timeout", "server", "request",
+                                        "error", "retry", "the", "of", "cache", "\n"};
+    std::string text;
+    while (text.size() < size) {
+        text += words[random() % (sizeof(words) / sizeof(words[0]))];
+        text += ' ';
+    }
+    text.resize(size);
+    return text;
+}
+
+/**
+ * @brief Random bytes, which do not compress and are stored raw.
+ */
+std::string makeNoise(std::mt19937& random, size_t size) {
+    std::string text(size, '\0');
+    for (char& c : text) {
+        c = static_cast<char>(random() % 256);
+    }
+    return text;
+}
+
+std::pmr::string encode(const std::string& text) {
+    std::pmr::string encoded;
+    DocumentStore::encode(text, encoded);
+    return encoded;
+}
+
+void testRoundTrips(DocumentStore& store, std::mt19937& random) {
+    const size_t B = DocumentStore::BlockSize;
+    std::vector<size_t> sizes = {0, 1, 100, B - 1, B, B + 1, 2 * B, 3 * B + 17, 10 * B + 5};
+    std::vector<std::string> texts;
+    for (size_t size : sizes) {
+        texts.push_back(makeText(random, size));
+        texts.push_back(makeNoise(random, size));
+    }
+    // A document mixing compressible and incompressible blocks
+    texts.push_back(makeText(random, B) + makeNoise(random, B) + makeText(random, B / 2));
+
+    for (uint32_t docId = 0; docId < texts.size(); ++docId) {
+        check(store.add(docId, encode(texts[docId])), "add document " + std::to_string(docId));
+    }
+
+    std::string text;
+    for (uint32_t docId = 0; docId < texts.size(); ++docId) {
+        const std::string& expected = texts[docId];
+        check(store.contains(docId), "contains document " + std::to_string(docId));
+        check(store.read(docId, 0, expected.size() + 10, text) && text == expected,
+              "read whole document " + std::to_string(docId));
+    }
+
+    for (int round = 0; round < 3000; ++round) {
+        uint32_t docId = static_cast<uint32_t>(random() % texts.size());
+        const std::string& expected = texts[docId];
+        size_t offset = random() % (expected.size() + 2 * B + 1);
+        size_t length = random() % (3 * B);
+        bool succeeded = store.read(docId, offset, length, text);
+        std::string wanted = offset < expected.size() ? expected.substr(offset, length) : std::string();
+        check(succeeded && text == wanted, "read document " + std::to_string(docId) + " at " +
+                                          std::to_string(offset) + "+" + std::to_string(length));
+    }
+
+    uint32_t unknown = static_cast<uint32_t>(texts.size()) + 5;
+    check(!store.contains(unknown), "unknown document is not contained");
+    check(!store.read(unknown, 0, 10, text) && text.empty(), "reading an unknown document fails");
+}
+
+void testMalformed(DocumentStore& store, std::mt19937& random) {
+    const size_t B = DocumentStore::BlockSize;
+    std::pmr::string encoded = encode(makeText(random, 2 * B + 100));
+    uint64_t storedBytes = store.getStoredBytes();
+
+    for (size_t length = 1; length < 9; ++length) {
+        check(!store.add(1000, std::string_view(encoded.data(), length)), "truncated block header");
+    }
+    check(!store.add(1000, std::string_view(encoded.data(), encoded.size() - 1)), "truncated block");
+
+    // Header fields: u8 compressed flag, u32 raw size, u32 stored size
+    std::pmr::string oversized = encoded;
+    oversized[1] = '\x01';
+    oversized[2] = '\x40';
+    oversized[3] = '\x01'; // raw size beyond BlockSize
+    check(!store.add(1000, oversized), "block larger than BlockSize");
+
+    std::pmr::string raw = encode(makeNoise(random, 100));
+    raw[5] = static_cast<char>(raw[5] - 1); // raw block whose stored size differs from its raw size
+    check(!store.add(1000, raw), "raw block with mismatched sizes");
+
+    std::pmr::string shortFirst = encode(makeText(random, 100));
+    shortFirst += encode(makeText(random, B));
+    check(!store.add(1000, shortFirst), "short block before the last one");
+
+    check(!store.contains(1000) && store.getStoredBytes() == storedBytes,
+          "rejected input leaves the store unchanged");
+
+    // Corrupted compressed data is only found when read; it must fail, not overrun
+    std::string expected = makeText(random, 3 * B);
+    std::string text;
+    for (uint32_t round = 0; round < 300; ++round) {
+        std::pmr::string corrupted = encode(expected);
+        int flips = 1 + random() % 8;
+        for (int i = 0; i < flips; ++i) {
+            // Leave the first header alone so add() accepts the data
+            size_t at = 9 + random() % (corrupted.size() - 9);
+            corrupted[at] = static_cast<char>(random() % 256);
+        }
+        uint32_t docId = 2000 + round;
+        if (store.add(docId, corrupted)) {
+            bool succeeded = store.read(docId, random() % expected.size(), B, text);
+            check(!succeeded || text.size() <= B, "corrupted block read stays in bounds");
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    std::string path = (std::filesystem::temp_directory_path() / "DocumentStoreTest.store").string();
+    DocumentStore store;
+    if (!store.open(path)) {
+        std::cerr << "Cannot create " << path << std::endl;
+        return 1;
+    }
+
+    std::mt19937 random(42);
+    testRoundTrips(store, random);
+    testMalformed(store, random);
+    store.close();
+    std::remove(path.c_str());
+
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "DocumentStore tests passed" << std::endl;
+    return 0;
+}
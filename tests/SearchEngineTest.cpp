@@ -0,0 +1,91 @@
+#include "core/SearchEngine.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+/*
+ * Indexes a few small documents and checks which of them queries match.
+ */
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << std::endl;
+        failures++;
+    }
+}
+
+/**
+ * @brief Gets the file names of the documents a query matches.
+ */
+std::set<std::string> matches(const SearchEngine& engine, const std::string& query) {
+    std::set<std::string> names;
+    for (const auto& result : engine.search(query)) {
+        names.insert(engine.getDocument(result.docId)->fileName);
+    }
+    return names;
+}
+
+void testIdeographWords(const SearchEngine& engine) {
+    const std::set<std::string> tokyo = {"tokyo.txt"};
+    check(matches(engine, "東京") == tokyo, "unquoted 東京 matches only the document containing it");
+    check(matches(engine, "\"東京\"") == tokyo, "quoted 東京 matches only the document containing it");
+    check(matches(engine, "京都").count("tokyo.txt") == 0, "京都 does not match 東京");
+    check(matches(engine, "東京 NEAR/3 駅") == tokyo, "ideograph words in a NEAR window");
+    check(matches(engine, "東京 NEAR/3 寺").empty(), "NEAR requires the whole ideograph word");
+    check(matches(engine, "東京~") == tokyo, "fuzzy ideograph word matches as a phrase");
+}
+
+void testPunctuationSplits(const SearchEngine& engine) {
+    const std::set<std::string> either = {"connection.txt", "reset.txt"};
+    check(matches(engine, "connection-reset") == either, "a word split by punctuation matches any part");
+}
+
+void testFuzzyCharacters(const SearchEngine& engine) {
+    // One substituted character, however many bytes it takes in UTF-8
+    check(matches(engine, "cafe~").count("cafe.txt") == 1, "cafe~ matches café");
+    check(matches(engine, "naïf~").count("cafe.txt") == 1, "naïf~ matches naif");
+}
+
+} // namespace
+
+int main() {
+    namespace fs = std::filesystem;
+    fs::path directory = fs::temp_directory_path() / "SearchEngineTest";
+    fs::create_directories(directory);
+
+    const std::vector<std::pair<std::string, std::string>> documents = {
+        {"kyoto.txt", "京都の寺"},
+        {"east.txt", "東の空"},
+        {"tokyo.txt", "東京の駅"},
+        {"connection.txt", "the connection timed out"},
+        {"reset.txt", "a reset was requested"},
+        {"cafe.txt", "un café noir et un garçon naif"},
+    };
+    std::vector<std::string> filePaths;
+    for (const auto& document : documents) {
+        fs::path filePath = directory / document.first;
+        std::ofstream(filePath, std::ios::binary) << document.second;
+        filePaths.push_back(filePath.string());
+    }
+
+    SearchEngine engine;
+    check(engine.indexDocuments(filePaths) == static_cast<int>(filePaths.size()), "index documents");
+    testIdeographWords(engine);
+    testPunctuationSplits(engine);
+    testFuzzyCharacters(engine);
+    fs::remove_all(directory);
+
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "SearchEngine tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,245 @@
+#include "core/ShardProtocol.h"
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+/*
+ * Round trips every message type through its decoder, then checks that
+ * truncated, extended, mistyped and corrupted messages and frames are
+ * rejected (or at least decoded without reading out of bounds).
+ */
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << std::endl;
+        failures++;
+    }
+}
+
+std::string randomString(std::mt19937& random, size_t maxLength) {
+    std::string text(random() % (maxLength + 1), '\0');
+    for (char& c : text) {
+        c = static_cast<char>(random() % 256);
+    }
+    return text;
+}
+
+GlobalStatistics randomStatistics(std::mt19937& random) {
+    GlobalStatistics stats;
+    stats.collection.documentCount = (static_cast<uint64_t>(random()) << 32) | random();
+    stats.collection.totalTerms = (static_cast<uint64_t>(random()) << 32) | random();
+    size_t terms = random() % 8;
+    for (size_t i = 0; i < terms; ++i) {
+        stats.documentFrequencies[randomString(random, 12)] = random();
+    }
+    return stats;
+}
+
+bool sameStatistics(const GlobalStatistics& a, const GlobalStatistics& b) {
+    return a.collection.documentCount == b.collection.documentCount &&
+           a.collection.totalTerms == b.collection.totalTerms &&
+           a.documentFrequencies == b.documentFrequencies;
+}
+
+/**
+ * @brief Runs every decoder on a message; decoding garbage must fail cleanly, not crash.
+ *
+ * @return Number of decoders that accepted the message
+ */
+int decodeAll(const std::string& message) {
+    std::string query;
+    size_t maxResults = 0;
+    GlobalStatistics stats;
+    std::vector<ShardHit> hits;
+    std::vector<uint32_t> docIds;
+    std::vector<std::string> filePaths;
+    return ShardProtocol::decodeStatisticsRequest(message, query) +
+           ShardProtocol::decodeStatisticsResponse(message, stats) +
+           ShardProtocol::decodeSearchRequest(message, query, maxResults, stats) +
+           ShardProtocol::decodeSearchResponse(message, hits) +
+           ShardProtocol::decodeDocumentsRequest(message, docIds) +
+           ShardProtocol::decodeDocumentsResponse(message, filePaths);
+}
+
+/**
+ * @brief Checks that only the whole message decodes: no prefix and no extension of it does.
+ */
+void checkBounds(const std::string& message, const std::string& name) {
+    for (size_t length = 0; length < message.size(); ++length) {
+        check(decodeAll(message.substr(0, length)) == 0, name + " truncated to " + std::to_string(length));
+    }
+    check(decodeAll(message + '\0') == 0, name + " with a trailing byte");
+    check(decodeAll(message) == 1, name + " decodes as exactly one type");
+}
+
+void testRoundTrips(std::mt19937& random) {
+    for (int round = 0; round < 200; ++round) {
+        std::string query = randomString(random, 40);
+        GlobalStatistics stats = randomStatistics(random);
+        size_t maxResults = random() % 1000;
+
+        std::string decodedQuery;
+        std::string message = ShardProtocol::encodeStatisticsRequest(query);
+        check(ShardProtocol::decodeStatisticsRequest(message, decodedQuery) && decodedQuery == query,
+              "statistics request round trip");
+        checkBounds(message, "statistics request");
+
+        GlobalStatistics decodedStats;
+        message = ShardProtocol::encodeStatisticsResponse(stats);
+        check(ShardProtocol::decodeStatisticsResponse(message, decodedStats) && sameStatistics(decodedStats, stats),
+              "statistics response round trip");
+        checkBounds(message, "statistics response");
+
+        size_t decodedMax = 0;
+        message = ShardProtocol::encodeSearchRequest(query, maxResults, stats);
+        check(ShardProtocol::decodeSearchRequest(message, decodedQuery, decodedMax, decodedStats) &&
+                  decodedQuery == query && decodedMax == maxResults && sameStatistics(decodedStats, stats),
+              "search request round trip");
+        checkBounds(message, "search request");
+
+        std::vector<ShardHit> hits(random() % 20);
+        for (auto& hit : hits) {
+            hit.docId = random();
+            hit.score = static_cast<float>(random()) / 1000.0f;
+        }
+        std::vector<ShardHit> decodedHits;
+        message = ShardProtocol::encodeSearchResponse(hits);
+        bool same = ShardProtocol::decodeSearchResponse(message, decodedHits) && decodedHits.size() == hits.size();
+        for (size_t i = 0; same && i < hits.size(); ++i) {
+            same = decodedHits[i].docId == hits[i].docId && decodedHits[i].score == hits[i].score;
+        }
+        check(same, "search response round trip");
+        checkBounds(message, "search response");
+
+        std::vector<uint32_t> docIds(random() % 20);
+        for (auto& docId : docIds) {
+            docId = random();
+        }
+        std::vector<uint32_t> decodedIds;
+        message = ShardProtocol::encodeDocumentsRequest(docIds);
+        check(ShardProtocol::decodeDocumentsRequest(message, decodedIds) && decodedIds == docIds,
+              "documents request round trip");
+        checkBounds(message, "documents request");
+
+        std::vector<std::string> filePaths(random() % 10);
+        for (auto& filePath : filePaths) {
+            filePath = randomString(random, 30);
+        }
+        std::vector<std::string> decodedPaths;
+        message = ShardProtocol::encodeDocumentsResponse(filePaths);
+        check(ShardProtocol::decodeDocumentsResponse(message, decodedPaths) && decodedPaths == filePaths,
+              "documents response round trip");
+        checkBounds(message, "documents response");
+    }
+
+    ShardProtocol::MessageType type;
+    check(ShardProtocol::getMessageType(ShardProtocol::encodeShutdown(), type) &&
+              type == ShardProtocol::MessageType::Shutdown,
+          "shutdown message type");
+    check(!ShardProtocol::getMessageType(std::string(), type), "empty message has no type");
+    check(!ShardProtocol::getMessageType(std::string(1, '\x7f'), type), "unknown message type");
+}
+
+void testOversizedCounts() {
+    // Counts and lengths far beyond the message must fail without allocating for them
+    std::string hits = ShardProtocol::encodeSearchResponse({});
+    hits.replace(1, 4, "\xff\xff\xff\xff");
+    std::vector<ShardHit> decodedHits;
+    check(!ShardProtocol::decodeSearchResponse(hits, decodedHits), "search response with oversized count");
+
+    std::string request = ShardProtocol::encodeStatisticsRequest("query");
+    request.replace(1, 4, "\xff\xff\xff\x7f");
+    std::string query;
+    check(!ShardProtocol::decodeStatisticsRequest(request, query), "statistics request with oversized length");
+
+    std::string paths = ShardProtocol::encodeDocumentsResponse({"a"});
+    paths.replace(1, 4, "\x00\x00\x00\x10", 4);
+    std::vector<std::string> filePaths;
+    check(!ShardProtocol::decodeDocumentsResponse(paths, filePaths), "documents response with oversized count");
+}
+
+void testCorruption(std::mt19937& random) {
+    std::vector<std::string> messages = {
+        ShardProtocol::encodeStatisticsRequest("connection reset"),
+        ShardProtocol::encodeStatisticsResponse(randomStatistics(random)),
+        ShardProtocol::encodeSearchRequest("timeout", 10, randomStatistics(random)),
+        ShardProtocol::encodeSearchResponse({{1, 2.5f}, {7, 1.0f}}),
+        ShardProtocol::encodeDocumentsRequest({3, 1, 4}),
+        ShardProtocol::encodeDocumentsResponse({"/data/a.txt", "/data/b.txt"}),
+    };
+    for (int round = 0; round < 3000; ++round) {
+        std::string message = messages[random() % messages.size()];
+        int flips = 1 + random() % 4;
+        for (int i = 0; i < flips; ++i) {
+            message[random() % message.size()] = static_cast<char>(random() % 256);
+        }
+        check(decodeAll(message) <= 1, "corrupted message decodes as more than one type");
+        check(decodeAll(randomString(random, 64)) <= 1, "random bytes decode as more than one type");
+    }
+}
+
+#ifndef _WIN32
+
+/**
+ * @brief Writes raw bytes to a pipe, closes it and reads one frame back.
+ */
+bool readFrameFrom(const std::string& bytes, std::string& message) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return false;
+    }
+    bool written = write(fds[1], bytes.data(), bytes.size()) == static_cast<ssize_t>(bytes.size());
+    close(fds[1]);
+    bool framed = written && ShardProtocol::readFrame(fds[0], message);
+    close(fds[0]);
+    return framed;
+}
+
+void testFrames() {
+    std::string message = ShardProtocol::encodeDocumentsResponse({"/data/a.txt"});
+    int fds[2];
+    check(pipe(fds) == 0, "pipe");
+    check(ShardProtocol::writeFrame(fds[1], message), "write frame");
+    check(ShardProtocol::writeFrame(fds[1], std::string()), "write empty frame");
+    close(fds[1]);
+    std::string received;
+    check(ShardProtocol::readFrame(fds[0], received) && received == message, "frame round trip");
+    check(ShardProtocol::readFrame(fds[0], received) && received.empty(), "empty frame round trip");
+    check(!ShardProtocol::readFrame(fds[0], received), "end of input");
+    close(fds[0]);
+
+    check(!readFrameFrom(std::string("\x05\x00", 2), received), "truncated frame header");
+    check(!readFrameFrom(std::string("\x64\x00\x00\x00", 4) + "only ten b", received), "truncated frame body");
+    check(!readFrameFrom("\xff\xff\xff\xff", received), "oversized frame");
+    check(!readFrameFrom(std::string("\x01\x00\x00\x20", 4), received), "frame over the size limit");
+}
+
+#endif
+
+} // namespace
+
+int main() {
+    std::mt19937 random(42);
+    testRoundTrips(random);
+    testOversizedCounts();
+    testCorruption(random);
+#ifndef _WIN32
+    testFrames();
+#endif
+
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "ShardProtocol tests passed" << std::endl;
+    return 0;
+}